@@ -0,0 +1,620 @@
+#include <glm/glm.hpp>
+#include "gl.hpp"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glfw/glfw3.h>
+#include <string_view>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include <string>
+
+#include "log.hpp"
+
+#include "benchmark.hpp"
+#include "camera.hpp"
+#include "shader.hpp"
+#include "shader_batch.hpp"
+#include "shader_variants.hpp"
+#include "render_stats.hpp"
+#include "frame_arena.hpp"
+#include "frame_manager.hpp"
+#include "stream_buffer.hpp"
+#include "sprite_batch.hpp"
+#include "draw_data.hpp"
+#include "heap_stats.hpp"
+#include "meshlet.hpp"
+#include "gl_trace.hpp"
+#include "gl_replay.hpp"
+
+#include "render_3d_component.hpp"
+#include "earth.hpp"
+#include "cube.hpp"
+#include "crosshair.hpp"
+
+constexpr int CUBE_GRID = 16;           // The "cubes" scene is a CUBE_GRID x CUBE_GRID field of cubes
+constexpr float CUBE_SPACING = 3.0f;
+constexpr float ORBIT_PERIOD = 12.0f;   // Seconds the camera takes to circle the scene
+constexpr int SPRITE_FIELD = 100000;    // Sprites of the "sprites" scene
+constexpr int SPRITE_LAYERS = 8;
+
+/**
+* @brief One way of getting a context without a visible window
+*/
+struct headless_context {
+	const char* name;
+	int platform;
+	int api;
+};
+
+constexpr headless_context headless_contexts[] = {
+	{ "egl-surfaceless", GLFW_PLATFORM_NULL, GLFW_EGL_CONTEXT_API },
+	{ "osmesa", GLFW_PLATFORM_NULL, GLFW_OSMESA_CONTEXT_API },
+	{ "hidden-window", GLFW_ANY_PLATFORM, GLFW_NATIVE_CONTEXT_API },
+};
+
+/**
+* @brief Objects of a benchmark scene, owned by it
+*/
+struct benchmark_scene {
+	std::vector<object*> objects; // Update order
+
+	float orbit_radius = 10.0f;
+	float orbit_height = 2.0f;
+
+	~benchmark_scene() {
+		for (object* obj : objects) {
+			obj->deinit();
+			delete obj;
+		}
+	}
+};
+
+struct frame_sample {
+	double ms;
+	uint32_t draw_calls;
+	uint32_t draw_ranges;
+	uint32_t program_binds;
+	uint32_t vao_binds;
+	uint32_t texture_binds;
+	uint32_t uniform_uploads;
+	uint32_t heap_allocations; // Global new calls of the main thread
+};
+
+/**
+* @brief Main thread time spent building the programs, submitting plus waiting on the driver
+*/
+struct shader_setup {
+	double ms = 0.0;
+	size_t programs = 0;
+	size_t from_cache = 0; // Restored from the program cache instead of compiled
+};
+
+static void benchmark_error_callback(int error, const char* description) {
+	// Expected while falling back between context types
+	LOG_WARNING(CORE, "GLFW %d: %s", error, description);
+}
+
+static GLFWwindow* create_headless_context(const char*& context_name) {
+	glfwSetErrorCallback(benchmark_error_callback);
+
+	for (const headless_context& context : headless_contexts) {
+		if (context.platform != GLFW_ANY_PLATFORM && !glfwPlatformSupported(context.platform))
+			continue;
+
+		glfwInitHint(GLFW_PLATFORM, context.platform);
+
+		if (!glfwInit())
+			continue;
+
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+		glfwWindowHint(GLFW_CONTEXT_CREATION_API, context.api);
+
+		// The size does not matter, everything is drawn into the offscreen framebuffer
+		GLFWwindow* window = glfwCreateWindow(1, 1, "LimitedGL Benchmark", NULL, NULL);
+
+		if (window) {
+			glfwMakeContextCurrent(window);
+
+			// A GLEW built for GLX cannot load entry points on an EGL or OSMesa context, and a software fallback may be too old for the shaders
+			GLenum glew = glewInit();
+
+			if (glew == GLEW_OK && GLEW_VERSION_4_6) {
+				context_name = context.name;
+				return window;
+			}
+
+			if (glew != GLEW_OK) {
+				LOG_WARNING(CORE, "Failed to initialize GLEW on the %s context: %s", context.name, (const char*)glewGetErrorString(glew));
+			}
+			else {
+				LOG_WARNING(CORE, "The %s context is OpenGL %s, 4.6 is needed", context.name, (const char*)glGetString(GL_VERSION));
+			}
+
+			glfwMakeContextCurrent(NULL);
+			glfwDestroyWindow(window);
+		}
+
+		glfwTerminate();
+	}
+
+	return nullptr;
+}
+
+static void add_planet(benchmark_scene& scene, shader* object_shader) {
+	earth* planet = new earth(object_shader);
+	planet->m_transform->scale = glm::vec3(0.25f);
+
+	scene.objects.push_back(planet);
+}
+
+static void add_cube(benchmark_scene& scene, shader* object_shader, const glm::vec3& position) {
+	cube* c = new cube(object_shader);
+	c->m_transform->position = position;
+
+	scene.objects.push_back(c);
+}
+
+/**
+* @brief A screen covering grid of small untextured sprites spread over SPRITE_LAYERS layers
+*/
+static void add_sprite_field(benchmark_scene& scene) {
+	object* field = new object();
+	render_2d_component* render = (render_2d_component*)field->addComponent(new render_2d_component());
+
+	int columns = (int)glm::ceil(glm::sqrt((float)SPRITE_FIELD));
+	float cell = 2.0f / columns;
+
+	render->m_sprites.reserve(SPRITE_FIELD);
+
+	for (int i = 0; i < SPRITE_FIELD; ++i) {
+		sprite s;
+		s.position = glm::vec2(-1.0f + (i % columns + 0.5f) * cell, -1.0f + (i / columns + 0.5f) * cell);
+		s.size = glm::vec2(cell * 1.5f); // Overlapping, blending does real work
+		s.color = glm::vec4((i % 7) / 6.0f, (i % 5) / 4.0f, (i % 3) / 2.0f, 0.5f);
+		s.layer = (int16_t)(i % SPRITE_LAYERS);
+
+		render->m_sprites.push_back(s);
+	}
+
+	scene.objects.push_back(field);
+}
+
+/**
+* @brief Build a scene from the obj/ assets, false if the name is unknown
+*/
+static bool build_scene(std::string_view name, shader* object_shader, benchmark_scene& scene) {
+	if (name == "default") {
+		// What main() shows
+		scene.objects.push_back(new crosshair());
+
+		add_planet(scene, object_shader);
+		add_cube(scene, object_shader, glm::vec3(0.0f, 5.0f, 0.0f));
+	}
+	else if (name == "earth") {
+		add_planet(scene, object_shader);
+	}
+	else if (name == "cube") {
+		add_cube(scene, object_shader, glm::vec3(0.0f));
+		scene.orbit_radius = 6.0f;
+	}
+	else if (name == "cubes") {
+		// Many small draws
+		float extent = (CUBE_GRID - 1) * CUBE_SPACING * 0.5f;
+
+		for (int z = 0; z < CUBE_GRID; ++z) {
+			for (int x = 0; x < CUBE_GRID; ++x) {
+				add_cube(scene, object_shader, glm::vec3(x * CUBE_SPACING - extent, 0.0f, z * CUBE_SPACING - extent));
+			}
+		}
+
+		scene.orbit_radius = extent * 1.5f;
+		scene.orbit_height = extent * 0.5f;
+	}
+	else if (name == "sprites") {
+		// 2D batching
+		add_sprite_field(scene);
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
+
+static void write_json_string(FILE* file, const char* str) {
+	fputc('"', file);
+
+	for (; str && *str; ++str) {
+		if (*str == '"' || *str == '\\') {
+			fputc('\\', file);
+		}
+
+		fputc(*str, file);
+	}
+
+	fputc('"', file);
+}
+
+static double mean_of(const std::vector<frame_sample>& samples, uint32_t frame_sample::* counter) {
+	double sum = 0.0;
+
+	for (const frame_sample& sample : samples) {
+		sum += sample.*counter;
+	}
+
+	return samples.empty() ? 0.0 : sum / (double)samples.size();
+}
+
+static bool write_results(const benchmark_options& options, const char* context_name, const shader_setup& shaders, double culling_rate, const std::vector<frame_sample>& samples) {
+	FILE* file = fopen(options.output.c_str(), "w");
+	if (!file) {
+		LOG_ERROR(CORE, "Failed to write benchmark results %s", options.output.c_str());
+		return false;
+	}
+
+	std::vector<double> times;
+	double total = 0.0;
+
+	for (const frame_sample& sample : samples) {
+		times.push_back(sample.ms);
+		total += sample.ms;
+	}
+
+	std::sort(times.begin(), times.end());
+
+	size_t count = times.size();
+	double median = count % 2 ? times[count / 2] : (times[count / 2 - 1] + times[count / 2]) * 0.5;
+	double p99 = times[std::min(count - 1, (size_t)((count * 99 + 99) / 100) - 1)]; // Nearest rank
+
+	fprintf(file, "{\n");
+	fprintf(file, "\t\"scene\": ");
+	write_json_string(file, options.scene.c_str());
+	fprintf(file, ",\n\t\"frames\": %zu,\n\t\"warmup_frames\": %zu,\n\t\"timestep_ms\": %.4f,\n", count, options.warmup_frames, options.timestep * 1000.0);
+	fprintf(file, "\t\"width\": %d,\n\t\"height\": %d,\n\t\"context\": \"%s\",\n", options.width, options.height, context_name);
+	fprintf(file, "\t\"renderer\": ");
+	write_json_string(file, (const char*)glGetString(GL_RENDERER));
+	fprintf(file, ",\n\t\"version\": ");
+	write_json_string(file, (const char*)glGetString(GL_VERSION));
+	fprintf(file, ",\n\t\"frame_ms\": { \"min\": %.4f, \"median\": %.4f, \"p99\": %.4f, \"max\": %.4f, \"mean\": %.4f },\n",
+		times.front(), median, p99, times.back(), total / (double)count);
+	fprintf(file, "\t\"shaders\": { \"setup_ms\": %.4f, \"programs\": %zu, \"from_cache\": %zu },\n", shaders.ms, shaders.programs, shaders.from_cache);
+	fprintf(file, "\t\"meshlet_culling_per_ms\": %.1f,\n", culling_rate);
+	fprintf(file, "\t\"per_frame\": { \"draw_calls\": %.2f, \"draw_ranges\": %.2f, \"state_changes\": %.2f, \"program_binds\": %.2f, "
+		"\"vao_binds\": %.2f, \"texture_binds\": %.2f, \"uniform_uploads\": %.2f, \"heap_allocations\": %.2f },\n",
+		mean_of(samples, &frame_sample::draw_calls), mean_of(samples, &frame_sample::draw_ranges),
+		mean_of(samples, &frame_sample::program_binds) + mean_of(samples, &frame_sample::vao_binds) + mean_of(samples, &frame_sample::texture_binds),
+		mean_of(samples, &frame_sample::program_binds), mean_of(samples, &frame_sample::vao_binds),
+		mean_of(samples, &frame_sample::texture_binds), mean_of(samples, &frame_sample::uniform_uploads), mean_of(samples, &frame_sample::heap_allocations));
+	fprintf(file, "\t\"frame_arena\": { \"peak_bytes\": %zu, \"overflows\": %zu }\n", frame_arena::peak(), frame_arena::overflows());
+	fprintf(file, "}\n");
+
+	fclose(file);
+
+	LOG_INFO(CORE, "Benchmark %s: min %.3f ms, median %.3f ms, p99 %.3f ms over %zu frames, written to %s",
+		options.scene.c_str(), times.front(), median, p99, count, options.output.c_str());
+	LOG_INFO(CORE, "Shader setup %.3f ms, %zu of %zu program(s) from the program cache", shaders.ms, shaders.from_cache, shaders.programs);
+
+	if (culling_rate > 0.0) {
+		LOG_INFO(CORE, "Meshlet culling: %.0f meshlets/ms", culling_rate);
+	}
+
+	return true;
+}
+
+static int run_frames(const benchmark_options& options, const char* context_name) {
+	/* Offscreen framebuffer, a surfaceless context has no default one */
+	GLuint fbo, color, depth;
+
+	glGenRenderbuffers(1, &color);
+	glBindRenderbuffer(GL_RENDERBUFFER, color);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, options.width, options.height);
+
+	glGenRenderbuffers(1, &depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, depth);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, options.width, options.height);
+
+	glGenFramebuffers(1, &fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_ERROR(RENDER, "Benchmark framebuffer incomplete");
+		return 1;
+	}
+
+	glViewport(0, 0, options.width, options.height);
+
+	/* Shaders, the same variants main() uses */
+	shader_setup setup;
+	auto shader_start = std::chrono::steady_clock::now();
+
+	shader_variants object_variants = shader_variants("loaded_obj");
+	object_variants.add(GL_VERTEX_SHADER, "src/shaders/loaded_obj_vertex_shader.glsl", loaded_obj::layout::defines());
+	object_variants.add(GL_FRAGMENT_SHADER, "src/shaders/loaded_obj_fragment_shader.glsl");
+
+	shader* object_shader = object_variants.create(object_variants.keyword("TEXTURED") | object_variants.keyword("LIT"));
+
+	shader* sprite_shader = new shader();
+	sprite_shader->add(GL_VERTEX_SHADER, "src/shaders/sprite_vertex_shader.glsl", sprite_batch::layout::defines());
+	sprite_shader->add(GL_FRAGMENT_SHADER, "src/shaders/sprite_fragment_shader.glsl");
+
+	shader_batch shaders = shader_batch();
+	shaders.add(object_shader);
+	shaders.add(sprite_shader);
+	shaders.submit();
+
+	// Scene loading overlaps the compiles and is left out of the setup time
+	std::chrono::duration<double, std::milli> submit_time = std::chrono::steady_clock::now() - shader_start;
+
+	sprite_batch::init(sprite_shader); // Shut down by run_benchmark
+
+	/* Scene, textures load synchronously so every run sees the same mips */
+	benchmark_scene scene;
+	if (!build_scene(options.scene, object_shader, scene)) {
+		LOG_ERROR(CORE, "Unknown benchmark scene: %s", options.scene.c_str());
+		return 1;
+	}
+
+	for (object* obj : scene.objects) {
+		if (!obj->init()) {
+			LOG_ERROR(CORE, "Failed to init benchmark scene %s", options.scene.c_str());
+			return 1;
+		}
+	}
+
+	auto finish_start = std::chrono::steady_clock::now();
+
+	if (!shaders.finish()) {
+		LOG_ERROR(CORE, "Failed to link shaders");
+		return 1;
+	}
+
+	std::chrono::duration<double, std::milli> finish_time = std::chrono::steady_clock::now() - finish_start;
+
+	setup.ms = submit_time.count() + finish_time.count();
+	setup.programs = shaders.m_shaders.size();
+
+	for (shader* s : shaders.m_shaders) {
+		setup.from_cache += s->fromCache() ? 1 : 0;
+	}
+
+	// CPU meshlet culling throughput on the mesh with the most meshlets, 0 if the scene has none
+	const mesh* culled = nullptr;
+
+	for (object* obj : scene.objects) {
+		for (component* c : obj->m_components) {
+			render_3d_component* render = dynamic_cast<render_3d_component*>(c);
+
+			if (render && (!culled || render->m_mesh->m_meshlets.size() > culled->m_meshlets.size())) {
+				culled = render->m_mesh;
+			}
+		}
+	}
+
+	double culling_rate = culled ? benchmark_meshlet_culling(culled->m_meshlets) : 0.0;
+
+	camera view_camera = camera();
+	frustum view_frustum = frustum(65.0f, 0.1f, 100.0f);
+
+	glm::mat4 projection = glm::perspective(glm::radians(view_frustum.fovDegrees), (float)options.width / (float)options.height, view_frustum.near_plane, view_frustum.far_plane);
+
+	glEnable(GL_DEPTH_TEST);
+
+	stream_buffer uniform_stream(GL_UNIFORM_BUFFER, DRAW_STREAM_BYTES);
+	render_3d_component::uniformStream = &uniform_stream;
+
+	std::vector<frame_sample> samples;
+	samples.reserve(options.frames);
+
+	for (size_t frame = 0; frame < options.warmup_frames + options.frames; ++frame) {
+		float time = (float)frame * options.timestep;
+
+		render_stats::reset();
+		frame_manager::begin_frame();
+
+		uint64_t heap_start = heap_stats::thread_allocations();
+		auto start = std::chrono::steady_clock::now();
+
+		glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		// Scripted camera: orbit the scene, moving in and out so the LODs change
+		float angle = time * glm::two_pi<float>() / ORBIT_PERIOD;
+		float radius = scene.orbit_radius * (1.0f + 0.5f * glm::sin(time * 0.7f));
+
+		view_camera.m_transform->position = glm::vec3(glm::sin(angle) * radius, scene.orbit_height + glm::sin(time * 0.5f) * 1.5f, glm::cos(angle) * radius);
+		view_camera.lookAt(glm::vec3(0.0f));
+		view_camera.update(options.timestep);
+
+		render_3d_component::vp = projection * view_camera.getViewMatrix();
+		render_3d_component::lightPos = glm::vec3(2.0f, 25.0f, 25.0f);
+		render_3d_component::cameraPos = view_camera.m_transform->position;
+		render_3d_component::fovDegrees = view_frustum.fovDegrees;
+		render_3d_component::screenHeight = (float)options.height;
+		render_3d_component::beginFrame();
+
+		// One simulation step per frame, drawn at the step (transform_component::interpolation stays 1)
+		for (object* obj : scene.objects) {
+			obj->fixedUpdate(options.timestep);
+		}
+
+		for (object* obj : scene.objects) {
+			obj->update(options.timestep);
+		}
+
+		sprite_batch::flush();
+
+		frame_manager::end_frame();
+		glFinish(); // Count the GPU work in the frame it was submitted
+		gl_trace::end_frame();
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		uint32_t heap_allocations = (uint32_t)(heap_stats::thread_allocations() - heap_start);
+
+		if (frame >= options.warmup_frames) {
+			samples.push_back({ elapsed.count(), render_stats::draw_calls, render_stats::draw_ranges, render_stats::program_binds,
+				render_stats::vao_binds, render_stats::texture_binds, render_stats::uniform_uploads, heap_allocations });
+		}
+	}
+
+	render_3d_component::uniformStream = nullptr;
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteFramebuffers(1, &fbo);
+	glDeleteRenderbuffers(1, &color);
+	glDeleteRenderbuffers(1, &depth);
+
+	if (samples.empty()) {
+		LOG_ERROR(CORE, "No benchmark frames to report");
+		return 1;
+	}
+
+	return write_results(options, context_name, setup, culling_rate, samples) ? 0 : 1;
+}
+
+static GLFWwindow* open_headless(const char*& context_name) {
+	GLFWwindow* window = create_headless_context(context_name);
+
+	if (!window) {
+		LOG_ERROR(CORE, "Failed to create a headless OpenGL 4.6 context");
+	}
+
+	return window;
+}
+
+int run_benchmark(const benchmark_options& options) {
+	const char* context_name = nullptr;
+	GLFWwindow* window = open_headless(context_name);
+
+	if (!window)
+		return 1;
+
+	LOG_INFO(CORE, "Benchmarking %s on %s (%s context)", options.scene.c_str(), (const char*)glGetString(GL_RENDERER), context_name);
+
+	if (!options.gl_trace.empty()) {
+		gl_trace::start(options.gl_trace.c_str());
+	}
+
+	frame_arena::init();
+	frame_manager::init();
+
+	int result = run_frames(options, context_name);
+
+	sprite_batch::shutdown();
+	frame_manager::shutdown();
+	frame_arena::shutdown();
+
+	gl_trace::stop();
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+
+	logger::flush();
+
+	return result;
+} // run_benchmark
+
+/**
+* @brief Write blocks draw_data blocks per frame with one upload method, returns the seconds all frames took
+*/
+template <typename Upload>
+static double time_uploads(size_t blocks, size_t frames, Upload upload) {
+	draw_data data = { glm::mat4(1.0f), glm::vec3(1.0f), 0.2f, glm::vec3(0.0f), 0.5f };
+
+	auto start = std::chrono::steady_clock::now();
+
+	for (size_t frame = 0; frame < frames; ++frame) {
+		frame_manager::begin_frame();
+
+		for (size_t block = 0; block < blocks; ++block) {
+			data.model[3].x = (float)block; // Different data every block
+			upload(data);
+		}
+
+		frame_manager::end_frame();
+	}
+
+	glFinish();
+
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+	return elapsed.count();
+}
+
+int run_upload_benchmark(size_t blocks, size_t frames) {
+	const char* context_name = nullptr;
+	GLFWwindow* window = open_headless(context_name);
+
+	if (!window)
+		return 1;
+
+	LOG_INFO(CORE, "Benchmarking %zu uniform block uploads per frame on %s (%s context)", blocks, (const char*)glGetString(GL_RENDERER), context_name);
+
+	frame_arena::init();
+	frame_manager::init();
+
+	double mapped_seconds, sub_data_seconds;
+
+	{
+		stream_buffer stream(GL_UNIFORM_BUFFER, blocks * sizeof(draw_data));
+
+		mapped_seconds = time_uploads(blocks, frames, [&](const draw_data& data) {
+			stream.bind(DRAW_DATA_BINDING, stream.write(data));
+		});
+	}
+
+	{
+		GLuint ubo;
+		glGenBuffers(1, &ubo);
+		glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(draw_data), nullptr, GL_DYNAMIC_DRAW);
+
+		sub_data_seconds = time_uploads(blocks, frames, [&](const draw_data& data) {
+			glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(draw_data), &data);
+			glBindBufferBase(GL_UNIFORM_BUFFER, DRAW_DATA_BINDING, ubo);
+		});
+
+		glDeleteBuffers(1, &ubo);
+	}
+
+	double count = (double)(blocks * frames);
+	double megabytes = count * sizeof(draw_data) / (1024.0 * 1024.0);
+
+	LOG_INFO(CORE, "Persistent mapped: %.1f ns per block, %.1f MB/s", mapped_seconds * 1e9 / count, megabytes / mapped_seconds);
+	LOG_INFO(CORE, "glBufferSubData:   %.1f ns per block, %.1f MB/s", sub_data_seconds * 1e9 / count, megabytes / sub_data_seconds);
+
+	frame_manager::shutdown();
+	frame_arena::shutdown();
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+
+	logger::flush();
+
+	return 0;
+} // run_upload_benchmark
+
+int run_gl_replay(const char* path) {
+	const char* context_name = nullptr;
+	GLFWwindow* window = open_headless(context_name);
+
+	if (!window)
+		return 1;
+
+	LOG_INFO(CORE, "Replaying %s on %s (%s context)", path, (const char*)glGetString(GL_RENDERER), context_name);
+
+	gl_trace_report report;
+	bool replayed = replay_gl_trace(path, report);
+
+	if (replayed) {
+		log_gl_trace_report(report);
+	}
+
+	glfwDestroyWindow(window);
+	glfwTerminate();
+
+	logger::flush();
+
+	return replayed ? 0 : 1;
+} // run_gl_replay
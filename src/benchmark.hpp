@@ -0,0 +1,66 @@
+#ifndef _BENCHMARK_HPP
+#define _BENCHMARK_HPP
+
+#include <cstddef>
+#include <string>
+
+/**
+* @brief Settings of a headless benchmark run
+*/
+struct benchmark_options {
+	std::string scene = "default";        // default (what main shows), earth, cube, cubes (a field of 256 cubes) or sprites (100k sprites)
+	size_t frames = 600;                  // Measured frames
+	size_t warmup_frames = 30;            // Rendered first and left out of the results
+	float timestep = 1.0f / 60.0f;        // Seconds every frame advances the scene and camera path
+	int width = 1920;                     // Size of the offscreen framebuffer
+	int height = 1080;
+	std::string output = "benchmark.json";
+	std::string gl_trace;                 // Also trace every GL call to this file when set (see gl_trace)
+};
+
+/**
+ * Render a named scene without a window and write frame time and draw statistics as JSON
+ *
+ * The context is created headless (GLFW null platform with EGL surfaceless, then
+ * OSMesa, then a hidden window as the last resort, a context GLEW cannot load or
+ * older than OpenGL 4.6 moves on to the next) and the scene is drawn into an
+ * offscreen framebuffer. Every frame advances the objects and a scripted camera
+ * orbit by the fixed timestep and ends with glFinish, so a frame time covers the
+ * GPU work and two runs of the same build draw exactly the same frames.
+ *
+ * The results also hold the main thread time spent building the shader programs and
+ * how many came from the program cache: a run after deleting cache/shaders times a
+ * cold start, the run after it a warm one. The CPU meshlet culling rate of the
+ * scene's largest mesh is measured once before the frames.
+ *
+ * @param options Scene, frame count and output path
+ *
+ * @return int Process exit code, 0 on success
+ */
+int run_benchmark(const benchmark_options& options);
+
+/**
+ * Time streaming per draw uniform blocks through a stream_buffer against glBufferSubData, headless
+ *
+ * Every frame writes the blocks one by one and binds each, once as a memcpy into the
+ * persistently mapped ring with glBindBufferRange, once as glBufferSubData into a
+ * single uniform buffer with glBindBufferBase. The time per block and the throughput
+ * of both are logged.
+ *
+ * @param blocks draw_data blocks written per frame
+ * @param frames Measured frames per method
+ *
+ * @return int Process exit code, 0 on success
+ */
+int run_upload_benchmark(size_t blocks, size_t frames);
+
+/**
+ * Replay a GL trace on a headless context and log how long its calls took
+ *
+ * @param path The trace written by gl_trace
+ *
+ * @return int Process exit code, 0 on success
+ */
+int run_gl_replay(const char* path);
+
+#endif // _BENCHMARK_HPP
@@ -6,9 +6,11 @@ struct object; // Forward decl
 struct component {
 	object* m_object;
 
-	virtual void update(float dt) {}
+	virtual void update(float /* dt */) {}      // Every rendered frame
+	virtual void fixedUpdate(float /* dt */) {} // Every simulation step, dt is fixed
 
 	component() : m_object(nullptr) {}
+	virtual ~component() {}
 };
 
 #endif // _COMPONENT_BASE_HPP
\ No newline at end of file
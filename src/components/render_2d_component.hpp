@@ -3,27 +3,28 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
+#include <vector>
 
 #include "component_base.hpp"
-#include "shader.hpp"
-#include "material.hpp"
-#include "mesh.hpp"
+#include "sprite_batch.hpp"
+#include "pool.hpp"
 
-class render_2d_component : public component {
+/**
+* @brief Sprites handed to sprite_batch every frame, drawn together with every other 2D component by sprite_batch::flush()
+*/
+class render_2d_component : public component, public pooled<render_2d_component, memory_tag::COMPONENTS> {
 public:
-	material* m_mat;
-	mesh* m_mesh;
+	std::vector<sprite> m_sprites;
+	bool m_visible = true;
 
-	render_2d_component(shader* linked_shader, texture* linked_texture) {
-		this->m_mat = new material(linked_shader, linked_texture);
-		this->m_mesh = new mesh();
-	}
+	void update(float /* dt */) override {
+		if (!m_visible)
+			return;
 
-	~render_2d_component() {
-		delete m_mat;
-		delete m_mesh;
+		for (const sprite& s : m_sprites) {
+			sprite_batch::submit(s);
+		}
 	}
 }; // render_component
 
-#endif // _RENDER_2D_COMPONENT_HPP
\ No newline at end of file
+#endif // _RENDER_2D_COMPONENT_HPP
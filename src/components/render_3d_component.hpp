@@ -8,16 +8,34 @@
 #include "material.hpp"
 #include "mesh.hpp"
 #include "texture.hpp"
+#include "texture_streamer.hpp"
+#include "profiler.hpp"
+#include "pool.hpp"
+#include "render_stats.hpp"
+#include "stream_buffer.hpp"
+#include "draw_data.hpp"
 
-class render_3d_component : public component {
+class render_3d_component : public component, public pooled<render_3d_component, memory_tag::COMPONENTS> {
 public:
 	material* m_mat;
 	mesh* m_mesh;
 
+	glm::mat4 m_model = glm::mat4(1.0f); // Set by the object's transform_component
+	size_t m_lod = 0; // Level of detail drawn, see selectLod()
+
 	inline static glm::mat4 vp;
 	inline static glm::vec3 lightPos;
 	inline static glm::vec3 cameraPos;
 
+	inline static float fovDegrees = 65.0f;
+	inline static float screenHeight = 1080.0f;
+	inline static texture_streamer* streamer = nullptr;
+	inline static stream_buffer* uniformStream = nullptr; // draw_data and frame_data blocks, see beginFrame()
+
+	inline static float lodPixelError = 1.0f;   // Largest on-screen deviation (pixels) a coarser LOD may introduce
+	inline static float lodHysteresis = 0.25f;  // A coarser LOD is only picked below (1 - lodHysteresis) of the limit
+	inline static bool cullMeshlets = true;     // Skip back-facing and off-screen meshlets on the CPU
+
 	render_3d_component(shader* linked_shader, texture* linked_texture) {
 		this->m_mat = new material(linked_shader, linked_texture);
 		this->m_mesh = new mesh();
@@ -28,20 +46,115 @@ public:
 		delete m_mesh;
 	}
 
-	void update(float dt) override {
-		m_mat->set_uniform("vp", vp);
+	/**
+	* @brief Write the frame_data block (vp, lightPos, cameraPos) and bind it, once per frame before the objects update
+	*/
+	static void beginFrame() {
+		if (!uniformStream)
+			return;
+
+		frame_data data = { vp, lightPos, 0.0f, cameraPos, 0.0f };
+		uniformStream->bind(FRAME_DATA_BINDING, uniformStream->write(data));
+		render_stats::uniform_uploads += 1;
+	}
+
+	void update(float /* dt */) override {
+		float screen_size = projectedSize();
+
+		// Texture streaming feedback
+		if (streamer) {
+			if (m_mat->m_tex) {
+				streamer->report(m_mat->m_tex, screen_size);
+			}
 
-		m_mat->set_uniform("ambient_strength", 0.2f);
-		m_mat->set_uniform("specular_strength", 0.5f);
-		m_mat->set_uniform("light_pos", lightPos); //glm::vec3(2.0f, 25.0f, 25.0f)
-		m_mat->set_uniform("view_pos", cameraPos);
+			for (texture* tex : m_mat->m_textures) {
+				if (tex) {
+					streamer->report(tex, screen_size);
+				}
+			}
+		}
+
+		selectLod(screen_size);
 
 		render();
 	}
 
+	/**
+	* @brief Approximate on-screen diameter of the mesh bounding sphere in pixels
+	*/
+	float projectedSize() const {
+		glm::vec3 center = glm::vec3(m_model * glm::vec4(m_mesh->m_center, 1.0f));
+		float scale = glm::max(glm::length(glm::vec3(m_model[0])), glm::max(glm::length(glm::vec3(m_model[1])), glm::length(glm::vec3(m_model[2]))));
+		float radius = m_mesh->m_radius * scale;
+		float distance = glm::length(center - cameraPos);
+
+		if (distance <= radius)
+			return screenHeight; // Camera is inside the bounds
+
+		return glm::min(radius * screenHeight / (distance * glm::tan(glm::radians(fovDegrees) * 0.5f)), screenHeight);
+	}
+
+	/**
+	* @brief Pick the coarsest LOD whose error stays under lodPixelError on screen
+	*
+	* Switching to a coarser level needs the error to be lodHysteresis below the limit,
+	* switching back happens at the limit, so a level does not flicker at the boundary.
+	*/
+	void selectLod(float screen_size) {
+		size_t count = m_mesh->lod_count();
+		if (count < 2 || m_mesh->m_radius <= 0.0f) {
+			m_lod = 0;
+			return;
+		}
+
+		// Model units to pixels, the same for every level
+		float pixels_per_unit = screen_size / (2.0f * m_mesh->m_radius);
+
+		m_lod = glm::min(m_lod, count - 1);
+
+		while (m_lod > 0 && m_mesh->lod_error(m_lod) * pixels_per_unit > lodPixelError) {
+			--m_lod;
+		}
+
+		while (m_lod + 1 < count && m_mesh->lod_error(m_lod + 1) * pixels_per_unit <= lodPixelError * (1.0f - lodHysteresis)) {
+			++m_lod;
+		}
+	}
+
 	void render() { //FIXME: Something wrong happens when rendering multiple objects
+		PROFILE_SCOPE("Draw");
+
 		m_mat->use();
-		m_mesh->draw(m_mat);
+
+		// Per draw block: a memcpy into the persistently mapped stream and a range bind
+		if (uniformStream) {
+			draw_data data = { m_model, m_mesh->m_encoding.scale, 0.2f, m_mesh->m_encoding.offset, 0.5f };
+			uniformStream->bind(DRAW_DATA_BINDING, uniformStream->write(data));
+			render_stats::uniform_uploads += 1;
+		}
+
+		if (!cullMeshlets || m_mesh->m_meshlets.empty()) {
+			m_mesh->draw(m_mat, m_lod);
+			return;
+		}
+
+		// Cull in model space: planes of the full transform, camera moved into the model
+		frustum_planes planes = frustum_planes::extract(vp * m_model);
+		glm::vec3 camera = glm::vec3(glm::inverse(m_model) * glm::vec4(cameraPos, 1.0f));
+
+		for (size_t index = 0; index < m_mesh->m_submeshes.size(); ++index) {
+			const mesh_lod& level = m_mesh->submesh_lod(index, m_lod);
+
+			draw_ranges ranges; // Frame arena
+			ranges.reserve(level.meshlet_count);
+
+			{
+				PROFILE_SCOPE("Meshlet culling");
+				cull_meshlets(m_mesh->m_meshlets.data() + level.first_meshlet, level.meshlet_count, planes, camera, ranges);
+			}
+
+			m_mesh->draw_submesh(m_mat, index, ranges);
+		}
 	}
 }; // render_component
 
@@ -5,8 +5,9 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include "component_base.hpp"
+#include "pool.hpp"
 
-struct transform_component : public component { // 128 bytes
+struct transform_component : public component, public pooled<transform_component, memory_tag::COMPONENTS> { // 128 bytes
 	glm::vec3 position;
 	glm::quat rotation;
 	glm::vec3 scale;
@@ -17,10 +18,30 @@ struct transform_component : public component { // 128 bytes
 
 	float m_degrees = 0.0f;
 
-	transform_component() : position(0.0f), rotation(glm::identity<glm::quat>()), scale(1.0f) {}
+	// State at the start of the current simulation step
+	glm::vec3 prevPosition;
+	glm::quat prevRotation;
+	glm::vec3 prevScale;
+
+	inline static float interpolation = 1.0f; // Where rendering is between prev* (0) and the current state (1)
+
+	transform_component() : position(0.0f), rotation(glm::identity<glm::quat>()), scale(1.0f), prevPosition(0.0f), prevRotation(glm::identity<glm::quat>()), prevScale(1.0f) {}
 
 	void update(float dt) override;
 
+	void fixedUpdate(float /* dt */) override {
+		snapshot();
+	}
+
+	/**
+	* @brief Make the current state the previous one, also to place an object without blending from where it was
+	*/
+	void snapshot() {
+		prevPosition = position;
+		prevRotation = rotation;
+		prevScale = scale;
+	}
+
 	/**
 	* @brief Get the position matrix (local)
 	*/
@@ -40,6 +61,17 @@ struct transform_component : public component { // 128 bytes
 		return glm::translate(glm::mat4(1.0f), position) * getRotationMatrix() * getScaleMatrix();
 	}
 
+	inline glm::vec3 getInterpolatedPosition() const {
+		return glm::mix(prevPosition, position, interpolation);
+	}
+
+	/**
+	* @brief Model matrix blended between the last two simulation steps by interpolation
+	*/
+	inline glm::mat4 getInterpolatedModelMatrix() const {
+		return glm::translate(glm::mat4(1.0f), getInterpolatedPosition()) * glm::mat4_cast(glm::slerp(prevRotation, rotation, interpolation)) * glm::scale(glm::mat4(1.0f), glm::mix(prevScale, scale, interpolation));
+	}
+
 	void moveForward(float speed, float deltaTime) {
 		position += localFront * speed * deltaTime;
 	}
@@ -56,7 +56,7 @@ struct camera : public object {
 	* @brief Get the camera view matrix
 	*/
 	inline glm::mat4 getViewMatrix() const {
-		return getCameraRotation() * m_transform->getPositionMatrix();
+		return getCameraRotation() * glm::translate(glm::mat4(1.0f), -m_transform->getInterpolatedPosition());
 	}
 
 	/**
@@ -86,6 +86,20 @@ struct camera : public object {
 				pitch = -89.9f;
 		}
 	}
+
+	/**
+	* @brief Turn the camera towards a point (inverse of getCameraRotation's forward vector)
+	*/
+	void lookAt(const glm::vec3& target) {
+		glm::vec3 direction = target - m_transform->position;
+		if (glm::length(direction) <= 0.0f)
+			return;
+
+		direction = glm::normalize(direction);
+
+		pitch = glm::degrees(-glm::asin(direction.y));
+		yaw = glm::degrees(glm::atan(direction.x, -direction.z));
+	}
 }; // camera
 
 #endif // _CAMERA_HPP
\ No newline at end of file
@@ -2,71 +2,30 @@
 #define _CROSSHAIR_HPP
 
 #include "object.hpp"
-#include "shader.hpp"
 #include "render_2d_component.hpp"
+#include "pool.hpp"
 
-class crosshair : public object {
+class crosshair : public object, public pooled<crosshair, memory_tag::OBJECTS> {
 public:
 	render_2d_component* m_render;
-	bool uploaded = false;
 
-	crosshair(shader* linked_shader) {
-		m_render = (render_2d_component*)addComponent(new render_2d_component(linked_shader, nullptr));
-		m_render->m_mat->m_tex = nullptr; // No texture
+	crosshair() {
+		m_render = (render_2d_component*)addComponent(new render_2d_component());
 	}
 
 	bool init() override {
-		// Define crosshair vertices
-		float vertices[] {
-			-.025f, .002f,  0.0f,
-			.025f, .002f,  0.0f,
-			.025f,  -.002f, 0.0f,
-			-.025f, .002f,  0.0f,
-			.025f, -.002f, 0.0f,
-			-.025f, -.002f, 0.0f,
-			
-			-.002f, .04f,  0.0f,
-			.002f, .04f,  0.0f,
-			.002f,  -.04f, 0.0f,
-			-.002f, .04f,  0.0f,
-			.002f, -.04f, 0.0f,
-			-.002f, -.04f, 0.0f,
-		};
+		// Two bars in normalized device coordinates, untextured, half transparent white
+		sprite bar;
+		bar.color = glm::vec4(1.0f, 1.0f, 1.0f, 0.5f);
 
-		m_render->m_mesh->load_mesh(vertices, 12);
+		bar.size = glm::vec2(.05f, .004f);
+		m_render->m_sprites.push_back(bar);
 
-		// Set attribute locations
-		m_render->m_mat->set_attribute(vertexAttr(vertex_attr::VERTEX));
+		bar.size = glm::vec2(.004f, .08f);
+		m_render->m_sprites.push_back(bar);
 
 		return true;
 	}
-
-	void update(float dt) override {
-		m_render->m_mat->use();
-
-		if (!uploaded) {
-			// Generate the vertex array object
-			glGenVertexArrays(1, &m_render->m_mesh->vao);
-			glBindVertexArray(m_render->m_mesh->vao);
-
-			glGenBuffers(1, &m_render->m_mesh->vbo);
-			glBindBuffer(GL_ARRAY_BUFFER, m_render->m_mesh->vbo);
-			glBufferData(GL_ARRAY_BUFFER, m_render->m_mesh->m_vertices.size() * sizeof(vertex), m_render->m_mesh->m_vertices.data(), GL_STATIC_DRAW);
-
-			for (auto& [name, loc] : m_render->m_mat->m_attributes) {
-				if (name == vertexAttr(vertex_attr::VERTEX)) {
-					glEnableVertexAttribArray(loc);
-					glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, m_pos));
-				}
-			}
-
-			uploaded = true;
-		}
-
-		glBindVertexArray(m_render->m_mesh->vbo);
-
-		glDrawArrays(GL_TRIANGLES, 0, m_render->m_mesh->m_vertices.size());
-	}
 };
 
-#endif // _CROSSHAIR_HPP
\ No newline at end of file
+#endif // _CROSSHAIR_HPP
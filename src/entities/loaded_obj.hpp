@@ -1,14 +1,17 @@
 #ifndef _BASE_OBJECTS_HPP
 #define _BASE_OBJECTS_HPP
 
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <string>
+#include <vector>
 #include <stdexcept>
 #include <cstdio>
 
-#include "scolor.hpp"
+#include "log.hpp"
 #include "object.hpp"
+#include "mesh_cooked.hpp"
 #include "vertex.hpp"
+#include "vertex_layout.hpp"
 #include "shader.hpp"
 #include "texture.hpp"
 #include "render_3d_component.hpp"
@@ -25,6 +28,9 @@ public:
 
 	render_3d_component* m_render;
 
+	using layout = vertex_layout_quantized; // Colour is one value per mesh unless the vertices differ (layout_color)
+	using layout_color = vertex_layout_quantized_color;
+
 	/**
 	* Create a new loaded_obj object
 	*
@@ -33,39 +39,77 @@ public:
 	* @param linked_shader Object shader
 	*/
 	loaded_obj(std::string of, std::string tf, shader* linked_shader) : object_file(of), texture_file(tf), objBaseDir(object_file.substr(0, object_file.find('/'))) {
-		if (!linked_shader->m_isLinked) { throw std::invalid_argument("You must link the shader before using it"); }
+		if (!linked_shader->m_isLinked && !linked_shader->m_isPending) { throw std::invalid_argument("You must link or submit the shader before using it"); }
 
 		m_render = (render_3d_component*)addComponent(new render_3d_component(linked_shader, new texture()));
+		m_render->m_mesh->set_layout<layout, layout_color>();
 	}
 
 	bool init() override {
-		// Load OBJ file
-		if (!load_obj(objBaseDir.c_str(), object_file.c_str(), m_render->m_mesh)) {
-			printf(RED("Failed to load obj file\n").c_str());
+		// Load OBJ file (or a mesh cooked by import_obj_streaming)
+		bool cooked = object_file.size() > 6 && object_file.compare(object_file.size() - 6, 6, ".cmesh") == 0;
+
+		if (cooked ? !load_cooked_mesh(object_file.c_str(), m_render->m_mesh) : !load_obj(objBaseDir.c_str(), object_file.c_str(), m_render->m_mesh)) {
+			LOG_ERROR(MESH, "Failed to load obj file");
 			return false;
 		}
 
 		// Load and Bind textures
-		if (!load_texture(texture_file.c_str(), m_render->m_mat->m_tex)) {
-			printf(RED("Failed to load texture: %s\n").c_str(), texture_file);
+		if (!add_texture(texture_file, m_render->m_mat->m_tex)) {
 			return false;
 		}
 
-		// Set attribute locations
-		m_render->m_mat->set_attribute(vertexAttr(vertex_attr::VERTEX));
-		m_render->m_mat->set_attribute(vertexAttr(vertex_attr::COLOR));
-		m_render->m_mat->set_attribute(vertexAttr(vertex_attr::TEXCOORD));
-		m_render->m_mat->set_attribute(vertexAttr(vertex_attr::NORMAL));
+		// Materials with their own diffuse map get their own texture, the rest use texture_file
+		const std::vector<mesh_material>& materials = m_render->m_mesh->m_materials;
+		m_render->m_mat->m_textures.assign(materials.size(), nullptr);
+
+		for (size_t i = 0; i < materials.size(); ++i) {
+			if (materials[i].diffuse_texture.empty())
+				continue;
+
+			texture* tex = new texture();
+			if (!add_texture(objBaseDir + "/" + materials[i].diffuse_texture, tex)) {
+				delete tex;
+				continue;
+			}
+
+			m_render->m_mat->m_textures[i] = tex;
+		}
 
 		return true;
 	} // init
 
 	void deinit() override {
-		// Cleanup texture
+		// Cleanup textures
+		for (texture* tex : m_render->m_mat->m_textures) {
+			delete tex;
+		}
+
+		m_render->m_mat->m_textures.clear();
+
 		if (m_render->m_mat->m_tex) {
 			delete m_render->m_mat->m_tex;
 		}
 	} // deinit
+
+private:
+	/**
+	* @brief Load a texture, streamed in the background when a streamer is available
+	*/
+	static bool add_texture(const std::string& file, texture* tex) {
+		if (render_3d_component::streamer) {
+			if (!render_3d_component::streamer->add(file.c_str(), tex)) {
+				LOG_ERROR(TEXTURE, "Failed to stream texture: %s", file.c_str());
+				return false;
+			}
+		}
+		else if (!load_texture(file.c_str(), tex)) {
+			LOG_ERROR(TEXTURE, "Failed to load texture: %s", file.c_str());
+			return false;
+		}
+
+		return true;
+	} // add_texture
 }; // loaded_obj
 
 #endif // _BASE_OBJECTS_HPP
@@ -1,18 +1,19 @@
 #ifndef _CUBE_OBJ_HPP
 #define _CUBE_OBJ_HPP
 
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <string>
 #include <stdexcept>
 #include <cstdio>
 
 #include "loaded_obj.hpp"
 #include "transform_component.hpp"
+#include "pool.hpp"
 
 /**
 * @brief A loaded object from an OBJ file with a texture
 */
-class cube : public loaded_obj {
+class cube : public loaded_obj, public pooled<cube, memory_tag::OBJECTS> {
 public:
 	transform_component* m_transform;
 
@@ -25,12 +26,11 @@ public:
 		m_transform = (transform_component*)addComponent(new transform_component());
 	}
 
-	void update(float dt) override {
-		for (auto c : m_components) {
-			c->update(dt);
-		}
+	void fixedUpdate(float dt) override {
+		loaded_obj::fixedUpdate(dt);
 
-		m_transform->rotation = glm::angleAxis(glm::radians(m_transform->m_degrees + (dt * 10)), glm::vec3(0, 1, 0));
+		m_transform->m_degrees += dt * 10.0f;
+		m_transform->rotation = glm::angleAxis(glm::radians(m_transform->m_degrees), glm::vec3(0, 1, 0));
 	}
 }; // cube
 
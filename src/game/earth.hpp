@@ -1,18 +1,19 @@
 #ifndef _EARTH_OBJ_HPP
 #define _EARTH_OBJ_HPP
 
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <string>
 #include <stdexcept>
 #include <cstdio>
 
 #include "loaded_obj.hpp"
 #include "transform_component.hpp"
+#include "pool.hpp"
 
 /**
 * @brief A loaded object from an OBJ file with a texture
 */
-class earth : public loaded_obj {
+class earth : public loaded_obj, public pooled<earth, memory_tag::OBJECTS> {
 public:
 	transform_component* m_transform;
 
@@ -25,7 +26,9 @@ public:
 		m_transform = (transform_component*)addComponent(new transform_component());
 	}
 
-	void update(float dt) override {
+	void fixedUpdate(float dt) override {
+		loaded_obj::fixedUpdate(dt);
+
 		// Accumulate rotation over time
 		m_transform->m_degrees += dt * 10.0f;
 
@@ -33,10 +36,6 @@ public:
 		glm::quat tilt = glm::angleAxis(glm::radians(-90.0f), glm::vec3(1, 0, 0));
 		glm::quat spin = glm::angleAxis(glm::radians(m_transform->m_degrees), glm::vec3(0, 1, 0));
 		m_transform->rotation = spin * tilt;
-
-		for (auto c : m_components) {
-			c->update(dt);
-		}
 	}
 
 
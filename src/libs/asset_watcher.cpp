@@ -0,0 +1,153 @@
+#include <filesystem>
+#include <chrono>
+#include <cstdio>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <poll.h>
+#endif
+
+#include "log.hpp"
+#include "shader_preprocessor.hpp"
+#include "asset_watcher.hpp"
+
+constexpr int WATCHER_INTERVAL_MS = 100; // How often the thread checks for shutdown (and polls without inotify)
+
+asset_watcher::asset_watcher(const char* root) : m_root(shader_preprocessor::normalize(root)), m_stop(false) {
+#ifdef __linux__
+	m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+	if (m_fd < 0) {
+		LOG_ERROR(CORE, "Failed to start inotify, %s will not be watched", m_root.c_str());
+		return;
+	}
+
+	watch(m_root);
+
+	std::error_code ec;
+	for (auto& entry : std::filesystem::recursive_directory_iterator(m_root, ec)) {
+		if (entry.is_directory()) {
+			watch(shader_preprocessor::normalize(entry.path().generic_string()));
+		}
+	}
+#else
+	scan(false);
+#endif
+
+	LOG_DEBUG(CORE, "Watching %s for changes", m_root.c_str());
+
+	m_thread = std::thread(&asset_watcher::run, this);
+}
+
+asset_watcher::~asset_watcher() {
+	m_stop = true;
+
+	if (m_thread.joinable()) {
+		m_thread.join();
+	}
+
+#ifdef __linux__
+	if (m_fd >= 0) {
+		close(m_fd);
+	}
+#endif
+}
+
+std::vector<std::string> asset_watcher::poll() {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	std::vector<std::string> files(m_changed.begin(), m_changed.end());
+	m_changed.clear();
+
+	return files;
+} // poll
+
+void asset_watcher::changed(const std::string& path) {
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	m_changed.insert(shader_preprocessor::normalize(path));
+} // changed
+
+#ifdef __linux__
+
+void asset_watcher::watch(const std::string& directory) {
+	int wd = inotify_add_watch(m_fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+	if (wd < 0) {
+		LOG_ERROR(CORE, "Failed to watch %s", directory.c_str());
+		return;
+	}
+
+	m_watches[wd] = directory;
+} // watch
+
+void asset_watcher::run() {
+	alignas(inotify_event) char buffer[4096];
+
+	while (!m_stop) {
+		pollfd pfd = { m_fd, POLLIN, 0 };
+
+		if (::poll(&pfd, 1, WATCHER_INTERVAL_MS) <= 0)
+			continue;
+
+		ssize_t length;
+		while ((length = read(m_fd, buffer, sizeof(buffer))) > 0) {
+			for (char* ptr = buffer; ptr < buffer + length;) {
+				const inotify_event* event = (const inotify_event*)ptr;
+				ptr += sizeof(inotify_event) + event->len;
+
+				auto it = m_watches.find(event->wd);
+				if (it == m_watches.end() || event->len == 0)
+					continue;
+
+				std::string path = it->second + "/" + event->name;
+
+				if (event->mask & IN_ISDIR) {
+					if (event->mask & (IN_CREATE | IN_MOVED_TO)) {
+						watch(path); // New sub directory
+					}
+				}
+				else if (event->mask & (IN_CLOSE_WRITE | IN_MOVED_TO)) {
+					changed(path);
+				}
+			}
+		}
+	}
+} // run
+
+#else
+
+void asset_watcher::scan(bool report) {
+	std::error_code ec;
+
+	for (auto& entry : std::filesystem::recursive_directory_iterator(m_root, ec)) {
+		if (!entry.is_regular_file())
+			continue;
+
+		std::string path = entry.path().generic_string();
+		auto time = entry.last_write_time(ec);
+
+		auto it = m_times.find(path);
+		if (it == m_times.end()) {
+			m_times.emplace(path, time);
+
+			if (report) {
+				changed(path);
+			}
+		}
+		else if (it->second != time) {
+			it->second = time;
+			changed(path);
+		}
+	}
+} // scan
+
+void asset_watcher::run() {
+	while (!m_stop) {
+		std::this_thread::sleep_for(std::chrono::milliseconds(WATCHER_INTERVAL_MS));
+		scan(true);
+	}
+} // run
+
+#endif
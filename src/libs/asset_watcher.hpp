@@ -0,0 +1,56 @@
+#ifndef _ASSET_WATCHER_HPP
+#define _ASSET_WATCHER_HPP
+
+#include <unordered_map>
+#include <unordered_set>
+#include <filesystem>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+/**
+* @brief Watches a directory tree for changed files on a background thread
+*
+* Uses inotify on Linux (only files that were closed after writing or renamed
+* into place are reported, so half written files are never seen) and falls back
+* to polling modification times elsewhere.
+*/
+class asset_watcher {
+public:
+	std::string m_root;
+
+	asset_watcher(const char* root);
+	~asset_watcher();
+
+	asset_watcher(asset_watcher&) = delete; // No copy constructor
+	asset_watcher& operator=(const asset_watcher&) = delete; // No copy assignment
+
+	/**
+	* @brief Files changed since the last call (normalised paths, no duplicates)
+	*/
+	std::vector<std::string> poll();
+
+private:
+	std::unordered_set<std::string> m_changed; // Guarded by m_mutex
+	std::mutex m_mutex;
+	std::atomic<bool> m_stop;
+	std::thread m_thread;
+
+#ifdef __linux__
+	int m_fd;
+	std::unordered_map<int, std::string> m_watches; // Watch descriptor -> directory
+
+	void watch(const std::string& directory);
+#else
+	std::unordered_map<std::string, std::filesystem::file_time_type> m_times;
+
+	void scan(bool report);
+#endif
+
+	void run();
+	void changed(const std::string& path);
+}; // asset_watcher
+
+#endif // _ASSET_WATCHER_HPP
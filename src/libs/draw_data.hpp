@@ -0,0 +1,38 @@
+#ifndef _DRAW_DATA_HPP
+#define _DRAW_DATA_HPP
+
+#include <glm/glm.hpp>
+#include "gl.hpp"
+
+constexpr GLuint DRAW_DATA_BINDING = 0;  // Uniform block binding of draw_data
+constexpr GLuint FRAME_DATA_BINDING = 1; // Uniform block binding of frame_data
+
+constexpr size_t DRAW_STREAM_BYTES = 256 * 1024; // Per frame uniform data of the renderer (grows when a frame needs more)
+
+/**
+* @brief Per draw uniform block (std140, must match src/shaders/include/draw_data.glsl)
+*/
+struct draw_data {
+	glm::mat4 model;
+	glm::vec3 pos_scale;
+	float ambient_strength;
+	glm::vec3 pos_offset;
+	float specular_strength;
+};
+
+static_assert(sizeof(draw_data) == 96, "draw_data must match the std140 layout of the shader block");
+
+/**
+* @brief Per frame uniform block (std140, must match src/shaders/include/draw_data.glsl)
+*/
+struct frame_data {
+	glm::mat4 vp;
+	glm::vec3 light_pos;
+	float pad0;
+	glm::vec3 view_pos;
+	float pad1;
+};
+
+static_assert(sizeof(frame_data) == 96, "frame_data must match the std140 layout of the shader block");
+
+#endif // _DRAW_DATA_HPP
@@ -0,0 +1,30 @@
+#include <cmath>
+
+#include "log.hpp"
+#include "fixed_clock.hpp"
+
+// The first frame runs one step, so every transform has a previous state to blend from
+fixed_clock::fixed_clock(double step, int max_steps) : m_step(step), m_max_steps(max_steps), m_accumulator(step), m_steps(0), m_dropped(0.0) {}
+
+int fixed_clock::advance(double seconds) {
+	if (seconds > 0.0) {
+		m_accumulator += seconds;
+	}
+
+	int steps = (int)(m_accumulator / m_step);
+
+	if (steps > m_max_steps) {
+		double dropped = (steps - m_max_steps) * m_step;
+		m_dropped += dropped;
+
+		LOG_DEBUG(CORE, "Simulation %.1f ms behind, dropped", dropped * 1000.0);
+
+		steps = m_max_steps;
+		m_accumulator = std::fmod(m_accumulator, m_step) + steps * m_step;
+	}
+
+	m_accumulator -= steps * m_step;
+	m_steps += steps;
+
+	return steps;
+} // advance
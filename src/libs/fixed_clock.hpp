@@ -0,0 +1,49 @@
+#ifndef _FIXED_CLOCK_HPP
+#define _FIXED_CLOCK_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+* @brief Turns variable frame times into a whole number of fixed simulation steps
+*
+* Frame time goes into an accumulator and comes out in steps of one size, so the
+* simulation behaves the same at any frame rate. What is left over (less than a step)
+* is the alpha renderers blend the previous and the current step with. A frame never
+* runs more than max_steps: after a stall the rest of the time is dropped instead of
+* simulating ever more steps to catch up (the spiral of death).
+*/
+class fixed_clock {
+public:
+	/**
+	* @param step Seconds of one simulation step
+	* @param max_steps Most steps a single frame may run
+	*/
+	fixed_clock(double step, int max_steps);
+
+	/**
+	* @brief Add the time of a frame
+	*
+	* @return int Steps to simulate this frame
+	*/
+	int advance(double seconds);
+
+	/**
+	* @brief Fraction of a step accumulated past the last one, 0 to 1
+	*/
+	float alpha() const { return (float)(m_accumulator / m_step); }
+
+	double step() const { return m_step; }
+	uint64_t steps() const { return m_steps; }             // Run since creation
+	double dropped_seconds() const { return m_dropped; }  // Discarded by the catch-up cap
+
+private:
+	double m_step;
+	int m_max_steps;
+
+	double m_accumulator;
+	uint64_t m_steps;
+	double m_dropped;
+}; // fixed_clock
+
+#endif // _FIXED_CLOCK_HPP
@@ -0,0 +1,126 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+#include "log.hpp"
+#include "frame_arena.hpp"
+
+/**
+* @brief Heap block of an allocation that did not fit its region, freed when the region is reset
+*/
+struct arena_overflow {
+	arena_overflow* next;
+	size_t alignment; // Of the block, needed to free it
+};
+
+struct arena_region {
+	unsigned char* base = nullptr;
+	size_t used = 0;
+	arena_overflow* overflow = nullptr;
+};
+
+struct arena_state {
+	arena_region regions[FRAMES_IN_FLIGHT];
+	size_t capacity = 0;
+	size_t current = 0;
+	size_t peak = 0;
+	size_t overflows = 0;
+	bool warned = false; // Overflow logged once per run
+};
+
+static arena_state& state() {
+	static arena_state instance;
+	return instance;
+}
+
+static void release_overflow(arena_region& region) {
+	while (region.overflow) {
+		arena_overflow* next = region.overflow->next;
+		::operator delete(region.overflow, std::align_val_t(region.overflow->alignment));
+		region.overflow = next;
+	}
+}
+
+void frame_arena::init(size_t bytes_per_frame) {
+	arena_state& s = state();
+
+	shutdown();
+
+	for (arena_region& region : s.regions) {
+		region.base = static_cast<unsigned char*>(::operator new(bytes_per_frame));
+	}
+
+	s.capacity = bytes_per_frame;
+	s.current = 0;
+} // init
+
+void frame_arena::shutdown() {
+	arena_state& s = state();
+
+	for (arena_region& region : s.regions) {
+		release_overflow(region);
+		::operator delete(region.base);
+
+		region = arena_region();
+	}
+
+	s.capacity = 0;
+} // shutdown
+
+void frame_arena::begin_frame() {
+	arena_state& s = state();
+
+	s.peak = std::max(s.peak, s.regions[s.current].used);
+	s.current = (s.current + 1) % FRAMES_IN_FLIGHT;
+
+	// The oldest region, written FRAMES_IN_FLIGHT frames ago
+	arena_region& region = s.regions[s.current];
+	region.used = 0;
+	release_overflow(region);
+} // begin_frame
+
+void* frame_arena::allocate(size_t size, size_t alignment) {
+	arena_state& s = state();
+	arena_region& region = s.regions[s.current];
+
+	size_t offset = (region.used + alignment - 1) & ~(alignment - 1);
+
+	if (region.base && offset + size <= s.capacity) {
+		region.used = offset + size;
+		return region.base + offset;
+	}
+
+	if (!s.warned) {
+		LOG_WARNING(CORE, "Frame arena full (%zu bytes per frame), falling back to the heap", s.capacity);
+		s.warned = true;
+	}
+
+	++s.overflows;
+
+	// Block header padded so the allocation keeps its alignment
+	alignment = std::max(alignment, alignof(arena_overflow));
+	size_t header = (sizeof(arena_overflow) + alignment - 1) & ~(alignment - 1);
+	unsigned char* block = static_cast<unsigned char*>(::operator new(header + size, std::align_val_t(alignment)));
+
+	arena_overflow* node = reinterpret_cast<arena_overflow*>(block);
+	node->next = region.overflow;
+	node->alignment = alignment;
+	region.overflow = node;
+
+	return block + header;
+} // allocate
+
+size_t frame_arena::used() {
+	arena_state& s = state();
+	return s.regions[s.current].used;
+}
+
+size_t frame_arena::peak() {
+	arena_state& s = state();
+	return std::max(s.peak, s.regions[s.current].used);
+}
+
+size_t frame_arena::overflows() {
+	return state().overflows;
+}
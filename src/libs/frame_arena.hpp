@@ -0,0 +1,81 @@
+#ifndef _FRAME_ARENA_HPP
+#define _FRAME_ARENA_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+constexpr size_t FRAMES_IN_FLIGHT = 3;            // Frames the CPU may run ahead of the GPU
+constexpr size_t FRAME_ARENA_BYTES = 1024 * 1024; // Size of one frame's region
+
+/**
+* @brief Per frame linear allocator for transient data (culling lists, draw ranges, ...)
+*
+* Allocating bumps a pointer, nothing is freed on its own. Every frame gets one of
+* FRAMES_IN_FLIGHT regions and begin_frame() resets the oldest, so memory handed out
+* stays valid for FRAMES_IN_FLIGHT frames, long enough for data the GPU still reads.
+* A full region falls back to global new (freed with the region) and counts an
+* overflow, raise the region size when that happens. Main thread only.
+*/
+struct frame_arena {
+	/**
+	* @brief Reserve the regions
+	*/
+	static void init(size_t bytes_per_frame = FRAME_ARENA_BYTES);
+
+	/**
+	* @brief Free the regions, nothing allocated from the arena may be used afterwards
+	*/
+	static void shutdown();
+
+	/**
+	* @brief Move to the next region and reset it
+	*/
+	static void begin_frame();
+
+	static void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	template <typename T>
+	static T* allocate(size_t count) {
+		return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+	}
+
+	static size_t used();      // Bytes of the current region in use
+	static size_t peak();      // Most bytes a frame used
+	static size_t overflows(); // Allocations that did not fit their region
+}; // frame_arena
+
+/**
+* @brief STL allocator adapter for frame_arena, deallocation is a no-op
+*
+* Containers using it must not outlive the FRAMES_IN_FLIGHT frames their memory is
+* valid for. Reserve up front: a growing container leaves its old storage in the
+* region until it is reset.
+*/
+template <typename T>
+struct frame_allocator {
+	using value_type = T;
+
+	frame_allocator() noexcept = default;
+
+	template <typename U>
+	frame_allocator(const frame_allocator<U>&) noexcept {}
+
+	T* allocate(size_t count) {
+		return frame_arena::allocate<T>(count);
+	}
+
+	void deallocate(T*, size_t) noexcept {}
+
+	template <typename U>
+	bool operator==(const frame_allocator<U>&) const noexcept { return true; }
+
+	template <typename U>
+	bool operator!=(const frame_allocator<U>&) const noexcept { return false; }
+}; // frame_allocator
+
+template <typename T>
+using frame_vector = std::vector<T, frame_allocator<T>>;
+
+#endif // _FRAME_ARENA_HPP
@@ -0,0 +1,128 @@
+#include "gl.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "log.hpp"
+#include "profiler.hpp"
+#include "frame_arena.hpp"
+#include "frame_manager.hpp"
+
+constexpr GLuint64 FRAME_FENCE_TIMEOUT_NS = 100000000; // Wait in steps of 100 ms, logging each one that runs out
+
+struct frame_state {
+	GLsync fences[FRAMES_IN_FLIGHT] = {}; // Of the frame that last used each slot
+	size_t frames_in_flight = FRAMES_IN_FLIGHT;
+	size_t slot = 0;
+	uint64_t frame = 0;
+	bool low_latency = false;
+	float wait_ms = 0.0f;
+};
+
+static frame_state& state() {
+	static frame_state instance;
+	return instance;
+}
+
+static void wait_fence(GLsync fence) {
+	if (!fence)
+		return;
+
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT; // The fence must reach the GPU or the wait never ends
+
+	while (true) {
+		GLenum status = glClientWaitSync(fence, flags, FRAME_FENCE_TIMEOUT_NS);
+
+		if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED)
+			return;
+
+		if (status == GL_WAIT_FAILED) {
+			LOG_ERROR(RENDER, "Waiting for a frame fence failed");
+			return;
+		}
+
+		LOG_WARNING(RENDER, "GPU frame still running after %llu ms", (unsigned long long)(FRAME_FENCE_TIMEOUT_NS / 1000000));
+		flags = 0;
+	}
+}
+
+static void delete_fence(GLsync& fence) {
+	if (fence) {
+		glDeleteSync(fence);
+		fence = nullptr;
+	}
+}
+
+void frame_manager::init(size_t frames_in_flight, bool low_latency) {
+	frame_state& s = state();
+
+	shutdown();
+
+	s.frames_in_flight = std::clamp<size_t>(frames_in_flight, 1, FRAMES_IN_FLIGHT);
+	s.low_latency = low_latency;
+	s.slot = 0;
+	s.frame = 0;
+} // init
+
+void frame_manager::shutdown() {
+	frame_state& s = state();
+
+	for (GLsync& fence : s.fences) {
+		wait_fence(fence);
+		delete_fence(fence);
+	}
+} // shutdown
+
+void frame_manager::begin_frame() {
+	PROFILE_SCOPE("GPU wait");
+
+	frame_state& s = state();
+	size_t previous = s.slot;
+
+	if (s.frame > 0) {
+		s.slot = (s.slot + 1) % s.frames_in_flight;
+	}
+
+	++s.frame;
+
+	int64_t start = profiler::now();
+
+	// The previous frame finishing implies every older one did
+	wait_fence(s.low_latency ? s.fences[previous] : s.fences[s.slot]);
+	delete_fence(s.fences[s.slot]);
+
+	s.wait_ms = (float)(profiler::now() - start) / 1e6f;
+
+	frame_arena::begin_frame();
+} // begin_frame
+
+void frame_manager::end_frame() {
+	frame_state& s = state();
+
+	delete_fence(s.fences[s.slot]);
+	s.fences[s.slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+} // end_frame
+
+size_t frame_manager::slot() {
+	return state().slot;
+}
+
+uint64_t frame_manager::frame() {
+	return state().frame;
+}
+
+size_t frame_manager::frames_in_flight() {
+	return state().frames_in_flight;
+}
+
+void frame_manager::set_low_latency(bool enabled) {
+	state().low_latency = enabled;
+}
+
+bool frame_manager::low_latency() {
+	return state().low_latency;
+}
+
+float frame_manager::wait_ms() {
+	return state().wait_ms;
+}
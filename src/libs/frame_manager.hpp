@@ -0,0 +1,53 @@
+#ifndef _FRAME_MANAGER_HPP
+#define _FRAME_MANAGER_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "frame_arena.hpp"
+
+/**
+* @brief Paces the CPU against the GPU with one fence per frame in flight
+*
+* end_frame() fences the frame's GL commands, begin_frame() waits until the frame that
+* last used the slot is done on the GPU, so the CPU never runs more than
+* frames_in_flight() frames ahead and whatever the slot's last frame read is free to
+* overwrite. The frame arena is advanced with it, per frame GPU data goes through a
+* stream_buffer, which keeps one fenced region per frame in flight.
+*
+* Low latency mode waits for the previous frame instead: the GPU is idle when the
+* frame starts, so input sampled right after begin_frame() is at most one frame old
+* when it reaches the screen, at the cost of CPU/GPU overlap.
+*/
+struct frame_manager {
+	/**
+	* @param frames_in_flight Frames the CPU may queue ahead, at most FRAMES_IN_FLIGHT
+	*/
+	static void init(size_t frames_in_flight = FRAMES_IN_FLIGHT, bool low_latency = false);
+
+	/**
+	* @brief Wait for every frame in flight and delete the fences
+	*/
+	static void shutdown();
+
+	/**
+	* @brief Wait for the GPU as far as the mode needs, call before sampling input
+	*/
+	static void begin_frame();
+
+	/**
+	* @brief Fence the frame's commands, call after the last GL call before the swap
+	*/
+	static void end_frame();
+
+	static size_t slot();     // Ring index of the current frame, 0 to frames_in_flight() - 1
+	static uint64_t frame();  // Frames begun since init
+	static size_t frames_in_flight();
+
+	static void set_low_latency(bool enabled);
+	static bool low_latency();
+
+	static float wait_ms();   // CPU time the last begin_frame() spent waiting for the GPU
+}; // frame_manager
+
+#endif // _FRAME_MANAGER_HPP
@@ -0,0 +1,57 @@
+#ifndef _GL_HPP
+#define _GL_HPP
+
+#include <GLEW/glew.h>
+
+// Set to 0 to call the OpenGL 1.1 entry points directly (gl_trace then misses them)
+#ifndef GL_TRACE_ENABLED
+#define GL_TRACE_ENABLED 1
+#endif
+
+#if GL_TRACE_ENABLED
+/**
+* @brief The OpenGL 1.1 entry points the engine uses, called through pointers like every GLEW function
+*
+* opengl32 exports these directly, so GLEW has no pointer for gl_trace to swap. Including
+* this header instead of glew.h routes them through these pointers instead.
+*/
+struct gl_core {
+	inline static decltype(&::glBindTexture) BindTexture = &::glBindTexture;
+	inline static decltype(&::glBlendFunc) BlendFunc = &::glBlendFunc;
+	inline static decltype(&::glClear) Clear = &::glClear;
+	inline static decltype(&::glClearColor) ClearColor = &::glClearColor;
+	inline static decltype(&::glDeleteTextures) DeleteTextures = &::glDeleteTextures;
+	inline static decltype(&::glDisable) Disable = &::glDisable;
+	inline static decltype(&::glDrawElements) DrawElements = &::glDrawElements;
+	inline static decltype(&::glEnable) Enable = &::glEnable;
+	inline static decltype(&::glFinish) Finish = &::glFinish;
+	inline static decltype(&::glGenTextures) GenTextures = &::glGenTextures;
+	inline static decltype(&::glGetIntegerv) GetIntegerv = &::glGetIntegerv;
+	inline static decltype(&::glGetString) GetString = &::glGetString;
+	inline static decltype(&::glPixelStorei) PixelStorei = &::glPixelStorei;
+	inline static decltype(&::glTexImage2D) TexImage2D = &::glTexImage2D;
+	inline static decltype(&::glTexParameteri) TexParameteri = &::glTexParameteri;
+	inline static decltype(&::glTexSubImage2D) TexSubImage2D = &::glTexSubImage2D;
+	inline static decltype(&::glViewport) Viewport = &::glViewport;
+}; // gl_core
+
+#define glBindTexture gl_core::BindTexture
+#define glBlendFunc gl_core::BlendFunc
+#define glClear gl_core::Clear
+#define glClearColor gl_core::ClearColor
+#define glDeleteTextures gl_core::DeleteTextures
+#define glDisable gl_core::Disable
+#define glDrawElements gl_core::DrawElements
+#define glEnable gl_core::Enable
+#define glFinish gl_core::Finish
+#define glGenTextures gl_core::GenTextures
+#define glGetIntegerv gl_core::GetIntegerv
+#define glGetString gl_core::GetString
+#define glPixelStorei gl_core::PixelStorei
+#define glTexImage2D gl_core::TexImage2D
+#define glTexParameteri gl_core::TexParameteri
+#define glTexSubImage2D gl_core::TexSubImage2D
+#define glViewport gl_core::Viewport
+#endif
+
+#endif // _GL_HPP
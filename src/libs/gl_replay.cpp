@@ -0,0 +1,586 @@
+#include "gl.hpp"
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <iterator>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "log.hpp"
+#include "profiler.hpp"
+#include "gl_trace.hpp"
+#include "gl_replay.hpp"
+
+/**
+* @brief A function as the trace describes it
+*/
+struct trace_call {
+	std::string name;
+	gl_state state;
+	gl_arg result;
+	uint8_t arg_count;
+	gl_arg args[GL_TRACE_MAX_ARGS];
+
+	const gl_call_info* local; // The function of the same name in this build, null if unknown
+};
+
+/**
+* @brief One decoded record, pointer arguments point into its payloads
+*/
+struct trace_record {
+	bool frame; // End of frame marker, nothing else is set
+	uint32_t call;
+	int64_t start_ns;
+	int64_t duration_ns;
+
+	uint64_t values[GL_TRACE_MAX_ARGS];
+	uint64_t result;
+	size_t arg_offsets[GL_TRACE_MAX_ARGS + 1]; // Where every encoded argument starts in the file
+
+	std::vector<uint8_t> payloads[GL_TRACE_MAX_ARGS];
+	std::vector<uint32_t> names[GL_TRACE_MAX_ARGS]; // NAMES and NEW_NAMES as traced
+	std::vector<const char*> strings;
+};
+
+class trace_reader {
+public:
+	std::vector<trace_call> m_calls;
+	uint32_t m_width = 0;
+	uint32_t m_height = 0;
+
+	bool open(const char* path) {
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if (!file.is_open()) {
+			LOG_ERROR(RENDER, "Failed to open GL trace %s", path);
+			return false;
+		}
+
+		m_data.resize((size_t)file.tellg());
+		file.seekg(0);
+		file.read((char*)m_data.data(), m_data.size());
+
+		uint32_t header[5];
+		if (!raw(header, sizeof(header)) || header[0] != GL_TRACE_MAGIC || header[1] != GL_TRACE_VERSION) {
+			LOG_ERROR(RENDER, "%s is not a version %u GL trace", path, GL_TRACE_VERSION);
+			return false;
+		}
+
+		m_width = header[2];
+		m_height = header[3];
+		m_time = (int64_t)varint();
+
+		m_calls.resize(header[4]);
+
+		for (trace_call& call : m_calls) {
+			uint64_t length = varint();
+			if (length == 0 || m_pos + length - 1 > m_data.size()) {
+				m_failed = true;
+				break;
+			}
+
+			call.name.assign((const char*)&m_data[m_pos], (size_t)length - 1);
+			m_pos += (size_t)length - 1;
+
+			uint8_t state[2];
+			raw(state, sizeof(state));
+			call.state = { state[0], (gl_scope)state[1] };
+
+			read_arg(call.result);
+			raw(&call.arg_count, 1);
+
+			if (call.arg_count > GL_TRACE_MAX_ARGS) {
+				m_failed = true;
+				break;
+			}
+
+			for (uint8_t i = 0; i < call.arg_count; ++i) {
+				read_arg(call.args[i]);
+			}
+
+			call.local = nullptr;
+			for (const gl_call_info& info : gl_trace::calls()) {
+				if (call.name == info.name && info.arg_count == call.arg_count) {
+					call.local = &info;
+				}
+			}
+		}
+
+		if (m_failed) {
+			LOG_ERROR(RENDER, "GL trace %s has a damaged header", path);
+			return false;
+		}
+
+		return true;
+	}
+
+	/**
+	* @brief Decode the next record, false at the end of the trace (or on damage, see failed())
+	*/
+	bool next(trace_record& record) {
+		if (m_failed || m_pos >= m_data.size())
+			return false;
+
+		uint64_t id = varint();
+		m_time += (int64_t)varint();
+
+		record.frame = id == 0;
+		record.start_ns = m_time;
+
+		if (record.frame)
+			return !m_failed;
+
+		if (id > m_calls.size()) {
+			m_failed = true;
+			return false;
+		}
+
+		record.call = (uint32_t)(id - 1);
+		record.duration_ns = (int64_t)varint();
+
+		const trace_call& call = m_calls[record.call];
+
+		for (uint8_t i = 0; i < call.arg_count; ++i) {
+			record.arg_offsets[i] = m_pos;
+			decode_arg(call.args[i], i, record);
+		}
+
+		record.arg_offsets[call.arg_count] = m_pos;
+		record.result = call.result.kind == gl_arg_kind::NAME ? varint() : 0;
+
+		return !m_failed;
+	}
+
+	bool failed() const { return m_failed; }
+
+	std::string_view bytes(size_t begin, size_t end) const {
+		return std::string_view((const char*)m_data.data() + begin, end - begin);
+	}
+
+private:
+	std::vector<uint8_t> m_data;
+	size_t m_pos = 0;
+	int64_t m_time = 0;
+	bool m_failed = false;
+
+	bool raw(void* out, size_t size) {
+		if (m_pos + size > m_data.size()) {
+			m_failed = true;
+			return false;
+		}
+
+		memcpy(out, &m_data[m_pos], size);
+		m_pos += size;
+
+		return true;
+	}
+
+	uint64_t varint() {
+		uint64_t value = 0;
+
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (m_pos >= m_data.size()) {
+				m_failed = true;
+				return 0;
+			}
+
+			uint8_t byte = m_data[m_pos++];
+			value |= (uint64_t)(byte & 0x7f) << shift;
+
+			if (!(byte & 0x80))
+				return value;
+		}
+
+		m_failed = true;
+		return 0;
+	}
+
+	int64_t signed_varint() {
+		uint64_t value = varint();
+		return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+	}
+
+	void read_arg(gl_arg& arg) {
+		uint8_t fields[7] = {};
+		raw(fields, sizeof(fields));
+
+		arg = { (gl_arg_kind)fields[0], (gl_object)fields[1], fields[2], fields[3], fields[4], fields[5], fields[6] };
+	}
+
+	// Length + 1 prefixed bytes into payload (zero terminated), null pointer for 0
+	uint64_t read_bytes(std::vector<uint8_t>& payload) {
+		uint64_t length = varint();
+		if (length == 0)
+			return 0;
+
+		if (m_pos + length - 1 > m_data.size()) {
+			m_failed = true;
+			return 0;
+		}
+
+		payload.assign(m_data.begin() + m_pos, m_data.begin() + m_pos + (size_t)(length - 1));
+		payload.push_back(0);
+		m_pos += (size_t)(length - 1);
+
+		return (uint64_t)(uintptr_t)payload.data();
+	}
+
+	void decode_arg(const gl_arg& arg, uint8_t index, trace_record& record) {
+		uint64_t& value = record.values[index];
+		std::vector<uint8_t>& payload = record.payloads[index];
+
+		value = 0;
+
+		switch (arg.kind) {
+			case gl_arg_kind::IGNORED:
+				break;
+
+			case gl_arg_kind::VALUE:
+				value = (uint64_t)signed_varint();
+				break;
+
+			case gl_arg_kind::FLOAT: {
+				uint32_t bits = 0;
+				raw(&bits, sizeof(bits));
+				value = bits;
+				break;
+			}
+
+			case gl_arg_kind::NAME:
+				value = varint();
+				break;
+
+			case gl_arg_kind::NAMES:
+			case gl_arg_kind::NEW_NAMES: {
+				std::vector<uint32_t>& names = record.names[index];
+				names.clear();
+
+				uint64_t count = varint();
+				if (count == 0)
+					break;
+
+				for (uint64_t i = 0; i + 1 < count && !m_failed; ++i) {
+					names.push_back((uint32_t)varint());
+				}
+
+				// Read by the call (remapped on replay) or written by it
+				payload.resize(std::max<size_t>(names.size(), 1) * sizeof(GLuint));
+				memcpy(payload.data(), names.data(), names.size() * sizeof(GLuint));
+				value = (uint64_t)(uintptr_t)payload.data();
+				break;
+			}
+
+			case gl_arg_kind::BLOB:
+			case gl_arg_kind::FLOATS:
+			case gl_arg_kind::INTS:
+			case gl_arg_kind::PIXELS:
+			case gl_arg_kind::STRING:
+				value = read_bytes(payload);
+				break;
+
+			case gl_arg_kind::OFFSETS: {
+				uint64_t count = varint();
+				if (count == 0)
+					break;
+
+				std::vector<uintptr_t> offsets;
+				for (uint64_t i = 0; i + 1 < count && !m_failed; ++i) {
+					offsets.push_back((uintptr_t)varint());
+				}
+
+				payload.resize(std::max<size_t>(offsets.size(), 1) * sizeof(uintptr_t));
+				memcpy(payload.data(), offsets.data(), offsets.size() * sizeof(uintptr_t));
+				value = (uint64_t)(uintptr_t)payload.data();
+				break;
+			}
+
+			case gl_arg_kind::STRINGS: {
+				uint64_t count = varint();
+				if (count == 0)
+					break;
+
+				std::vector<size_t> starts;
+				payload.clear();
+
+				for (uint64_t i = 0; i + 1 < count && !m_failed; ++i) {
+					std::vector<uint8_t> str;
+					read_bytes(str);
+
+					starts.push_back(payload.size());
+					payload.insert(payload.end(), str.begin(), str.end());
+
+					if (str.empty()) {
+						payload.push_back(0);
+					}
+				}
+
+				// Zero terminated, the lengths argument is replayed as null
+				record.strings.clear();
+				for (size_t start : starts) {
+					record.strings.push_back((const char*)payload.data() + start);
+				}
+
+				value = (uint64_t)(uintptr_t)record.strings.data();
+				break;
+			}
+
+			case gl_arg_kind::OUTPUT: {
+				size_t count = arg.count == GL_TRACE_NO_ARG ? 1 : gl_trace::count(record.values, arg.count);
+
+				payload.assign(std::max<size_t>(count * arg.a, 64), 0);
+				value = (uint64_t)(uintptr_t)payload.data();
+				break;
+			}
+		}
+	}
+}; // trace_reader
+
+/**
+* @brief Object names of the traced run mapped to the replay's
+*/
+struct name_maps {
+	std::unordered_map<uint64_t, uint64_t> maps[(size_t)gl_object::COUNT]; // 64 bits for GLsync
+	size_t unresolved = 0;
+
+	uint64_t find(gl_object object, uint64_t name) {
+		auto& map = maps[(size_t)object];
+
+		auto it = map.find(name);
+		if (it != map.end())
+			return it->second;
+
+		if (name != 0) {
+			++unresolved; // Created before the trace started
+		}
+
+		return name;
+	}
+};
+
+static bool run_trace(const char* path, bool replay, gl_trace_report& report) {
+	trace_reader reader;
+	if (!reader.open(path))
+		return false;
+
+	report = gl_trace_report();
+
+	std::vector<gl_call_stats> stats(reader.m_calls.size());
+	for (size_t i = 0; i < stats.size(); ++i) {
+		stats[i].name = reader.m_calls[i].name;
+	}
+
+	// Redundant state: the last value of every state key, and the bindings that scope them
+	std::unordered_map<std::string, std::string> state_values;
+	uint64_t scopes[4] = {}; // By gl_scope
+	size_t scope_calls[4] = { SIZE_MAX, SIZE_MAX, SIZE_MAX, SIZE_MAX };
+	size_t enable_call = SIZE_MAX, disable_call = SIZE_MAX;
+
+	for (size_t i = 0; i < reader.m_calls.size(); ++i) {
+		const std::string& name = reader.m_calls[i].name;
+
+		if (name == "glEnable") { enable_call = i; }
+		if (name == "glDisable") { disable_call = i; }
+
+		if (name == "glActiveTexture") { scope_calls[(size_t)gl_scope::TEXTURE_UNIT] = i; }
+		if (name == "glUseProgram") { scope_calls[(size_t)gl_scope::PROGRAM] = i; }
+		if (name == "glBindVertexArray") { scope_calls[(size_t)gl_scope::VERTEX_ARRAY] = i; }
+	}
+
+	// Replay target, framebuffer 0 was the window
+	name_maps names;
+	GLuint fbo = 0, color = 0, depth = 0;
+
+	if (replay) {
+		glGenRenderbuffers(1, &color);
+		glBindRenderbuffer(GL_RENDERBUFFER, color);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, std::max(reader.m_width, 1u), std::max(reader.m_height, 1u));
+
+		glGenRenderbuffers(1, &depth);
+		glBindRenderbuffer(GL_RENDERBUFFER, depth);
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, std::max(reader.m_width, 1u), std::max(reader.m_height, 1u));
+
+		glGenFramebuffers(1, &fbo);
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, color);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, depth);
+		glViewport(0, 0, reader.m_width, reader.m_height);
+
+		names.maps[(size_t)gl_object::FRAMEBUFFER][0] = fbo;
+	}
+
+	trace_record record;
+	int64_t replay_start = profiler::now();
+
+	while (reader.next(record)) {
+		if (record.frame) {
+			++report.frames;
+			continue;
+		}
+
+		const trace_call& call = reader.m_calls[record.call];
+		gl_call_stats& call_stats = stats[record.call];
+
+		++report.calls;
+		++call_stats.calls;
+		call_stats.traced_ns += record.duration_ns;
+
+		if (call.state.key_args != GL_TRACE_NO_ARG && call.state.key_args <= call.arg_count) {
+			// glEnable and glDisable set the same state, which of them was called is the value
+			bool toggle = record.call == enable_call || record.call == disable_call;
+			size_t key_call = toggle && enable_call != SIZE_MAX ? enable_call : record.call;
+
+			std::string key = std::to_string(key_call) + ':' + std::to_string(scopes[(size_t)call.state.scope]) + ':';
+			key += reader.bytes(record.arg_offsets[0], record.arg_offsets[call.state.key_args]);
+
+			std::string_view value = reader.bytes(record.arg_offsets[call.state.key_args], record.arg_offsets[call.arg_count]);
+			if (toggle) {
+				value = record.call == enable_call ? "enabled" : "disabled";
+			}
+
+			auto [it, inserted] = state_values.try_emplace(key, value);
+			if (!inserted) {
+				if (it->second == value) {
+					++call_stats.redundant;
+					++report.redundant;
+				}
+				else {
+					it->second = value;
+				}
+			}
+		}
+
+		for (size_t scope = 1; scope < 4; ++scope) {
+			if (record.call == scope_calls[scope]) {
+				scopes[scope] = record.values[0];
+			}
+		}
+
+		if (!replay)
+			continue;
+
+		if (!call.local || !call.local->loaded()) {
+			++report.skipped;
+			continue;
+		}
+
+		for (uint8_t i = 0; i < call.arg_count; ++i) {
+			const gl_arg& arg = call.args[i];
+
+			if (arg.kind == gl_arg_kind::NAME) {
+				record.values[i] = names.find(arg.object, record.values[i]);
+			}
+			else if (arg.kind == gl_arg_kind::NAMES && record.values[i]) {
+				GLuint* mapped = (GLuint*)record.payloads[i].data();
+
+				for (size_t n = 0; n < record.names[i].size(); ++n) {
+					mapped[n] = (GLuint)names.find(arg.object, record.names[i][n]);
+				}
+			}
+		}
+
+		int64_t start = profiler::now();
+		uint64_t result = call.local->invoke(record.values);
+		call_stats.replay_ns += profiler::now() - start;
+
+		// Names the replay created stand in for the traced ones from here on
+		for (uint8_t i = 0; i < call.arg_count; ++i) {
+			const gl_arg& arg = call.args[i];
+
+			if (arg.kind == gl_arg_kind::NEW_NAMES && record.values[i]) {
+				const GLuint* created = (const GLuint*)record.payloads[i].data();
+
+				for (size_t n = 0; n < record.names[i].size(); ++n) {
+					names.maps[(size_t)arg.object][record.names[i][n]] = created[n];
+				}
+			}
+		}
+
+		if (call.result.kind == gl_arg_kind::NAME) {
+			names.maps[(size_t)call.result.object][record.result] = result;
+		}
+	}
+
+	if (replay) {
+		glFinish();
+		report.replay_ns = profiler::now() - replay_start;
+		report.unresolved = names.unresolved;
+
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glDeleteFramebuffers(1, &fbo);
+		glDeleteRenderbuffers(1, &color);
+		glDeleteRenderbuffers(1, &depth);
+	}
+
+	if (reader.failed()) {
+		LOG_WARNING(RENDER, "GL trace %s is truncated after %zu calls", path, report.calls);
+	}
+
+	for (gl_call_stats& s : stats) {
+		if (s.calls > 0) {
+			report.functions.push_back(std::move(s));
+		}
+	}
+
+	std::sort(report.functions.begin(), report.functions.end(), [](const gl_call_stats& a, const gl_call_stats& b) {
+		return a.name < b.name;
+	});
+
+	return true;
+}
+
+bool analyze_gl_trace(const char* path, gl_trace_report& report) {
+	return run_trace(path, false, report);
+} // analyze_gl_trace
+
+bool replay_gl_trace(const char* path, gl_trace_report& report) {
+	return run_trace(path, true, report);
+} // replay_gl_trace
+
+void log_gl_trace_report(const gl_trace_report& report) {
+	double frames = (double)std::max<size_t>(report.frames, 1);
+
+	for (const gl_call_stats& s : report.functions) {
+		LOG_INFO(RENDER, "%-30s %9zu calls %9.1f/frame %8zu redundant  traced %9.3f ms  replayed %9.3f ms", s.name.c_str(),
+			s.calls, s.calls / frames, s.redundant, s.traced_ns / 1e6, s.replay_ns / 1e6);
+	}
+
+	LOG_INFO(RENDER, "%zu calls (%.1f per frame) over %zu frames, %zu redundant state changes", report.calls, report.calls / frames,
+		report.frames, report.redundant);
+
+	if (report.replay_ns > 0) {
+		LOG_INFO(RENDER, "Replayed in %.3f ms (%.3f ms per frame), %zu calls skipped, %zu unresolved names", report.replay_ns / 1e6,
+			report.replay_ns / 1e6 / frames, report.skipped, report.unresolved);
+	}
+} // log_gl_trace_report
+
+void log_gl_trace_diff(const gl_trace_report& before, const gl_trace_report& after) {
+	double before_frames = (double)std::max<size_t>(before.frames, 1);
+	double after_frames = (double)std::max<size_t>(after.frames, 1);
+
+	// Calls per frame of every function in either trace
+	std::map<std::string, std::pair<double, double>> rates;
+
+	for (const gl_call_stats& s : before.functions) {
+		rates[s.name].first = s.calls / before_frames;
+	}
+
+	for (const gl_call_stats& s : after.functions) {
+		rates[s.name].second = s.calls / after_frames;
+	}
+
+	size_t changed = 0;
+
+	for (const auto& [name, rate] : rates) {
+		if (rate.first == rate.second)
+			continue;
+
+		LOG_INFO(RENDER, "%-30s %9.1f -> %9.1f per frame (%+.1f)", name.c_str(), rate.first, rate.second, rate.second - rate.first);
+		++changed;
+	}
+
+	LOG_INFO(RENDER, "Calls per frame %.1f -> %.1f, redundant %.1f -> %.1f, %zu function(s) changed", before.calls / before_frames,
+		after.calls / after_frames, before.redundant / before_frames, after.redundant / after_frames, changed);
+} // log_gl_trace_diff
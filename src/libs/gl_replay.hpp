@@ -0,0 +1,66 @@
+#ifndef _GL_REPLAY_HPP
+#define _GL_REPLAY_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+* @brief Calls of one GL function in a trace
+*/
+struct gl_call_stats {
+	std::string name;
+	size_t calls = 0;
+	size_t redundant = 0;  // State setting calls that set what was already set
+	int64_t traced_ns = 0; // CPU time in the traced run
+	int64_t replay_ns = 0; // CPU time when replayed (0 if not replayed)
+};
+
+/**
+* @brief What a GL trace (see gl_trace) contains, and how long its calls took
+*/
+struct gl_trace_report {
+	size_t frames = 0;
+	size_t calls = 0;
+	size_t redundant = 0;
+	size_t skipped = 0;    // Replay: calls of functions this build or driver does not have
+	size_t unresolved = 0; // Replay: object names used without being created in the trace
+	int64_t replay_ns = 0;
+	std::vector<gl_call_stats> functions; // Sorted by name
+};
+
+/**
+ * Count the calls of a trace and find redundant state changes, no GL context needed
+ *
+ * @param path The trace written by gl_trace
+ * @param report Filled with the per function counts
+ *
+ * @return bool False if the file is not a readable trace
+ */
+bool analyze_gl_trace(const char* path, gl_trace_report& report);
+
+/**
+ * Re-execute a trace on the current context and time every call
+ *
+ * Object names are remapped to the ones the replay creates, and framebuffer 0 (the
+ * window in the traced run) to an offscreen framebuffer of the traced viewport size.
+ *
+ * @param path The trace written by gl_trace
+ * @param report Filled with the per function counts and replay times
+ *
+ * @return bool False if the file is not a readable trace
+ */
+bool replay_gl_trace(const char* path, gl_trace_report& report);
+
+/**
+ * Log the per function calls (per frame), redundant calls and times of a report
+ */
+void log_gl_trace_report(const gl_trace_report& report);
+
+/**
+ * Log how the per frame call counts changed between two traces (e.g. two builds running the same benchmark)
+ */
+void log_gl_trace_diff(const gl_trace_report& before, const gl_trace_report& after);
+
+#endif // _GL_REPLAY_HPP
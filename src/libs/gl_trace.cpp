@@ -0,0 +1,544 @@
+#include "gl.hpp"
+#include <type_traits>
+#include <utility>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <span>
+#include <bit>
+
+#include "log.hpp"
+#include "profiler.hpp"
+#include "gl_trace.hpp"
+
+constexpr size_t GL_TRACE_FLUSH_BYTES = 1024 * 1024; // Buffered before a write
+
+/* Argument encodings */
+
+constexpr gl_arg ARG_IGNORED = { gl_arg_kind::IGNORED, gl_object::NONE, GL_TRACE_NO_ARG };
+constexpr gl_arg ARG_VALUE = { gl_arg_kind::VALUE, gl_object::NONE, GL_TRACE_NO_ARG };
+constexpr gl_arg ARG_FLOAT = { gl_arg_kind::FLOAT, gl_object::NONE, GL_TRACE_NO_ARG };
+constexpr gl_arg ARG_STRING = { gl_arg_kind::STRING, gl_object::NONE, GL_TRACE_NO_ARG };
+
+constexpr gl_arg arg_name(gl_object object) { return { gl_arg_kind::NAME, object, GL_TRACE_NO_ARG }; }
+constexpr gl_arg arg_names(gl_object object, uint8_t count) { return { gl_arg_kind::NAMES, object, count }; }
+constexpr gl_arg arg_new_names(gl_object object, uint8_t count) { return { gl_arg_kind::NEW_NAMES, object, count }; }
+constexpr gl_arg arg_blob(uint8_t size) { return { gl_arg_kind::BLOB, gl_object::NONE, size }; }
+constexpr gl_arg arg_floats(uint8_t count, uint8_t per_element) { return { gl_arg_kind::FLOATS, gl_object::NONE, count, per_element }; }
+constexpr gl_arg arg_ints(uint8_t count) { return { gl_arg_kind::INTS, gl_object::NONE, count }; }
+constexpr gl_arg arg_offsets(uint8_t count) { return { gl_arg_kind::OFFSETS, gl_object::NONE, count }; }
+constexpr gl_arg arg_pixels(uint8_t width, uint8_t height, uint8_t format, uint8_t type) { return { gl_arg_kind::PIXELS, gl_object::NONE, GL_TRACE_NO_ARG, width, height, format, type }; }
+constexpr gl_arg arg_strings(uint8_t count, uint8_t lengths) { return { gl_arg_kind::STRINGS, gl_object::NONE, count, lengths }; }
+constexpr gl_arg arg_output(uint8_t count, uint8_t element_size) { return { gl_arg_kind::OUTPUT, gl_object::NONE, count, element_size }; }
+
+constexpr gl_state NO_STATE = { GL_TRACE_NO_ARG, gl_scope::GLOBAL };
+constexpr gl_state state_key(uint8_t key_args, gl_scope scope = gl_scope::GLOBAL) { return { key_args, scope }; }
+
+/* Thunks */
+
+template <typename T>
+static uint64_t to_value(T value) {
+	if constexpr (std::is_pointer_v<T>)
+		return (uint64_t)reinterpret_cast<uintptr_t>(value);
+	else if constexpr (std::is_floating_point_v<T>)
+		return std::bit_cast<uint32_t>((float)value);
+	else if constexpr (std::is_signed_v<T>)
+		return (uint64_t)(int64_t)value;
+	else
+		return (uint64_t)value;
+}
+
+template <typename T>
+static T from_value(uint64_t value) {
+	if constexpr (std::is_pointer_v<T>)
+		return reinterpret_cast<T>((uintptr_t)value);
+	else if constexpr (std::is_floating_point_v<T>)
+		return (T)std::bit_cast<float>((uint32_t)value);
+	else
+		return (T)value;
+}
+
+template <auto Slot, typename Function = std::remove_pointer_t<decltype(Slot)>>
+struct gl_thunk;
+
+/**
+* @brief Stands in for the GL function in *Slot while tracing
+*/
+template <auto Slot, typename Ret, typename... Args>
+struct gl_thunk<Slot, Ret (GLAPIENTRY*)(Args...)> {
+	inline static Ret (GLAPIENTRY* real)(Args...) = nullptr;
+	inline static uint16_t id = 0;
+
+	static constexpr uint8_t arg_count = (uint8_t)sizeof...(Args);
+
+	static Ret GLAPIENTRY call(Args... args) {
+		uint64_t values[sizeof...(Args) + 1] = { to_value(args)..., 0 };
+		int64_t start = profiler::now();
+
+		if constexpr (std::is_void_v<Ret>) {
+			real(args...);
+			gl_trace::record(id, start, profiler::now(), values, 0);
+		}
+		else {
+			Ret result = real(args...);
+			gl_trace::record(id, start, profiler::now(), values, to_value(result));
+			return result;
+		}
+	}
+
+	static bool install(uint16_t index) {
+		if (!*Slot)
+			return false;
+
+		real = *Slot;
+		id = index;
+		*Slot = &call;
+
+		return true;
+	}
+
+	static void uninstall() {
+		if (real) {
+			*Slot = real;
+			real = nullptr;
+		}
+	}
+
+	static bool loaded() {
+		return *Slot != nullptr;
+	}
+
+	static uint64_t invoke(const uint64_t* values) {
+		return invoke_with(values, std::index_sequence_for<Args...>{});
+	}
+
+	template <size_t... I>
+	static uint64_t invoke_with(const uint64_t* values, std::index_sequence<I...>) {
+		if constexpr (std::is_void_v<Ret>) {
+			(*Slot)(from_value<Args>(values[I])...);
+			return 0;
+		}
+		else {
+			return to_value((*Slot)(from_value<Args>(values[I])...));
+		}
+	}
+}; // gl_thunk
+
+template <auto Slot, typename... Args>
+static constexpr gl_call_info make_call(const char* name, gl_state state, gl_arg result, Args... args) {
+	using thunk = gl_thunk<Slot>;
+	static_assert(sizeof...(Args) == thunk::arg_count, "Every argument needs an encoding");
+
+	return { name, state, result, thunk::arg_count, { args... }, &thunk::install, &thunk::uninstall, &thunk::loaded, &thunk::invoke };
+}
+
+// function is the GL name, expanded to GLEW's (or gl_core's) pointer
+#define GL_TRACE_CALL(function, ...) make_call<&function>(#function, __VA_ARGS__)
+
+/**
+* @brief Every GL function the engine calls (keep in sync when a new one is used)
+*/
+static const gl_call_info call_table[] = {
+	GL_TRACE_CALL(glActiveTexture, state_key(0), ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glAttachShader, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM), arg_name(gl_object::SHADER)),
+	GL_TRACE_CALL(glBeginQuery, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_name(gl_object::QUERY)),
+	GL_TRACE_CALL(glBindAttribLocation, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM), ARG_VALUE, ARG_STRING),
+	GL_TRACE_CALL(glBindBuffer, state_key(1, gl_scope::VERTEX_ARRAY), ARG_IGNORED, ARG_VALUE, arg_name(gl_object::BUFFER)),
+	GL_TRACE_CALL(glBindBufferBase, state_key(2), ARG_IGNORED, ARG_VALUE, ARG_VALUE, arg_name(gl_object::BUFFER)),
+	GL_TRACE_CALL(glBindBufferRange, state_key(2), ARG_IGNORED, ARG_VALUE, ARG_VALUE, arg_name(gl_object::BUFFER), ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glBindFramebuffer, state_key(1), ARG_IGNORED, ARG_VALUE, arg_name(gl_object::FRAMEBUFFER)),
+	GL_TRACE_CALL(glBindRenderbuffer, state_key(1), ARG_IGNORED, ARG_VALUE, arg_name(gl_object::RENDERBUFFER)),
+	GL_TRACE_CALL(glBindTexture, state_key(1, gl_scope::TEXTURE_UNIT), ARG_IGNORED, ARG_VALUE, arg_name(gl_object::TEXTURE)),
+	GL_TRACE_CALL(glBindVertexArray, state_key(0), ARG_IGNORED, arg_name(gl_object::VERTEX_ARRAY)),
+	GL_TRACE_CALL(glBlendFunc, state_key(0), ARG_IGNORED, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glBufferData, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, arg_blob(1), ARG_VALUE),
+	GL_TRACE_CALL(glBufferStorage, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, arg_blob(1), ARG_VALUE),
+	GL_TRACE_CALL(glBufferSubData, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_blob(2)),
+	GL_TRACE_CALL(glCheckFramebufferStatus, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glClear, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glClearColor, state_key(0), ARG_IGNORED, ARG_FLOAT, ARG_FLOAT, ARG_FLOAT, ARG_FLOAT),
+	GL_TRACE_CALL(glClientWaitSync, NO_STATE, ARG_IGNORED, arg_name(gl_object::SYNC), ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glCompileShader, NO_STATE, ARG_IGNORED, arg_name(gl_object::SHADER)),
+	GL_TRACE_CALL(glCopyImageSubData, NO_STATE, ARG_IGNORED,
+		arg_name(gl_object::TEXTURE), ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE,
+		arg_name(gl_object::TEXTURE), ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE,
+		ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glCreateProgram, NO_STATE, arg_name(gl_object::PROGRAM)),
+	GL_TRACE_CALL(glCreateShader, NO_STATE, arg_name(gl_object::SHADER), ARG_VALUE),
+	GL_TRACE_CALL(glDebugMessageCallback, NO_STATE, ARG_IGNORED, ARG_IGNORED, ARG_IGNORED),
+	GL_TRACE_CALL(glDeleteBuffers, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_names(gl_object::BUFFER, 0)),
+	GL_TRACE_CALL(glDeleteFramebuffers, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_names(gl_object::FRAMEBUFFER, 0)),
+	GL_TRACE_CALL(glDeleteProgram, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM)),
+	GL_TRACE_CALL(glDeleteRenderbuffers, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_names(gl_object::RENDERBUFFER, 0)),
+	GL_TRACE_CALL(glDeleteShader, NO_STATE, ARG_IGNORED, arg_name(gl_object::SHADER)),
+	GL_TRACE_CALL(glDeleteSync, NO_STATE, ARG_IGNORED, arg_name(gl_object::SYNC)),
+	GL_TRACE_CALL(glDeleteTextures, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_names(gl_object::TEXTURE, 0)),
+	GL_TRACE_CALL(glDeleteVertexArrays, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_names(gl_object::VERTEX_ARRAY, 0)),
+	GL_TRACE_CALL(glDisable, state_key(1), ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glDrawElements, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glDrawElementsBaseVertex, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glEnable, state_key(1), ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glEnableVertexAttribArray, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glEndQuery, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glFenceSync, NO_STATE, arg_name(gl_object::SYNC), ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glFinish, NO_STATE, ARG_IGNORED),
+	GL_TRACE_CALL(glFramebufferRenderbuffer, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_name(gl_object::RENDERBUFFER)),
+	GL_TRACE_CALL(glGenBuffers, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_new_names(gl_object::BUFFER, 0)),
+	GL_TRACE_CALL(glGenFramebuffers, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_new_names(gl_object::FRAMEBUFFER, 0)),
+	GL_TRACE_CALL(glGenQueries, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_new_names(gl_object::QUERY, 0)),
+	GL_TRACE_CALL(glGenRenderbuffers, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_new_names(gl_object::RENDERBUFFER, 0)),
+	GL_TRACE_CALL(glGenTextures, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_new_names(gl_object::TEXTURE, 0)),
+	GL_TRACE_CALL(glGenVertexArrays, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_new_names(gl_object::VERTEX_ARRAY, 0)),
+	GL_TRACE_CALL(glGetIntegerv, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 64)),
+	GL_TRACE_CALL(glGetProgramBinary, NO_STATE, ARG_IGNORED,
+		arg_name(gl_object::PROGRAM), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4), arg_output(GL_TRACE_NO_ARG, 4), arg_output(1, 1)),
+	GL_TRACE_CALL(glGetProgramInterfaceiv, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM), ARG_VALUE, ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4)),
+	GL_TRACE_CALL(glGetProgramResourceName, NO_STATE, ARG_IGNORED,
+		arg_name(gl_object::PROGRAM), ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4), arg_output(3, 1)),
+	GL_TRACE_CALL(glGetProgramResourceiv, NO_STATE, ARG_IGNORED,
+		arg_name(gl_object::PROGRAM), ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_ints(3), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4), arg_output(5, 4)),
+	GL_TRACE_CALL(glGetProgramiv, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4)),
+	GL_TRACE_CALL(glGetQueryObjectiv, NO_STATE, ARG_IGNORED, arg_name(gl_object::QUERY), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4)),
+	GL_TRACE_CALL(glGetQueryObjectui64v, NO_STATE, ARG_IGNORED, arg_name(gl_object::QUERY), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 8)),
+	GL_TRACE_CALL(glGetShaderInfoLog, NO_STATE, ARG_IGNORED, arg_name(gl_object::SHADER), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4), arg_output(1, 1)),
+	GL_TRACE_CALL(glGetShaderiv, NO_STATE, ARG_IGNORED, arg_name(gl_object::SHADER), ARG_VALUE, arg_output(GL_TRACE_NO_ARG, 4)),
+	GL_TRACE_CALL(glGetString, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glLinkProgram, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM)),
+	GL_TRACE_CALL(glMapBufferRange, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE), // Writes through the mapping are not traced
+	GL_TRACE_CALL(glMaxShaderCompilerThreadsARB, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glMaxShaderCompilerThreadsKHR, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glMultiDrawElements, NO_STATE, ARG_IGNORED, ARG_VALUE, arg_ints(4), ARG_VALUE, arg_offsets(4), ARG_VALUE),
+	GL_TRACE_CALL(glPixelStorei, state_key(1), ARG_IGNORED, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glProgramBinary, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM), ARG_VALUE, arg_blob(3), ARG_VALUE),
+	GL_TRACE_CALL(glProgramParameteri, NO_STATE, ARG_IGNORED, arg_name(gl_object::PROGRAM), ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glRenderbufferStorage, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glShaderSource, NO_STATE, ARG_IGNORED, arg_name(gl_object::SHADER), ARG_VALUE, arg_strings(1, 3), ARG_IGNORED),
+	GL_TRACE_CALL(glTexImage2D, NO_STATE, ARG_IGNORED,
+		ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_pixels(3, 4, 6, 7)),
+	GL_TRACE_CALL(glTexParameteri, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glTexStorage2D, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glTexSubImage2D, NO_STATE, ARG_IGNORED,
+		ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_pixels(4, 5, 6, 7)),
+	GL_TRACE_CALL(glUniform1f, state_key(1, gl_scope::PROGRAM), ARG_IGNORED, ARG_VALUE, ARG_FLOAT),
+	GL_TRACE_CALL(glUniform1i, state_key(1, gl_scope::PROGRAM), ARG_IGNORED, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glUniform3fv, state_key(1, gl_scope::PROGRAM), ARG_IGNORED, ARG_VALUE, ARG_VALUE, arg_floats(1, 3)),
+	GL_TRACE_CALL(glUniformMatrix3fv, state_key(1, gl_scope::PROGRAM), ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_floats(1, 9)),
+	GL_TRACE_CALL(glUniformMatrix4fv, state_key(1, gl_scope::PROGRAM), ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, arg_floats(1, 16)),
+	GL_TRACE_CALL(glUnmapBuffer, NO_STATE, ARG_IGNORED, ARG_VALUE),
+	GL_TRACE_CALL(glUseProgram, state_key(0), ARG_IGNORED, arg_name(gl_object::PROGRAM)),
+	GL_TRACE_CALL(glVertexAttrib4fv, state_key(1), ARG_IGNORED, ARG_VALUE, arg_floats(GL_TRACE_NO_ARG, 4)),
+	GL_TRACE_CALL(glVertexAttribPointer, NO_STATE, ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+	GL_TRACE_CALL(glViewport, state_key(0), ARG_IGNORED, ARG_VALUE, ARG_VALUE, ARG_VALUE, ARG_VALUE),
+};
+
+/* Writer */
+
+struct trace_state {
+	FILE* file = nullptr;
+	std::vector<uint8_t> buffer;
+
+	int64_t last_ns = 0;    // Start of the previous record
+	size_t frames_left = 0; // 0: until stop()
+	size_t frames = 0;
+	size_t records = 0;
+	size_t bytes = 0;
+
+	GLint unpack_alignment = 4; // Followed through glPixelStorei to size uploaded images
+	size_t pixel_store_id = SIZE_MAX;
+};
+
+static trace_state& state() {
+	static trace_state instance;
+	return instance;
+}
+
+static void put_varint(std::vector<uint8_t>& out, uint64_t value) {
+	while (value >= 0x80) {
+		out.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+
+	out.push_back((uint8_t)value);
+}
+
+static void put_signed(std::vector<uint8_t>& out, int64_t value) {
+	put_varint(out, ((uint64_t)value << 1) ^ (uint64_t)(value >> 63)); // Zigzag, small negatives stay short
+}
+
+static void put_raw(std::vector<uint8_t>& out, const void* data, size_t size) {
+	const uint8_t* bytes = (const uint8_t*)data;
+	out.insert(out.end(), bytes, bytes + size);
+}
+
+// Length + 1 then the bytes, 0 for a null pointer
+static void put_bytes(std::vector<uint8_t>& out, const void* data, size_t size) {
+	if (!data) {
+		put_varint(out, 0);
+		return;
+	}
+
+	put_varint(out, size + 1);
+	put_raw(out, data, size);
+}
+
+static void put_arg(std::vector<uint8_t>& out, const gl_arg& arg) {
+	uint8_t fields[7] = { (uint8_t)arg.kind, (uint8_t)arg.object, arg.count, arg.a, arg.b, arg.c, arg.d };
+	put_raw(out, fields, sizeof(fields));
+}
+
+size_t gl_trace::count(const uint64_t* values, uint8_t index) {
+	int64_t count = (int64_t)values[index];
+	return count > 0 ? (size_t)count : 0;
+} // count
+
+size_t gl_trace::image_size(uint64_t width, uint64_t height, uint64_t format, uint64_t type, size_t alignment) {
+	size_t components;
+	switch (format) {
+		case GL_RED: case GL_RED_INTEGER: case GL_ALPHA: case GL_DEPTH_COMPONENT: case GL_STENCIL_INDEX: components = 1; break;
+		case GL_RG: case GL_RG_INTEGER: case GL_DEPTH_STENCIL: components = 2; break;
+		case GL_RGB: case GL_BGR: case GL_RGB_INTEGER: components = 3; break;
+		default: components = 4; break;
+	}
+
+	size_t pixel;
+	switch (type) {
+		case GL_UNSIGNED_BYTE: case GL_BYTE: pixel = components; break;
+		case GL_UNSIGNED_SHORT: case GL_SHORT: case GL_HALF_FLOAT: pixel = components * 2; break;
+		case GL_UNSIGNED_INT: case GL_INT: case GL_FLOAT: pixel = components * 4; break;
+		case GL_UNSIGNED_SHORT_5_6_5: case GL_UNSIGNED_SHORT_4_4_4_4: case GL_UNSIGNED_SHORT_5_5_5_1: pixel = 2; break;
+		default: pixel = 4; break; // Packed 32 bit formats
+	}
+
+	size_t row = (size_t)width * pixel;
+	row = (row + alignment - 1) / alignment * alignment;
+
+	return row * (size_t)height;
+} // image_size
+
+static void put_record_arg(trace_state& s, const gl_arg& arg, const uint64_t* values, uint64_t value) {
+	std::vector<uint8_t>& out = s.buffer;
+	const void* pointer = (const void*)(uintptr_t)value;
+
+	switch (arg.kind) {
+		case gl_arg_kind::IGNORED:
+		case gl_arg_kind::OUTPUT:
+			break;
+
+		case gl_arg_kind::VALUE:
+			put_signed(out, (int64_t)value);
+			break;
+
+		case gl_arg_kind::FLOAT: {
+			uint32_t bits = (uint32_t)value;
+			put_raw(out, &bits, sizeof(bits));
+			break;
+		}
+
+		case gl_arg_kind::NAME:
+			put_varint(out, value);
+			break;
+
+		case gl_arg_kind::NAMES:
+		case gl_arg_kind::NEW_NAMES: {
+			size_t count = gl_trace::count(values, arg.count);
+			put_varint(out, pointer ? count + 1 : 0);
+
+			for (size_t i = 0; pointer && i < count; ++i) {
+				put_varint(out, ((const GLuint*)pointer)[i]);
+			}
+			break;
+		}
+
+		case gl_arg_kind::BLOB:
+			put_bytes(out, pointer, gl_trace::count(values, arg.count));
+			break;
+
+		case gl_arg_kind::FLOATS: {
+			size_t count = arg.count == GL_TRACE_NO_ARG ? 1 : gl_trace::count(values, arg.count);
+			put_bytes(out, pointer, count * arg.a * sizeof(float));
+			break;
+		}
+
+		case gl_arg_kind::INTS:
+			put_bytes(out, pointer, gl_trace::count(values, arg.count) * sizeof(GLint));
+			break;
+
+		case gl_arg_kind::OFFSETS: {
+			size_t count = gl_trace::count(values, arg.count);
+			put_varint(out, pointer ? count + 1 : 0);
+
+			for (size_t i = 0; pointer && i < count; ++i) {
+				put_varint(out, (uint64_t)(uintptr_t)((const void* const*)pointer)[i]);
+			}
+			break;
+		}
+
+		case gl_arg_kind::PIXELS:
+			put_bytes(out, pointer, gl_trace::image_size(values[arg.a], values[arg.b], values[arg.c], values[arg.d], (size_t)s.unpack_alignment));
+			break;
+
+		case gl_arg_kind::STRING:
+			put_bytes(out, pointer, pointer ? strlen((const char*)pointer) : 0);
+			break;
+
+		case gl_arg_kind::STRINGS: {
+			size_t count = gl_trace::count(values, arg.count);
+			const char* const* strings = (const char* const*)pointer;
+			const GLint* lengths = (const GLint*)(uintptr_t)values[arg.a];
+
+			put_varint(out, strings ? count + 1 : 0);
+
+			for (size_t i = 0; strings && i < count; ++i) {
+				size_t length = lengths && lengths[i] >= 0 ? (size_t)lengths[i] : strlen(strings[i]);
+				put_bytes(out, strings[i], length);
+			}
+			break;
+		}
+	}
+}
+
+static void flush(trace_state& s) {
+	if (s.buffer.empty())
+		return;
+
+	fwrite(s.buffer.data(), 1, s.buffer.size(), s.file);
+
+	s.bytes += s.buffer.size();
+	s.buffer.clear();
+}
+
+void gl_trace::record(uint16_t id, int64_t start_ns, int64_t end_ns, const uint64_t* values, uint64_t result) {
+	trace_state& s = state();
+	const gl_call_info& call = call_table[id];
+
+	put_varint(s.buffer, (uint64_t)id + 1);
+	put_varint(s.buffer, (uint64_t)(start_ns - s.last_ns));
+	put_varint(s.buffer, (uint64_t)(end_ns - start_ns));
+
+	for (uint8_t i = 0; i < call.arg_count; ++i) {
+		put_record_arg(s, call.args[i], values, values[i]);
+	}
+
+	if (call.result.kind == gl_arg_kind::NAME) {
+		put_varint(s.buffer, result);
+	}
+
+	if (id == s.pixel_store_id && values[0] == GL_UNPACK_ALIGNMENT) {
+		s.unpack_alignment = (GLint)values[1];
+	}
+
+	s.last_ns = start_ns;
+	++s.records;
+
+	if (s.buffer.size() >= GL_TRACE_FLUSH_BYTES) {
+		flush(s);
+	}
+} // record
+
+bool gl_trace::start(const char* path, size_t frames) {
+	trace_state& s = state();
+
+	if (s.file) {
+		LOG_WARNING(RENDER, "A GL trace is already running");
+		return false;
+	}
+
+	s.file = fopen(path, "wb");
+	if (!s.file) {
+		LOG_ERROR(RENDER, "Failed to open GL trace %s", path);
+		return false;
+	}
+
+	// Still the real functions, nothing is hooked yet
+	GLint viewport[4] = {};
+	glGetIntegerv(GL_VIEWPORT, viewport);
+	glGetIntegerv(GL_UNPACK_ALIGNMENT, &s.unpack_alignment);
+
+	s.buffer.clear();
+	s.frames_left = frames;
+	s.frames = 0;
+	s.records = 0;
+	s.bytes = 0;
+	s.last_ns = profiler::now();
+
+	// Header
+	uint32_t header[] = { GL_TRACE_MAGIC, GL_TRACE_VERSION, (uint32_t)viewport[2], (uint32_t)viewport[3], (uint32_t)std::size(call_table) };
+	put_raw(s.buffer, header, sizeof(header));
+	put_varint(s.buffer, (uint64_t)s.last_ns);
+
+	for (const gl_call_info& call : call_table) {
+		put_bytes(s.buffer, call.name, strlen(call.name));
+		s.buffer.push_back(call.state.key_args);
+		s.buffer.push_back((uint8_t)call.state.scope);
+		put_arg(s.buffer, call.result);
+		s.buffer.push_back(call.arg_count);
+
+		for (uint8_t i = 0; i < call.arg_count; ++i) {
+			put_arg(s.buffer, call.args[i]);
+		}
+	}
+
+	// Hook every loaded function
+	size_t missing = 0;
+
+	for (size_t id = 0; id < std::size(call_table); ++id) {
+		if (!call_table[id].install((uint16_t)id)) {
+			++missing;
+		}
+
+		if (strcmp(call_table[id].name, "glPixelStorei") == 0) {
+			s.pixel_store_id = id;
+		}
+	}
+
+	LOG_INFO(RENDER, "Tracing %zu GL functions to %s (%zu not loaded)", std::size(call_table) - missing, path, missing);
+
+	return true;
+} // start
+
+void gl_trace::end_frame() {
+	trace_state& s = state();
+
+	if (!s.file)
+		return;
+
+	int64_t now = profiler::now();
+
+	put_varint(s.buffer, 0);
+	put_varint(s.buffer, (uint64_t)(now - s.last_ns));
+	s.last_ns = now;
+
+	++s.frames;
+
+	if (s.frames_left > 0 && --s.frames_left == 0) {
+		stop();
+	}
+} // end_frame
+
+void gl_trace::stop() {
+	trace_state& s = state();
+
+	if (!s.file)
+		return;
+
+	for (const gl_call_info& call : call_table) {
+		call.uninstall();
+	}
+
+	flush(s);
+	fclose(s.file);
+	s.file = nullptr;
+
+	LOG_INFO(RENDER, "GL trace done: %zu calls over %zu frames, %.2f MB", s.records, s.frames, s.bytes / (1024.0 * 1024.0));
+} // stop
+
+bool gl_trace::active() {
+	return state().file != nullptr;
+} // active
+
+std::span<const gl_call_info> gl_trace::calls() {
+	return call_table;
+} // calls
@@ -0,0 +1,136 @@
+#ifndef _GL_TRACE_HPP
+#define _GL_TRACE_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+
+#include "gl.hpp"
+
+constexpr uint32_t GL_TRACE_MAGIC = 0x544c474c; // "LGLT"
+constexpr uint32_t GL_TRACE_VERSION = 1;
+constexpr size_t GL_TRACE_MAX_ARGS = 16;
+constexpr uint8_t GL_TRACE_NO_ARG = 0xff;
+
+/**
+* @brief How a traced argument is encoded (and rebuilt on replay)
+*/
+enum class gl_arg_kind : uint8_t {
+	IGNORED,   // Callbacks and user pointers, replayed as null
+	VALUE,     // Integer, enum, size or buffer offset
+	FLOAT,
+	NAME,      // Object name, remapped on replay
+	NAMES,     // Array of `count` object names read by the call
+	NEW_NAMES, // Array of `count` object names written by the call (glGen*)
+	BLOB,      // `count` bytes
+	FLOATS,    // `count` * `a` floats (count GL_TRACE_NO_ARG: `a` floats)
+	INTS,      // `count` 32 bit integers
+	OFFSETS,   // `count` buffer offsets passed as pointers
+	PIXELS,    // Image of the width, height, format and type arguments `a`, `b`, `c`, `d`
+	STRING,    // Zero terminated
+	STRINGS,   // `count` strings, lengths array argument `a` (null: zero terminated)
+	OUTPUT     // Written by the call, replayed into scratch memory of `count` * `a` bytes (count GL_TRACE_NO_ARG: `a` bytes)
+};
+
+enum class gl_object : uint8_t {
+	NONE,
+	BUFFER,
+	TEXTURE,
+	VERTEX_ARRAY,
+	PROGRAM,
+	SHADER,
+	FRAMEBUFFER,
+	RENDERBUFFER,
+	QUERY,
+	SYNC, // GLsync, a pointer rather than a GLuint name
+	COUNT
+};
+
+/**
+* @brief Context state a state setting call depends on besides its key arguments
+*/
+enum class gl_scope : uint8_t {
+	GLOBAL,
+	TEXTURE_UNIT, // glBindTexture: the active texture unit
+	PROGRAM,      // glUniform*: the program in use
+	VERTEX_ARRAY  // glBindBuffer: element array bindings belong to the vertex array
+};
+
+struct gl_arg {
+	gl_arg_kind kind;
+	gl_object object;
+	uint8_t count; // Index of the argument holding the element count
+	uint8_t a = 0, b = 0, c = 0, d = 0; // Kind specific, unused ones stay 0
+};
+
+/**
+* @brief Calls that set state: the first `key_args` arguments (and the scope) select the state, the rest is its value
+*/
+struct gl_state {
+	uint8_t key_args; // GL_TRACE_NO_ARG: not a state setting call
+	gl_scope scope;
+};
+
+/**
+* @brief A traced GL function: its encoding and the hooks to trace and replay it
+*/
+struct gl_call_info {
+	const char* name;
+	gl_state state;
+	gl_arg result;
+	uint8_t arg_count;
+	gl_arg args[GL_TRACE_MAX_ARGS];
+
+	bool (*install)(uint16_t id);                // Swap in the tracing thunk, false if the function is not loaded
+	void (*uninstall)();
+	bool (*loaded)();
+	uint64_t (*invoke)(const uint64_t* values);  // Call the function with encoded values (replay)
+};
+
+/**
+* @brief Records every GL call the engine makes into a compact binary trace
+*
+* Tracing swaps GLEW's function pointers (and gl_core's, see gl.hpp) for thunks that
+* forward the call and append its id, CPU timestamp, duration and arguments to the
+* trace, with the data pointed to (buffer contents, uniforms, shader sources) inline.
+* Nothing is hooked while no trace is running. GL calls must come from one thread.
+*
+* File: header (magic, version, viewport, then every call's name and encoding so a
+* trace stays readable by other builds), followed by records of varints:
+* call id + 1 (0 marks the end of a frame), start relative to the previous record,
+* duration in nanoseconds, arguments, result.
+*/
+struct gl_trace {
+	/**
+	* @brief Start tracing into path, stopping by itself after frames end_frame() calls (0: at stop())
+	*
+	* Start right after glewInit so the trace holds the creation of every object it uses.
+	*/
+	static bool start(const char* path, size_t frames = 0);
+
+	/**
+	* @brief Mark the end of a frame
+	*/
+	static void end_frame();
+
+	/**
+	* @brief Restore the GL functions and close the trace
+	*/
+	static void stop();
+
+	static bool active();
+
+	/**
+	* @brief Every function that can be traced
+	*/
+	static std::span<const gl_call_info> calls();
+
+	// Used by the thunks
+	static void record(uint16_t id, int64_t start_ns, int64_t end_ns, const uint64_t* values, uint64_t result);
+
+	// Used by the trace reader
+	static size_t count(const uint64_t* values, uint8_t index);
+	static size_t image_size(uint64_t width, uint64_t height, uint64_t format, uint64_t type, size_t alignment);
+}; // gl_trace
+
+#endif // _GL_TRACE_HPP
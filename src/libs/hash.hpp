@@ -0,0 +1,37 @@
+#ifndef _HASH_HPP
+#define _HASH_HPP
+
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+/**
+* @brief 64-bit FNV-1a hash, chain calls by passing the previous result as seed
+*/
+constexpr uint64_t fnv1a(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS) {
+	const unsigned char* bytes = static_cast<const unsigned char*>(data);
+	uint64_t hash = seed;
+
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+constexpr uint64_t fnv1a(std::string_view str, uint64_t seed = FNV_OFFSET_BASIS) {
+	uint64_t hash = seed;
+
+	for (char c : str) {
+		hash ^= static_cast<unsigned char>(c);
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+#endif // _HASH_HPP
@@ -0,0 +1,117 @@
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include "memory_tracker.hpp"
+#include "heap_stats.hpp"
+
+static std::atomic<uint64_t> total_allocations = 0;
+static thread_local uint64_t thread_count = 0;
+
+/**
+* @brief Written right before every allocation so the delete can charge its size back to its tag
+*/
+struct alignas(std::max_align_t) allocation_header {
+	uint64_t size;
+	memory_tag tag;
+};
+
+// Bytes in front of an allocation: the header, or a whole alignment step for over-aligned ones
+static inline size_t header_offset(size_t alignment) {
+	return alignment > sizeof(allocation_header) ? alignment : sizeof(allocation_header);
+}
+
+static void* counted_alloc(size_t size, size_t alignment) {
+	total_allocations.fetch_add(1, std::memory_order_relaxed);
+	++thread_count;
+
+	size_t offset = header_offset(alignment);
+	unsigned char* base;
+
+	if (alignment <= alignof(std::max_align_t)) {
+		base = static_cast<unsigned char*>(std::malloc(offset + size));
+	}
+	else {
+#ifdef _WIN32
+		base = static_cast<unsigned char*>(_aligned_malloc(offset + size, alignment));
+#else
+		void* ptr = nullptr;
+		base = posix_memalign(&ptr, alignment, offset + size) == 0 ? static_cast<unsigned char*>(ptr) : nullptr;
+#endif
+	}
+
+	if (!base)
+		return nullptr;
+
+	memory_tag tag = memory_tracker::current();
+	memory_tracker::allocated(tag, size);
+
+	allocation_header* header = reinterpret_cast<allocation_header*>(base + offset) - 1;
+	header->size = size;
+	header->tag = tag;
+
+	return base + offset;
+}
+
+static void counted_free(void* ptr, size_t alignment) {
+	if (!ptr)
+		return;
+
+	allocation_header* header = static_cast<allocation_header*>(ptr) - 1;
+	memory_tracker::freed(header->tag, header->size);
+
+	unsigned char* base = static_cast<unsigned char*>(ptr) - header_offset(alignment);
+
+#ifdef _WIN32
+	if (alignment > alignof(std::max_align_t)) {
+		_aligned_free(base);
+		return;
+	}
+#endif
+
+	std::free(base);
+}
+
+static void* throwing_alloc(size_t size, size_t alignment) {
+	void* ptr = counted_alloc(size, alignment);
+
+	if (!ptr)
+		throw std::bad_alloc();
+
+	return ptr;
+}
+
+uint64_t heap_stats::allocations() {
+	return total_allocations.load(std::memory_order_relaxed);
+}
+
+uint64_t heap_stats::thread_allocations() {
+	return thread_count;
+}
+
+/* Replaced global allocation functions */
+
+void* operator new(size_t size) { return throwing_alloc(size, 0); }
+void* operator new[](size_t size) { return throwing_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return throwing_alloc(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment) { return throwing_alloc(size, (size_t)alignment); }
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_alloc(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return counted_alloc(size, (size_t)alignment); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return counted_alloc(size, (size_t)alignment); }
+
+void operator delete(void* ptr) noexcept { counted_free(ptr, 0); }
+void operator delete[](void* ptr) noexcept { counted_free(ptr, 0); }
+void operator delete(void* ptr, size_t) noexcept { counted_free(ptr, 0); }
+void operator delete[](void* ptr, size_t) noexcept { counted_free(ptr, 0); }
+void operator delete(void* ptr, std::align_val_t alignment) noexcept { counted_free(ptr, (size_t)alignment); }
+void operator delete[](void* ptr, std::align_val_t alignment) noexcept { counted_free(ptr, (size_t)alignment); }
+void operator delete(void* ptr, size_t, std::align_val_t alignment) noexcept { counted_free(ptr, (size_t)alignment); }
+void operator delete[](void* ptr, size_t, std::align_val_t alignment) noexcept { counted_free(ptr, (size_t)alignment); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr, 0); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_free(ptr, 0); }
+void operator delete(void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { counted_free(ptr, (size_t)alignment); }
+void operator delete[](void* ptr, std::align_val_t alignment, const std::nothrow_t&) noexcept { counted_free(ptr, (size_t)alignment); }
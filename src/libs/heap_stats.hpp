@@ -0,0 +1,25 @@
+#ifndef _HEAP_STATS_HPP
+#define _HEAP_STATS_HPP
+
+#include <cstdint>
+
+/**
+* @brief Counts the calls to global operator new, so a frame loop can prove it does not allocate
+*
+* heap_stats.cpp replaces the global operator new/delete (every form) with versions that
+* count, charge the memory_tracker and forward to malloc/free. Direct malloc calls (C
+* libraries, the driver) are not counted. The per thread count is thread_local, reading it is as cheap as the counting.
+*/
+struct heap_stats {
+	/**
+	* @brief Allocations made by every thread since startup
+	*/
+	static uint64_t allocations();
+
+	/**
+	* @brief Allocations made by the calling thread since it started
+	*/
+	static uint64_t thread_allocations();
+}; // heap_stats
+
+#endif // _HEAP_STATS_HPP
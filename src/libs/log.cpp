@@ -0,0 +1,186 @@
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <atomic>
+#include <thread>
+
+#include "log.hpp"
+
+constexpr size_t LOG_SLOT_COUNT = 1024; // Power of two
+constexpr size_t LOG_MESSAGE_SIZE = 240; // Longest message (with its terminator) formatted into a slot
+
+struct log_slot {
+	std::atomic<size_t> sequence; // position: free, position + 1: written, position + LOG_SLOT_COUNT: free for the next lap
+	log_level level;
+	log_category category;
+	bool skip; // Written by the caller, nothing to print
+	uint16_t length;
+	char text[LOG_MESSAGE_SIZE];
+};
+
+/**
+* @brief Bounded multi-producer single-consumer ring (Vyukov) and the thread draining it
+*/
+class log_ring {
+public:
+	log_ring() : m_head(0), m_tail(0), m_published(0), m_written(0), m_stalls(0), m_stop(false) {
+		for (size_t i = 0; i < LOG_SLOT_COUNT; ++i) {
+			m_slots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+
+		m_writer = std::thread(&log_ring::run, this);
+	}
+
+	~log_ring() {
+		m_stop.store(true, std::memory_order_release);
+		m_published.fetch_add(1, std::memory_order_release);
+		m_published.notify_one();
+
+		m_writer.join();
+	}
+
+	log_ring(log_ring&) = delete; // No copy constructor
+	log_ring& operator=(const log_ring&) = delete; // No copy assignment
+
+	log_slot* claim(size_t& position) {
+		size_t head = m_head.load(std::memory_order_relaxed);
+
+		for (;;) {
+			log_slot* slot = &m_slots[head & (LOG_SLOT_COUNT - 1)];
+			intptr_t diff = (intptr_t)slot->sequence.load(std::memory_order_acquire) - (intptr_t)head;
+
+			if (diff == 0) {
+				if (m_head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+					position = head;
+					return slot;
+				}
+			}
+			else if (diff < 0) {
+				// Full: the writer frees slots in order, wait for it
+				m_stalls.fetch_add(1, std::memory_order_relaxed);
+				std::this_thread::yield();
+				head = m_head.load(std::memory_order_relaxed);
+			}
+			else {
+				head = m_head.load(std::memory_order_relaxed); // Taken by another thread
+			}
+		}
+	}
+
+	void publish(log_slot* slot, size_t position) {
+		slot->sequence.store(position + 1, std::memory_order_release);
+
+		m_published.fetch_add(1, std::memory_order_release);
+		m_published.notify_one();
+	}
+
+	void flush() {
+		size_t target = m_head.load(std::memory_order_acquire);
+		size_t written = m_written.load(std::memory_order_acquire);
+
+		while (written < target) {
+			m_written.wait(written, std::memory_order_acquire);
+			written = m_written.load(std::memory_order_acquire);
+		}
+	}
+
+	size_t stalls() const { return m_stalls.load(std::memory_order_relaxed); }
+
+private:
+	log_slot m_slots[LOG_SLOT_COUNT];
+
+	std::atomic<size_t> m_head;      // Next position to claim
+	size_t m_tail;                   // Next position to print (writer thread)
+	std::atomic<uint32_t> m_published; // Bumped after every publish, the writer sleeps on it
+	std::atomic<size_t> m_written;   // Positions below this are printed
+	std::atomic<size_t> m_stalls;
+	std::atomic<bool> m_stop;
+
+	std::thread m_writer;
+
+	void run() {
+		for (;;) {
+			uint32_t published = m_published.load(std::memory_order_acquire);
+			bool printed = false;
+
+			for (;;) {
+				log_slot* slot = &m_slots[m_tail & (LOG_SLOT_COUNT - 1)];
+				if (slot->sequence.load(std::memory_order_acquire) != m_tail + 1)
+					break;
+
+				if (!slot->skip) {
+					fprintf(slot->level == log_level::ERROR ? stderr : stdout, "%s[%s] %.*s%s\n", log_level_colors[(size_t)slot->level],
+						log_category_names[(size_t)slot->category], (int)slot->length, slot->text, LOG_COLOR_RESET);
+				}
+
+				slot->sequence.store(m_tail + LOG_SLOT_COUNT, std::memory_order_release);
+				++m_tail;
+				printed = true;
+			}
+
+			if (printed) {
+				fflush(stdout);
+				fflush(stderr);
+
+				m_written.store(m_tail, std::memory_order_release);
+				m_written.notify_all();
+				continue;
+			}
+
+			if (m_stop.load(std::memory_order_acquire) && m_tail == m_head.load(std::memory_order_acquire))
+				return;
+
+			m_published.wait(published, std::memory_order_acquire);
+		}
+	}
+}; // log_ring
+
+static log_ring& ring() {
+	static log_ring instance;
+	return instance;
+}
+
+void logger::write(log_level level, log_category category, const char* format, ...) {
+	log_ring& queue = ring();
+
+	size_t position;
+	log_slot* slot = queue.claim(position);
+
+	va_list args;
+	va_start(args, format);
+
+	va_list long_args;
+	va_copy(long_args, args);
+
+	int length = vsnprintf(slot->text, LOG_MESSAGE_SIZE, format, args);
+	va_end(args);
+
+	slot->level = level;
+	slot->category = category;
+	slot->length = (uint16_t)(length > 0 ? length : 0);
+	slot->skip = length >= (int)LOG_MESSAGE_SIZE;
+
+	queue.publish(slot, position);
+
+	if (length >= (int)LOG_MESSAGE_SIZE) {
+		// Too long for a slot (e.g. a shader info log): print it here once everything before it is out
+		queue.flush();
+
+		FILE* output = level == log_level::ERROR ? stderr : stdout;
+
+		fprintf(output, "%s[%s] ", log_level_colors[(size_t)level], log_category_names[(size_t)category]);
+		vfprintf(output, format, long_args);
+		fprintf(output, "%s\n", LOG_COLOR_RESET);
+		fflush(output);
+	}
+
+	va_end(long_args);
+} // write
+
+void logger::flush() {
+	ring().flush();
+} // flush
+
+size_t logger::stalls() {
+	return ring().stalls();
+} // stalls
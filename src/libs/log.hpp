@@ -0,0 +1,98 @@
+#ifndef _LOG_HPP
+#define _LOG_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+/**
+* @brief Severity of a log message, also picks its colour
+*/
+enum class log_level : uint8_t {
+	TRACE,   // Per file / per item chatter
+	DEBUG,   // Statistics and timings
+	INFO,    // Milestones
+	WARNING,
+	ERROR
+};
+
+/**
+* @brief Engine system a log message comes from (must be in same order as log_category_names)
+*/
+enum class log_category : uint8_t {
+	CORE,
+	RENDER,
+	SHADER,
+	MESH,
+	TEXTURE,
+	COUNT
+};
+
+constexpr const char* log_category_names[] = { "core", "render", "shader", "mesh", "texture" };
+
+// ANSI colour of every level, written around the message by the writer thread
+constexpr const char* log_level_colors[] = { "\x1b[2;37m", "\x1b[0;34m", "\x1b[0;32m", "\x1b[0;33m", "\x1b[0;31m" };
+constexpr const char* LOG_COLOR_RESET = "\x1b[1;0m";
+
+// Messages below this level (a log_level value) are compiled out
+#ifndef LOG_MIN_LEVEL
+#ifdef _DEBUG
+#define LOG_MIN_LEVEL 0 // TRACE
+#else
+#define LOG_MIN_LEVEL 2 // INFO
+#endif
+#endif
+
+// Bit mask of the log_category values that are compiled in
+#ifndef LOG_CATEGORIES
+#define LOG_CATEGORIES 0xffffffffu
+#endif
+
+constexpr bool log_enabled(log_level level, log_category category) {
+	return (int)level >= LOG_MIN_LEVEL && ((LOG_CATEGORIES >> (unsigned)category) & 1u) != 0;
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+#define LOG_PRINTF_FORMAT(format_index, first_arg) __attribute__((format(printf, format_index, first_arg)))
+#else
+#define LOG_PRINTF_FORMAT(format_index, first_arg)
+#endif
+
+/**
+* @brief Asynchronous logger: callers format into a preallocated ring buffer slot, a writer thread prints
+*
+* Slots are claimed lock-free by any number of threads, so logging never allocates
+* or blocks on the console. A full ring makes the caller wait for the writer, no
+* message is dropped. Messages longer than a slot are written by the caller itself
+* after the ring has drained, keeping the order.
+*/
+struct logger {
+	/**
+	* @brief Queue a printf style message (no trailing newline), use the LOG_* macros instead
+	*/
+	static void write(log_level level, log_category category, const char* format, ...) LOG_PRINTF_FORMAT(3, 4);
+
+	/**
+	* @brief Wait until everything queued so far is written
+	*/
+	static void flush();
+
+	/**
+	* @brief Number of times a caller found the ring full and had to wait
+	*/
+	static size_t stalls();
+}; // logger
+
+// Filtered out messages, arguments included, are never evaluated
+#define LOG(level, category, ...) do { \
+	if constexpr (log_enabled(log_level::level, log_category::category)) { \
+		logger::write(log_level::level, log_category::category, __VA_ARGS__); \
+	} \
+} while (0)
+
+#define LOG_TRACE(category, ...)   LOG(TRACE, category, __VA_ARGS__)
+#define LOG_DEBUG(category, ...)   LOG(DEBUG, category, __VA_ARGS__)
+#define LOG_INFO(category, ...)    LOG(INFO, category, __VA_ARGS__)
+#define LOG_WARNING(category, ...) LOG(WARNING, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...)   LOG(ERROR, category, __VA_ARGS__)
+
+#endif // _LOG_HPP
@@ -1,28 +1,58 @@
 #include <glm/glm.hpp>
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <glm/gtc/type_ptr.hpp>
 #include <string_view>
 #include <type_traits>
 #include <stdexcept>
 
 #include "material.hpp"
+#include "render_stats.hpp"
 
-void material::set_attribute(std::string_view name) {
-	this->m_attributes[name] = glGetAttribLocation(this->m_shader->m_handle, name.data());
+uniform_handle material::uniform(std::string_view name) {
+	for (uniform_handle handle = 0; handle < this->m_uniforms.size(); ++handle) {
+		if (this->m_uniforms[handle].name == name) {
+			return handle;
+		}
+	}
+
+	this->m_uniforms.emplace_back(name);
+	this->m_generation = UINT32_MAX; // Resolve on next use
+
+	return (uniform_handle)(this->m_uniforms.size() - 1);
+}
+
+void material::resolve_locations() {
+	const shader_reflection& reflection = this->m_shader->m_reflection;
+
+	for (uniform_data& u : this->m_uniforms) {
+		const reflected_uniform* reflected = reflection.find_uniform(u.name);
+		u.location = reflected ? reflected->location : -1;
+	}
+
+	this->m_generation = this->m_shader->m_generation;
 }
 
 void material::use() {
+	if (this->m_generation != this->m_shader->m_generation) {
+		resolve_locations();
+	}
+
 	this->m_shader->use();
 
-	for (auto& [name, loc] : m_attributes) {
-		glEnableVertexAttribArray(loc);
-	}
+	for (uniform_data& u : this->m_uniforms) {
+		if (u.location < 0)
+			continue; // Not used by this shader (variant)
+
+		if (!std::holds_alternative<std::monostate>(u.value)) {
+			render_stats::uniform_uploads += 1;
+		}
 
-	for (auto& [name, u] : this->uniforms) {
 		std::visit([&](auto&& v) {
 			using T = std::decay_t<decltype(v)>;
 
-			if constexpr (std::is_same_v<T, int>)
+			if constexpr (std::is_same_v<T, std::monostate>)
+				return; // Never set
+			else if constexpr (std::is_same_v<T, int>)
 				glUniform1i(u.location, v);
 			else if constexpr (std::is_same_v<T, float>)
 				glUniform1f(u.location, v);
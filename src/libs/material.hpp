@@ -1,9 +1,10 @@
 #ifndef _MATERIAL_HPP
 #define _MATERIAL_HPP
 
-#include <GLEW/glew.h>
-#include <unordered_map>
+#include "gl.hpp"
 #include <string_view>
+#include <cstdint>
+#include <vector>
 
 #include "shader.hpp"
 #include "uniform.hpp"
@@ -12,37 +13,48 @@
 struct material {
 	shader* m_shader;
 	texture* m_tex;
+	std::vector<texture*> m_textures; // By mesh material id, null entries fall back to m_tex
+	uint32_t m_generation; // Shader generation the locations were resolved against
 
-	std::unordered_map<std::string_view, GLuint> m_attributes;
-	std::unordered_map<std::string_view, uniform_data> uniforms;
+	std::vector<uniform_data> m_uniforms; // Indexed by uniform_handle
 
-	material(shader* linked_shader, texture* linked_texture) : m_shader(linked_shader), m_tex(linked_texture) {}
+	material(shader* linked_shader, texture* linked_texture) : m_shader(linked_shader), m_tex(linked_texture), m_generation(UINT32_MAX) {}
 
 	/**
-	* @brief Set material attribute location
+	* @brief Declare a uniform once (e.g. when the material is created)
+	*
+	* @return uniform_handle Handle for set_uniform, the same handle is returned for the same name
 	*/
-	void set_attribute(std::string_view name);
+	uniform_handle uniform(std::string_view name);
 
 	/**
 	* @brief Set material uniform of given type
 	*/
 	template<typename T>
-	void set_uniform(std::string_view name, const T& data) {
-		auto it = this->uniforms.find(name);
+	void set_uniform(uniform_handle handle, const T& data) {
+		this->m_uniforms[handle].value = data;
+	}
 
-		if (it == this->uniforms.end()) {
-			GLuint loc = glGetUniformLocation(this->m_shader->m_handle, name.data());
-			it = this->uniforms.emplace(name, uniform_data(loc, data)).first;
-		}
+	/**
+	* @brief Texture of a mesh material
+	*/
+	texture* texture_for(uint32_t material_id) const {
+		if (material_id < m_textures.size() && m_textures[material_id])
+			return m_textures[material_id];
 
-		// Overwrite value
-		it->second.value = data;
+		return m_tex;
 	}
 
 	/**
 	* @brief Use the shader and set all uniforms
 	*/
 	void use();
+
+private:
+	/**
+	* @brief Resolve every uniform location from the shader reflection, again after the shader was (re)linked
+	*/
+	void resolve_locations();
 }; // material
 
 #endif // _MATERIAL_HPP
\ No newline at end of file
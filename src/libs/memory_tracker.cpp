@@ -0,0 +1,27 @@
+#include <cstdint>
+#include <cstddef>
+
+#include "log.hpp"
+#include "memory_tracker.hpp"
+
+static_assert(sizeof(memory_tag_names) / sizeof(memory_tag_names[0]) == (size_t)memory_tag::COUNT, "Every memory_tag needs a name");
+
+void memory_tracker::log_report() {
+	int64_t total_bytes = 0, total_live = 0;
+
+	for (size_t tag = 0; tag < (size_t)memory_tag::COUNT; ++tag) {
+		int64_t bytes = live_bytes((memory_tag)tag);
+		int64_t live = live_count((memory_tag)tag);
+
+		LOG_INFO(CORE, "Memory %-12s %10.2f KiB in %8lld allocation(s), %llu since startup", memory_tag_names[tag],
+			(double)bytes / 1024.0, (long long)live, (unsigned long long)allocations((memory_tag)tag));
+
+		// Pooled objects live inside the pool slabs, do not count them twice
+		if ((memory_tag)tag != memory_tag::COMPONENTS && (memory_tag)tag != memory_tag::OBJECTS) {
+			total_bytes += bytes;
+			total_live += live;
+		}
+	}
+
+	LOG_INFO(CORE, "Memory %-12s %10.2f KiB in %8lld allocation(s)", "heap", (double)total_bytes / 1024.0, (long long)total_live);
+} // log_report
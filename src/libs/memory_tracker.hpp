@@ -0,0 +1,95 @@
+#ifndef _MEMORY_TRACKER_HPP
+#define _MEMORY_TRACKER_HPP
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+/**
+* @brief Engine subsystem heap memory is charged to (must be in same order as memory_tag_names)
+*/
+enum class memory_tag : uint8_t {
+	UNTAGGED,   // Everything allocated outside a memory_scope
+	MESHES,
+	TEXTURES,
+	COMPONENTS, // Pooled components in use
+	OBJECTS,    // Pooled objects in use
+	STRINGS,    // Shader sources
+	POOLS,      // Slabs reserved by the pools
+	COUNT
+};
+
+constexpr const char* memory_tag_names[] = { "untagged", "meshes", "textures", "components", "objects", "strings", "pools" };
+
+/**
+* @brief Live bytes and allocations per memory_tag
+*
+* Global operator new (heap_stats.cpp) charges every allocation to the tag of the
+* calling thread's innermost memory_scope and keeps the tag in a small header, so
+* the delete is charged back wherever it happens. Pools report their objects with
+* allocated() / freed(). Counting is a few relaxed atomics per allocation, it stays
+* on in release builds.
+*/
+struct memory_tracker {
+	static void allocated(memory_tag tag, size_t bytes) {
+		tag_stats& stats = m_stats[(size_t)tag];
+
+		stats.bytes.fetch_add((int64_t)bytes, std::memory_order_relaxed);
+		stats.live.fetch_add(1, std::memory_order_relaxed);
+		stats.allocations.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	static void freed(memory_tag tag, size_t bytes) {
+		tag_stats& stats = m_stats[(size_t)tag];
+
+		stats.bytes.fetch_sub((int64_t)bytes, std::memory_order_relaxed);
+		stats.live.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	/**
+	* @brief Tag of the calling thread's innermost memory_scope
+	*/
+	static memory_tag current() { return m_current; }
+
+	static int64_t live_bytes(memory_tag tag) { return m_stats[(size_t)tag].bytes.load(std::memory_order_relaxed); }
+	static int64_t live_count(memory_tag tag) { return m_stats[(size_t)tag].live.load(std::memory_order_relaxed); }
+	static uint64_t allocations(memory_tag tag) { return m_stats[(size_t)tag].allocations.load(std::memory_order_relaxed); }
+
+	/**
+	* @brief Log the live bytes and allocations of every tag
+	*/
+	static void log_report();
+
+private:
+	friend struct memory_scope;
+
+	// One cache line per tag, threads charging different tags do not contend
+	struct alignas(64) tag_stats {
+		std::atomic<int64_t> bytes;
+		std::atomic<int64_t> live;
+		std::atomic<uint64_t> allocations; // Since startup
+	};
+
+	inline static tag_stats m_stats[(size_t)memory_tag::COUNT] = {};
+	inline static thread_local memory_tag m_current = memory_tag::UNTAGGED;
+}; // memory_tracker
+
+/**
+* @brief Charges the calling thread's heap allocations to a tag from construction to destruction
+*/
+struct memory_scope {
+	memory_tag m_previous;
+
+	memory_scope(memory_tag tag) : m_previous(memory_tracker::m_current) {
+		memory_tracker::m_current = tag;
+	}
+
+	~memory_scope() {
+		memory_tracker::m_current = m_previous;
+	}
+
+	memory_scope(memory_scope&) = delete; // No copy constructor
+	memory_scope& operator=(const memory_scope&) = delete; // No copy assignment
+}; // memory_scope
+
+#endif // _MEMORY_TRACKER_HPP
@@ -1,26 +1,114 @@
 #include <glm/glm.hpp>
-#include <GLEW/glew.h>
-#include <stdexcept>
+#include "gl.hpp"
 #include <cstdint>
+#include <cstdio>
 #include <vector>
 
+#include "log.hpp"
 #include "material.hpp"
 #include "vertex.hpp"
 #include "mesh.hpp"
+#include "render_stats.hpp"
 
-void mesh::draw(material* mat) {
+void mesh::draw(material* mat, size_t lod) {
+	if (m_submeshes.empty()) {
+		bind(mat, mat->m_tex);
+		glDrawElements(GL_TRIANGLES, (GLsizei)m_indices.size(), GL_UNSIGNED_INT, NULL);
+
+		render_stats::draw_calls += 1;
+		render_stats::draw_ranges += 1;
+		return;
+	}
+
+	for (size_t index = 0; index < m_submeshes.size(); ++index) {
+		draw_submesh(mat, index, lod);
+	}
+}
+
+void mesh::draw_submesh(material* mat, size_t index, size_t lod) {
+	const mesh_lod& level = submesh_lod(index, lod);
+
+	bind(mat, mat->texture_for(m_submeshes[index].material));
+	glDrawElements(GL_TRIANGLES, (GLsizei)level.index_count, GL_UNSIGNED_INT, (void*)(uintptr_t)(level.first_index * sizeof(uint32_t)));
+
+	render_stats::draw_calls += 1;
+	render_stats::draw_ranges += 1;
+}
+
+void mesh::draw_submesh(material* mat, size_t index, const draw_ranges& ranges) {
+	if (ranges.counts.empty())
+		return; // Everything was culled
+
+	bind(mat, mat->texture_for(m_submeshes[index].material));
+	glMultiDrawElements(GL_TRIANGLES, ranges.counts.data(), GL_UNSIGNED_INT, ranges.offsets.data(), (GLsizei)ranges.counts.size());
+
+	render_stats::draw_calls += 1;
+	render_stats::draw_ranges += (uint32_t)ranges.counts.size();
+}
+
+const mesh_lod& mesh::submesh_lod(size_t index, size_t lod) const {
+	const std::vector<mesh_lod>& lods = m_submeshes[index].lods;
+
+	return lods[glm::min(lod, lods.size() - 1)];
+}
+
+size_t mesh::lod_count() const {
+	size_t count = 1;
+
+	for (const submesh& s : m_submeshes) {
+		count = glm::max(count, s.lods.size());
+	}
+
+	return count;
+}
+
+float mesh::lod_error(size_t lod) const {
+	float error = 0.0f;
+
+	for (size_t index = 0; index < m_submeshes.size(); ++index) {
+		error = glm::max(error, submesh_lod(index, lod).error);
+	}
+
+	return error;
+}
+
+void mesh::split_meshlets() {
+	m_meshlets.clear();
+
+	for (submesh& s : m_submeshes) {
+		for (mesh_lod& level : s.lods) {
+			std::vector<meshlet> meshlets = build_meshlets(m_vertices, m_indices, level.first_index, level.index_count);
+
+			level.first_meshlet = (uint32_t)m_meshlets.size();
+			level.meshlet_count = (uint32_t)meshlets.size();
+
+			m_meshlets.insert(m_meshlets.end(), meshlets.begin(), meshlets.end());
+		}
+	}
+}
+
+void mesh::bind(material* mat, texture* tex) {
 	upload(mat);
 
-	if (mat->m_tex) { // Not all materials have textures
+	if (tex) { // Not all materials have textures
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, mat->m_tex->m_handle);
+		glBindTexture(GL_TEXTURE_2D, tex->m_handle);
+
+		render_stats::texture_binds += 1;
+	}
+
+	// Attributes stored once per mesh come from the generic attribute value
+	for (uint32_t semantic = 0; semantic < VERTEX_ATTR_COUNT; ++semantic) {
+		if (m_format.constants & (1u << semantic)) {
+			glVertexAttrib4fv(semantic, &m_encoding.constants[semantic][0]);
+		}
 	}
 
 	// Rebind the buffers
 	glBindVertexArray(vao);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
 
-	glDrawElements(GL_TRIANGLES, (GLsizei)m_indices.size(), GL_UNSIGNED_INT, NULL);
+	render_stats::vao_binds += 1;
 }
 
 void mesh::load_mesh(float* raw_vertices, size_t indecies) {
@@ -43,11 +131,36 @@ void mesh::load_mesh(float* raw_vertices, size_t indecies) {
 		vert.m_normal = glm::vec3(0.0f, 1.0f, 0.0f);
 
 		m_vertices.push_back(vert);
+		m_indices.push_back((uint32_t)m_indices.size());
 	}
+
+	compute_bounds();
 }
 
-inline bool mesh::isUploaded() const {
-	return vao != -1;
+void mesh::compute_bounds() {
+	if (m_vertices.empty()) {
+		return;
+	}
+
+	glm::vec3 min = m_vertices[0].m_pos;
+	glm::vec3 max = m_vertices[0].m_pos;
+
+	for (const vertex& v : m_vertices) {
+		min = glm::min(min, v.m_pos);
+		max = glm::max(max, v.m_pos);
+	}
+
+	m_center = (min + max) * 0.5f;
+	m_extent = (max - min) * 0.5f;
+	m_radius = 0.0f;
+
+	for (const vertex& v : m_vertices) {
+		m_radius = glm::max(m_radius, glm::length(v.m_pos - m_center));
+	}
+
+	// Quantized positions are stored relative to the bounding box, a flat axis still needs a non-zero scale
+	m_encoding.offset = m_center;
+	m_encoding.scale = glm::max(m_extent, glm::vec3(1e-6f));
 }
 
 void mesh::upload(material* mat) {
@@ -59,10 +172,30 @@ void mesh::upload(material* mat) {
 	glGenVertexArrays(1, &vao);
 	glBindVertexArray(vao);
 
+	// Pack the vertices into the mesh layout
+	choose_constants();
+
+	std::vector<unsigned char> packed(m_vertices.size() * m_format.stride);
+	m_format.pack(m_vertices.data(), m_vertices.size(), m_encoding, packed.data());
+
+#ifdef _DEBUG
+	// Round trip the packed data to catch formats too coarse for this mesh
+	vertex_error error = m_format.error(m_vertices.data(), m_vertices.size(), m_encoding, packed.data());
+
+	LOG_DEBUG(MESH, "Packed %zu vertices into %u bytes each (%zu bytes), max error: position %g, color %g, normal %g deg, texcoord %g, tangent %g deg",
+		m_vertices.size(), m_format.stride, packed.size(),
+		error[(size_t)vertex_attr::VERTEX], error[(size_t)vertex_attr::COLOR], error[(size_t)vertex_attr::NORMAL], error[(size_t)vertex_attr::TEXCOORD], error[(size_t)vertex_attr::TANGENT]);
+
+	if (error[(size_t)vertex_attr::VERTEX] > m_radius * 1e-3f || error[(size_t)vertex_attr::NORMAL] > 1.0f || error[(size_t)vertex_attr::TEXCOORD] > 1e-3f || error[(size_t)vertex_attr::COLOR] > 1.0f / 255.0f
+		|| error[(size_t)vertex_attr::TANGENT] > 1.0f) {
+		LOG_ERROR(MESH, "Vertex layout loses precision on this mesh");
+	}
+#endif
+
 	// Generate the vertex buffer object
 	glGenBuffers(1, &vbo);
 	glBindBuffer(GL_ARRAY_BUFFER, vbo);
-	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(vertex), m_vertices.data(), GL_STATIC_DRAW);
+	glBufferData(GL_ARRAY_BUFFER, packed.size(), packed.data(), GL_STATIC_DRAW);
 
 	// Generate the element buffer object
 	glGenBuffers(1, &ibo);
@@ -70,25 +203,40 @@ void mesh::upload(material* mat) {
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(uint32_t), m_indices.data(), GL_STATIC_DRAW);
 
 	// Set vertex attribute pointers
-	for (auto& [name, loc] : mat->m_attributes) {
-		if (name == vertexAttr(vertex_attr::VERTEX)) {
-			glEnableVertexAttribArray(loc);
-			glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, m_pos));
-		}
-		else if (name == vertexAttr(vertex_attr::COLOR)) {
-			glEnableVertexAttribArray(loc);
-			glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, m_color));
-		}
-		else if (name == vertexAttr(vertex_attr::TEXCOORD)) {
-			glEnableVertexAttribArray(loc);
-			glVertexAttribPointer(loc, 2, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, m_texCoord));
-		}
-		else if (name == vertexAttr(vertex_attr::NORMAL)) {
-			glEnableVertexAttribArray(loc);
-			glVertexAttribPointer(loc, 3, GL_FLOAT, GL_FALSE, sizeof(vertex), (void*)offsetof(vertex, m_normal));
+	m_format.setup();
+
+	// Every input the shader reads must come from the layout (or be a per mesh constant)
+	for (const reflected_attribute& attribute : mat->m_shader->m_reflection.attributes) {
+		if (attribute.location < 0 || attribute.location >= 32 || !(m_format.semantics & (1u << attribute.location))) {
+			LOG_ERROR(MESH, "Vertex layout does not provide shader input %s", attribute.name.c_str());
 		}
-		else {
-			throw std::invalid_argument("Unknown vertex attribute: " + std::string(name));
+	}
+}
+
+void mesh::choose_constants() {
+	if (!m_format.constants || m_vertices.empty()) {
+		return;
+	}
+
+	for (uint32_t semantic = 0; semantic < VERTEX_ATTR_COUNT; ++semantic) {
+		if (!(m_format.constants & (1u << semantic)))
+			continue;
+
+		glm::vec4 value = vertex_source(m_vertices[0], (vertex_attr)semantic);
+		m_encoding.constants[semantic] = value;
+
+		for (const vertex& v : m_vertices) {
+			if (vertex_source(v, (vertex_attr)semantic) == value)
+				continue;
+
+			if (!m_format.fallback) {
+				LOG_ERROR(MESH, "Vertex %s is not uniform but the layout stores one value per mesh", vertexAttr((vertex_attr)semantic));
+				break;
+			}
+
+			// Store it per vertex after all, the fallback declares the same shader inputs
+			m_format = m_format.fallback();
+			return;
 		}
 	}
-}
\ No newline at end of file
+}
@@ -2,19 +2,50 @@
 #define _MESH_HPP
 
 #include <glm/glm.hpp>
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <cstdint>
+#include <string>
 #include <vector>
 
 #include "material.hpp"
 #include "vertex.hpp"
+#include "vertex_layout.hpp"
+#include "mesh_simplifier.hpp"
+#include "meshlet.hpp"
+
+/**
+* @brief Surface properties of a submesh, from the MTL file
+*/
+struct mesh_material {
+	std::string name;
+	glm::vec3 diffuse = glm::vec3(1.0f);
+	std::string diffuse_texture; // map_Kd, relative to the OBJ directory (empty if none)
+};
+
+/**
+* @brief The triangles of one material, drawn as index ranges of the shared buffers
+*/
+struct submesh {
+	uint32_t material;          // Index into mesh::m_materials
+	std::vector<mesh_lod> lods; // Finest first, all ranges of mesh::m_indices
+};
 
 struct mesh {
 	GLuint vao, vbo, ibo;
 	std::vector<vertex> m_vertices;
 	std::vector<uint32_t> m_indices;
+	std::vector<submesh> m_submeshes; // Empty: one submesh with every index and no LODs
+	std::vector<mesh_material> m_materials;
+	std::vector<meshlet> m_meshlets; // Meshlets of every submesh LOD, see mesh_lod::first_meshlet
+
+	glm::vec3 m_center; // Bounding sphere (model space)
+	float m_radius;
+	glm::vec3 m_extent; // Half size of the bounding box around m_center
 
-	mesh() : m_vertices(std::vector<vertex>()), m_indices(std::vector<uint32_t>()), vao(-1), vbo(-1), ibo(-1) {}
+	vertex_format m_format;     // GPU layout the vertices are packed into on upload
+	vertex_encoding m_encoding; // Decode parameters of the quantized formats
+
+	mesh() : m_vertices(std::vector<vertex>()), m_indices(std::vector<uint32_t>()), vao(-1), vbo(-1), ibo(-1), m_center(0.0f), m_radius(0.0f), m_extent(0.0f), m_format(make_vertex_format<vertex_layout_full>()) {}
 
 	~mesh() {
 		if (isUploaded()) {
@@ -25,25 +56,80 @@ struct mesh {
 
 		m_vertices.clear();
 		m_indices.clear();
+		m_submeshes.clear();
+		m_materials.clear();
+		m_meshlets.clear();
 	}
 
 	mesh(const mesh&) = delete; // No copy constructor
 	mesh& operator=(const mesh&) = delete; // No copy assignment
 
-	void draw(material* mat);
+	/**
+	* @brief Draw every submesh at one level of detail (clamped to each submesh's coarsest level)
+	*/
+	void draw(material* mat, size_t lod = 0);
+
+	/**
+	* @brief Draw one submesh at one level of detail
+	*/
+	void draw_submesh(material* mat, size_t index, size_t lod);
 
 	/**
-	* @brief Load a mesh from raw vertex data (positions only)
+	* @brief Draw the index ranges of one submesh left by cull_meshlets
+	*/
+	void draw_submesh(material* mat, size_t index, const draw_ranges& ranges);
+
+	/**
+	* @brief The LOD of a submesh that draws for lod (the coarsest one past its chain)
+	*/
+	const mesh_lod& submesh_lod(size_t index, size_t lod) const;
+
+	/**
+	* @brief Number of levels of the longest submesh LOD chain
+	*/
+	size_t lod_count() const;
+
+	/**
+	* @brief Largest error of any submesh at lod
+	*/
+	float lod_error(size_t lod) const;
+
+	/**
+	* @brief Split every submesh LOD into meshlets (after the LODs are built)
+	*/
+	void split_meshlets();
+
+	/**
+	* @brief Choose the GPU vertex layout (before the first draw)
+	*
+	* @tparam Fallback Layout used instead when an attribute Layout stores as CONSTANT differs between vertices
+	*/
+	template<typename Layout, typename Fallback = Layout>
+	void set_layout() {
+		m_format = make_vertex_format<Layout, Fallback>();
+	}
+
+	/**
+	* @brief Load a mesh from raw vertex data (positions only, one index per vertex)
 	* 
 	* @param raw_vertices Pointer to raw vertex data (float array of x, y, z positions)
 	* @param indecies Number of vertices (not number of floats)
 	*/
 	void load_mesh(float* raw_vertices, size_t indecies);
 
+	/**
+	* @brief Compute the bounding box and sphere of the vertices
+	*/
+	void compute_bounds();
+
 private:
-	inline bool isUploaded() const;
+	bool isUploaded() const { return vao != -1; }
 
 	void upload(material* mat);
+
+	void bind(material* mat, texture* tex);
+
+	void choose_constants();
 }; // mesh
 
 #endif // _MESH_HPP
\ No newline at end of file
@@ -0,0 +1,252 @@
+#include <glm/glm.hpp>
+#include <filesystem>
+#include <fstream>
+#include <cstdint>
+#include <cfloat>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "log.hpp"
+#include "memory_tracker.hpp"
+#include "vertex.hpp"
+#include "mesh.hpp"
+#include "mesh_cooked.hpp"
+
+constexpr uint32_t COOKED_MESH_MAGIC = 0x4d4c474c; // "LGLM"
+constexpr uint32_t COOKED_MESH_VERSION = 1;
+
+struct cooked_mesh_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t vertex_size; // sizeof(vertex) of the writer
+	uint32_t material_count;
+	uint32_t chunk_count;
+	glm::vec3 min, max;
+};
+
+struct cooked_chunk_header {
+	uint32_t vertex_count;
+	uint32_t index_count;
+	uint32_t submesh_count;
+};
+
+struct cooked_lod {
+	uint32_t first_index;
+	uint32_t index_count;
+	float error;
+};
+
+static void write_string(std::ofstream& file, const std::string& str) {
+	uint32_t length = (uint32_t)str.size();
+
+	file.write((const char*)&length, sizeof(length));
+	file.write(str.data(), length);
+}
+
+static bool read_string(std::ifstream& file, std::string& str) {
+	uint32_t length = 0;
+	file.read((char*)&length, sizeof(length));
+
+	if (!file || length > 4096)
+		return false;
+
+	str.resize(length);
+	file.read(str.data(), length);
+
+	return (bool)file;
+}
+
+cooked_mesh_writer::cooked_mesh_writer(const std::string& path) : m_path(path), m_temp_path(path + ".tmp"), m_material_count(0), m_chunk_count(0), m_min(FLT_MAX), m_max(-FLT_MAX) {}
+
+cooked_mesh_writer::~cooked_mesh_writer() {
+	if (m_file.is_open()) {
+		// Never finished: drop the partial file
+		m_file.close();
+
+		std::error_code ec;
+		std::filesystem::remove(m_temp_path, ec);
+	}
+}
+
+bool cooked_mesh_writer::begin(const std::vector<mesh_material>& materials) {
+	m_file.open(m_temp_path, std::ios::binary | std::ios::trunc);
+	if (!m_file.is_open()) {
+		LOG_ERROR(MESH, "Failed to write cooked mesh %s", m_temp_path.c_str());
+		return false;
+	}
+
+	m_material_count = (uint32_t)materials.size();
+
+	// Placeholder, finish() writes the real header once the chunks are known
+	cooked_mesh_header header = {};
+	m_file.write((const char*)&header, sizeof(header));
+
+	for (const mesh_material& mat : materials) {
+		write_string(m_file, mat.name);
+		m_file.write((const char*)&mat.diffuse, sizeof(mat.diffuse));
+		write_string(m_file, mat.diffuse_texture);
+	}
+
+	return (bool)m_file;
+} // begin
+
+bool cooked_mesh_writer::write_chunk(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<submesh>& submeshes) {
+	cooked_chunk_header header = { (uint32_t)vertices.size(), (uint32_t)indices.size(), (uint32_t)submeshes.size() };
+	m_file.write((const char*)&header, sizeof(header));
+
+	for (const submesh& s : submeshes) {
+		uint32_t lod_count = (uint32_t)s.lods.size();
+
+		m_file.write((const char*)&s.material, sizeof(s.material));
+		m_file.write((const char*)&lod_count, sizeof(lod_count));
+
+		for (const mesh_lod& level : s.lods) {
+			cooked_lod lod = { level.first_index, level.index_count, level.error };
+			m_file.write((const char*)&lod, sizeof(lod));
+		}
+	}
+
+	m_file.write((const char*)vertices.data(), vertices.size() * sizeof(vertex));
+	m_file.write((const char*)indices.data(), indices.size() * sizeof(uint32_t));
+
+	for (const vertex& v : vertices) {
+		m_min = glm::min(m_min, v.m_pos);
+		m_max = glm::max(m_max, v.m_pos);
+	}
+
+	++m_chunk_count;
+
+	return (bool)m_file;
+} // write_chunk
+
+bool cooked_mesh_writer::finish() {
+	cooked_mesh_header header = { COOKED_MESH_MAGIC, COOKED_MESH_VERSION, (uint32_t)sizeof(vertex), m_material_count, m_chunk_count, m_min, m_max };
+
+	m_file.seekp(0);
+	m_file.write((const char*)&header, sizeof(header));
+	m_file.close();
+
+	if (!m_file) {
+		LOG_ERROR(MESH, "Failed to write cooked mesh %s", m_temp_path.c_str());
+
+		std::error_code ec;
+		std::filesystem::remove(m_temp_path, ec);
+		return false;
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(m_temp_path, m_path, ec);
+
+	if (ec) {
+		LOG_ERROR(MESH, "Failed to write cooked mesh %s", m_path.c_str());
+		std::filesystem::remove(m_temp_path, ec);
+		return false;
+	}
+
+	return true;
+} // finish
+
+bool load_cooked_mesh(const char* filename, mesh* mesh) {
+	memory_scope scope(memory_tag::MESHES);
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open()) {
+		LOG_ERROR(MESH, "Failed to open cooked mesh %s", filename);
+		return false;
+	}
+
+	cooked_mesh_header header = {};
+	file.read((char*)&header, sizeof(header));
+
+	if (!file || header.magic != COOKED_MESH_MAGIC || header.version != COOKED_MESH_VERSION || header.vertex_size != sizeof(vertex)) {
+		LOG_ERROR(MESH, "Invalid cooked mesh %s", filename);
+		return false;
+	}
+
+	for (uint32_t m = 0; m < header.material_count; ++m) {
+		mesh_material mat;
+
+		if (!read_string(file, mat.name) || !file.read((char*)&mat.diffuse, sizeof(mat.diffuse)) || !read_string(file, mat.diffuse_texture)) {
+			LOG_ERROR(MESH, "Truncated cooked mesh %s", filename);
+			return false;
+		}
+
+		mesh->m_materials.push_back(mat);
+	}
+
+	std::vector<vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	for (uint32_t c = 0; c < header.chunk_count; ++c) {
+		cooked_chunk_header chunk = {};
+		file.read((char*)&chunk, sizeof(chunk));
+
+		if (!file || (uint64_t)mesh->m_vertices.size() + chunk.vertex_count > UINT32_MAX || (uint64_t)mesh->m_indices.size() + chunk.index_count > UINT32_MAX) {
+			LOG_ERROR(MESH, "Truncated or oversized cooked mesh %s", filename);
+			return false;
+		}
+
+		uint32_t base_vertex = (uint32_t)mesh->m_vertices.size();
+		uint32_t base_index = (uint32_t)mesh->m_indices.size();
+
+		// Chunk ranges become ranges of the shared buffers
+		for (uint32_t s = 0; s < chunk.submesh_count; ++s) {
+			submesh sub = {};
+			uint32_t lod_count = 0;
+
+			file.read((char*)&sub.material, sizeof(sub.material));
+			file.read((char*)&lod_count, sizeof(lod_count));
+
+			if (!file || lod_count == 0 || lod_count > MAX_MESH_LODS || sub.material >= header.material_count) {
+				LOG_ERROR(MESH, "Invalid submesh in cooked mesh %s", filename);
+				return false;
+			}
+
+			for (uint32_t l = 0; l < lod_count; ++l) {
+				cooked_lod lod = {};
+				file.read((char*)&lod, sizeof(lod));
+
+				if (!file || (uint64_t)lod.first_index + lod.index_count > chunk.index_count) {
+					LOG_ERROR(MESH, "Invalid submesh in cooked mesh %s", filename);
+					return false;
+				}
+
+				sub.lods.push_back({ base_index + lod.first_index, lod.index_count, lod.error });
+			}
+
+			mesh->m_submeshes.push_back(sub);
+		}
+
+		vertices.resize(chunk.vertex_count);
+		indices.resize(chunk.index_count);
+
+		file.read((char*)vertices.data(), vertices.size() * sizeof(vertex));
+		file.read((char*)indices.data(), indices.size() * sizeof(uint32_t));
+
+		if (!file) {
+			LOG_ERROR(MESH, "Truncated cooked mesh %s", filename);
+			return false;
+		}
+
+		for (uint32_t& index : indices) {
+			if (index >= chunk.vertex_count) {
+				LOG_ERROR(MESH, "Invalid index in cooked mesh %s", filename);
+				return false;
+			}
+
+			index += base_vertex;
+		}
+
+		mesh->m_vertices.insert(mesh->m_vertices.end(), vertices.begin(), vertices.end());
+		mesh->m_indices.insert(mesh->m_indices.end(), indices.begin(), indices.end());
+	}
+
+	mesh->split_meshlets();
+	mesh->compute_bounds();
+
+	LOG_INFO(MESH, "Successfully Loaded cooked mesh: %s", filename);
+	LOG_DEBUG(MESH, "%u chunk(s), %zu submesh(es), %zu vertices, %zu triangles", header.chunk_count, mesh->m_submeshes.size(), mesh->m_vertices.size(), mesh->m_indices.size() / 3);
+
+	return true;
+} // load_cooked_mesh
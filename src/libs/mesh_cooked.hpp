@@ -0,0 +1,64 @@
+#ifndef _MESH_COOKED_HPP
+#define _MESH_COOKED_HPP
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "vertex.hpp"
+#include "mesh.hpp"
+
+/**
+* @brief Writes a cooked mesh file one chunk at a time
+*
+* A cooked mesh is its materials followed by independent chunks, each with its own
+* vertices, chunk-local indices and submeshes (LODs included), so a writer never
+* holds more than the chunk it is writing. Everything goes to a temporary file that
+* finish() renames, a failed import never leaves a half written mesh behind.
+*/
+class cooked_mesh_writer {
+public:
+	cooked_mesh_writer(const std::string& path);
+
+	~cooked_mesh_writer();
+
+	cooked_mesh_writer(cooked_mesh_writer&) = delete; // No copy constructor
+	cooked_mesh_writer& operator=(const cooked_mesh_writer&) = delete; // No copy assignment
+
+	/**
+	* @brief Open the temporary file and write the materials
+	*/
+	bool begin(const std::vector<mesh_material>& materials);
+
+	/**
+	* @brief Append one chunk, submesh LOD ranges index the chunk's own indices
+	*/
+	bool write_chunk(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<submesh>& submeshes);
+
+	/**
+	* @brief Write the final header and move the file into place
+	*/
+	bool finish();
+
+	uint32_t chunk_count() const { return m_chunk_count; }
+
+private:
+	std::string m_path;
+	std::string m_temp_path;
+	std::ofstream m_file;
+
+	uint32_t m_material_count;
+	uint32_t m_chunk_count;
+	glm::vec3 m_min, m_max;
+}; // cooked_mesh_writer
+
+/**
+* @brief Load a cooked mesh, every chunk becomes submeshes of the one mesh
+*
+* @return bool True if the file was valid and fully read
+*/
+bool load_cooked_mesh(const char* filename, mesh* mesh);
+
+#endif // _MESH_COOKED_HPP
@@ -0,0 +1,362 @@
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cfloat>
+#include <cstdio>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "log.hpp"
+#include "vertex.hpp"
+#include "mesh_normals.hpp"
+
+constexpr size_t MIN_PARALLEL_ITEMS = 4096; // Below this a loop runs on the calling thread
+
+/**
+* @brief Run fn(begin, end) over [0, count) split across the hardware threads
+*/
+template<typename F>
+static void parallel_for(size_t count, F fn) {
+	size_t threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	threads = std::min(threads, (count + MIN_PARALLEL_ITEMS - 1) / MIN_PARALLEL_ITEMS);
+
+	if (threads <= 1) {
+		fn((size_t)0, count);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	workers.reserve(threads - 1);
+
+	size_t chunk = (count + threads - 1) / threads;
+
+	for (size_t t = 1; t < threads; ++t) {
+		size_t begin = t * chunk;
+		size_t end = std::min(count, begin + chunk);
+
+		if (begin < end) {
+			workers.emplace_back(fn, begin, end);
+		}
+	}
+
+	fn((size_t)0, std::min(count, chunk));
+
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+} // parallel_for
+
+glm::vec3 face_normal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float* angles) {
+	glm::vec3 e01 = p1 - p0, e12 = p2 - p1, e20 = p0 - p2;
+	glm::vec3 n = glm::cross(e01, -e20);
+	float length = glm::length(n);
+
+	float l01 = glm::length(e01), l12 = glm::length(e12), l20 = glm::length(e20);
+	if (l01 <= 0.0f || l12 <= 0.0f || l20 <= 0.0f) {
+		angles[0] = angles[1] = angles[2] = 0.0f;
+	}
+	else {
+		angles[0] = glm::acos(glm::clamp(glm::dot(e01, -e20) / (l01 * l20), -1.0f, 1.0f));
+		angles[1] = glm::acos(glm::clamp(glm::dot(e12, -e01) / (l12 * l01), -1.0f, 1.0f));
+		angles[2] = glm::pi<float>() - angles[0] - angles[1];
+	}
+
+	return length > 0.0f ? n / length : glm::vec3(0.0f);
+} // face_normal
+
+/**
+* @brief Unit face normal and the three corner angles of every triangle
+*/
+static void face_data(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, std::vector<glm::vec3>& normals, std::vector<float>& angles) {
+	size_t triangle_count = indices.size() / 3;
+
+	normals.resize(triangle_count);
+	angles.resize(indices.size());
+
+	parallel_for(triangle_count, [&](size_t begin, size_t end) {
+		for (size_t t = begin; t < end; ++t) {
+			normals[t] = face_normal(vertices[indices[t * 3 + 0]].m_pos, vertices[indices[t * 3 + 1]].m_pos, vertices[indices[t * 3 + 2]].m_pos, &angles[t * 3]);
+		}
+	});
+} // face_data
+
+/**
+* @brief Packed key -> corner lists (offsets has one entry per key plus one)
+*/
+static void group_corners(const std::vector<uint32_t>& corner_key, size_t key_count, std::vector<uint32_t>& offsets, std::vector<uint32_t>& corners) {
+	offsets.assign(key_count + 1, 0);
+	for (uint32_t key : corner_key) {
+		++offsets[key + 1];
+	}
+
+	for (size_t k = 0; k < key_count; ++k) {
+		offsets[k + 1] += offsets[k];
+	}
+
+	corners.resize(corner_key.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+	for (uint32_t i = 0; i < corner_key.size(); ++i) {
+		corners[fill[corner_key[i]]++] = i;
+	}
+} // group_corners
+
+void generate_normals(std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, float crease_degrees, bool only_missing) {
+	if (indices.empty())
+		return;
+
+	std::vector<glm::vec3> face_normals;
+	std::vector<float> angles;
+	face_data(vertices, indices, face_normals, angles);
+
+	// Corners sharing a position, whatever their other attributes
+	std::unordered_map<glm::vec3, uint32_t> positions;
+	std::vector<uint32_t> position_id(vertices.size());
+	positions.reserve(vertices.size());
+
+	for (size_t v = 0; v < vertices.size(); ++v) {
+		position_id[v] = positions.emplace(vertices[v].m_pos, (uint32_t)positions.size()).first->second;
+	}
+
+	std::vector<uint32_t> corner_position(indices.size());
+	for (size_t i = 0; i < indices.size(); ++i) {
+		corner_position[i] = position_id[indices[i]];
+	}
+
+	std::vector<uint32_t> offsets, corners;
+	group_corners(corner_position, positions.size(), offsets, corners);
+
+	float cos_crease = glm::cos(glm::radians(crease_degrees));
+
+	parallel_for(vertices.size(), [&](size_t begin, size_t end) {
+		for (size_t v = begin; v < end; ++v) {
+			if (only_missing && vertices[v].m_normal != glm::vec3(0.0f))
+				continue;
+
+			uint32_t first = offsets[position_id[v]], last = offsets[position_id[v] + 1];
+
+			// Facing of the faces that use this vertex
+			glm::vec3 reference(0.0f);
+			for (uint32_t c = first; c < last; ++c) {
+				if (indices[corners[c]] == v) {
+					reference += face_normals[corners[c] / 3];
+				}
+			}
+
+			float length = glm::length(reference);
+			if (length <= 0.0f)
+				continue; // Unreferenced or degenerate
+
+			reference /= length;
+
+			// Every face around the position within the crease angle, by corner angle
+			glm::vec3 normal(0.0f);
+			for (uint32_t c = first; c < last; ++c) {
+				const glm::vec3& face = face_normals[corners[c] / 3];
+
+				if (glm::dot(face, reference) >= cos_crease) {
+					normal += face * angles[corners[c]];
+				}
+			}
+
+			length = glm::length(normal);
+			vertices[v].m_normal = length > 0.0f ? normal / length : reference;
+		}
+	});
+} // generate_normals
+
+void normal_clusters::add(const glm::vec3& face, float angle, float cos_crease) {
+	if (angle <= 0.0f)
+		return; // Degenerate face
+
+	size_t best = 0;
+	float best_dot = -FLT_MAX;
+
+	for (size_t k = 0; k < NORMAL_CLUSTERS; ++k) {
+		float length = glm::length(m_sums[k]);
+
+		// A free cluster is only started when no earlier one is within the crease angle
+		if (length <= 0.0f) {
+			if (best_dot < cos_crease) {
+				best = k;
+			}
+
+			break;
+		}
+
+		float d = glm::dot(face, m_sums[k]) / length;
+		if (d > best_dot) {
+			best_dot = d;
+			best = k;
+		}
+	}
+
+	m_sums[best] += face * angle;
+} // normal_clusters::add
+
+glm::vec3 normal_clusters::normal(const glm::vec3& face) const {
+	glm::vec3 best(0.0f);
+	float best_dot = -FLT_MAX;
+
+	for (const glm::vec3& sum : m_sums) {
+		float length = glm::length(sum);
+		if (length <= 0.0f)
+			break;
+
+		float d = glm::dot(face, sum) / length;
+		if (d > best_dot) {
+			best_dot = d;
+			best = sum / length;
+		}
+	}
+
+	return best;
+} // normal_clusters::normal
+
+void generate_tangents(std::vector<vertex>& vertices, std::vector<uint32_t>& indices) {
+	if (indices.empty())
+		return;
+
+	std::vector<glm::vec3> face_normals;
+	std::vector<float> angles;
+	face_data(vertices, indices, face_normals, angles);
+
+	// Per corner: face tangent projected on the vertex normal, angle weighted, and the UV handedness
+	std::vector<glm::vec3> corner_tangent(indices.size());
+	std::vector<int8_t> corner_sign(indices.size());
+
+	parallel_for(indices.size() / 3, [&](size_t begin, size_t end) {
+		for (size_t t = begin; t < end; ++t) {
+			const vertex& v0 = vertices[indices[t * 3 + 0]];
+			const vertex& v1 = vertices[indices[t * 3 + 1]];
+			const vertex& v2 = vertices[indices[t * 3 + 2]];
+
+			glm::vec3 e1 = v1.m_pos - v0.m_pos, e2 = v2.m_pos - v0.m_pos;
+			glm::vec2 d1 = v1.m_texCoord - v0.m_texCoord, d2 = v2.m_texCoord - v0.m_texCoord;
+
+			// The sign of the UV area decides the handedness, its size is not used (as in MikkTSpace)
+			float det = d1.x * d2.y - d2.x * d1.y;
+			glm::vec3 tangent = det != 0.0f ? e1 * d2.y - e2 * d1.y : glm::vec3(0.0f);
+			int8_t sign = det < 0.0f ? -1 : 1;
+
+			if (det < 0.0f) {
+				tangent = -tangent;
+			}
+
+			for (size_t k = 0; k < 3; ++k) {
+				glm::vec3 n = glm::normalize(vertices[indices[t * 3 + k]].m_normal);
+				glm::vec3 projected = tangent - n * glm::dot(n, tangent);
+				float length = glm::length(projected);
+
+				corner_tangent[t * 3 + k] = length > 0.0f ? projected * (angles[t * 3 + k] / length) : glm::vec3(0.0f);
+				corner_sign[t * 3 + k] = sign;
+			}
+		}
+	});
+
+	std::vector<uint32_t> offsets, corners;
+	group_corners(indices, vertices.size(), offsets, corners);
+
+	// Corners of the minority handedness at a vertex, the vertex is split for them
+	std::vector<uint8_t> split(vertices.size(), 0);
+
+	parallel_for(vertices.size(), [&](size_t begin, size_t end) {
+		for (size_t v = begin; v < end; ++v) {
+			glm::vec3 sum[2] = { glm::vec3(0.0f), glm::vec3(0.0f) }; // Right, left handed
+			float weight[2] = { 0.0f, 0.0f };
+
+			for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+				uint32_t corner = corners[c];
+				int side = corner_sign[corner] < 0;
+
+				sum[side] += corner_tangent[corner];
+				weight[side] += angles[corner];
+			}
+
+			int side = weight[1] > weight[0];
+			vertices[v].m_tangent = tangent_encode(vertices[v].m_normal, sum[side], side ? -1.0f : 1.0f);
+
+			if (weight[side ^ 1] > 0.0f) {
+				split[v] = 1;
+			}
+		}
+	});
+
+	// Mirrored UV seams: give the other handedness its own vertex (rare, done serially)
+	size_t original = vertices.size();
+
+	for (size_t v = 0; v < original; ++v) {
+		if (!split[v])
+			continue;
+
+		int8_t kept = vertices[v].m_tangent < 0.0f ? -1 : 1;
+		glm::vec3 sum(0.0f);
+
+		for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+			if (corner_sign[corners[c]] != kept) {
+				sum += corner_tangent[corners[c]];
+			}
+		}
+
+		vertex mirrored = vertices[v];
+		mirrored.m_tangent = tangent_encode(mirrored.m_normal, sum, (float)-kept);
+
+		uint32_t index = (uint32_t)vertices.size();
+		vertices.push_back(mirrored);
+
+		for (uint32_t c = offsets[v]; c < offsets[v + 1]; ++c) {
+			if (corner_sign[corners[c]] != kept) {
+				indices[corners[c]] = index;
+			}
+		}
+	}
+} // generate_tangents
+
+void benchmark_normals_and_tangents(size_t triangle_count) {
+	// Wavy grid, one vertex per corner like a freshly loaded OBJ
+	size_t side = (size_t)glm::ceil(glm::sqrt((float)triangle_count / 2.0f));
+	std::vector<vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	vertices.reserve(side * side * 6);
+	indices.reserve(side * side * 6);
+
+	auto grid_vertex = [side](size_t x, size_t y) {
+		vertex v;
+		float u = (float)x / (float)side, w = (float)y / (float)side;
+
+		v.m_pos = glm::vec3(u, 0.1f * glm::sin(u * 40.0f) * glm::cos(w * 40.0f), w);
+		v.m_texCoord = glm::vec2(u, w);
+		v.m_normal = glm::vec3(0.0f);
+
+		return v;
+	};
+
+	for (size_t y = 0; y < side; ++y) {
+		for (size_t x = 0; x < side; ++x) {
+			const size_t quad[6][2] = { { x, y }, { x, y + 1 }, { x + 1, y }, { x + 1, y }, { x, y + 1 }, { x + 1, y + 1 } };
+
+			for (const auto& corner : quad) {
+				indices.push_back((uint32_t)vertices.size());
+				vertices.push_back(grid_vertex(corner[0], corner[1]));
+			}
+		}
+	}
+
+	auto start = std::chrono::high_resolution_clock::now();
+	generate_normals(vertices, indices);
+	auto normals_done = std::chrono::high_resolution_clock::now();
+	generate_tangents(vertices, indices);
+	auto tangents_done = std::chrono::high_resolution_clock::now();
+
+	double normals_ms = std::chrono::duration<double, std::milli>(normals_done - start).count();
+	double tangents_ms = std::chrono::duration<double, std::milli>(tangents_done - normals_done).count();
+	double triangles = (double)(indices.size() / 3);
+
+	LOG_DEBUG(MESH, "%.0f triangles on %u threads: normals %.1f ms (%.1f Mtri/s), tangents %.1f ms (%.1f Mtri/s)",
+		triangles, std::max(1u, std::thread::hardware_concurrency()),
+		normals_ms, triangles / normals_ms / 1000.0, tangents_ms, triangles / tangents_ms / 1000.0);
+} // benchmark_normals_and_tangents
@@ -0,0 +1,70 @@
+#ifndef _MESH_NORMALS_HPP
+#define _MESH_NORMALS_HPP
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertex.hpp"
+
+constexpr float DEFAULT_CREASE_ANGLE = 60.0f; // Degrees between two faces above which their shared edge stays sharp
+
+constexpr size_t NORMAL_CLUSTERS = 4; // Smoothing groups kept per position by normal_clusters
+
+/**
+* @brief Unit normal of the triangle p0 p1 p2, zero if it is degenerate
+*
+* @param angles Receives the three corner angles (radians, zero if degenerate)
+*/
+glm::vec3 face_normal(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float* angles);
+
+/**
+* @brief Angle weighted face normals around one position, grouped at the crease angle
+*
+* The out of core counterpart of generate_normals: every face adds itself to the
+* clusters of its three positions, then each corner takes the cluster closest to its
+* face. The result only depends on the faces around the position, not on which of
+* them are cooked together. Faces join the first cluster within the crease angle;
+* once all NORMAL_CLUSTERS are taken they join the closest one.
+*/
+struct normal_clusters {
+	glm::vec3 m_sums[NORMAL_CLUSTERS]; // Zero: unused, used clusters come first
+
+	void add(const glm::vec3& face, float angle, float cos_crease);
+
+	/**
+	* @brief Unit normal for a corner of a face, zero if no face was added
+	*/
+	glm::vec3 normal(const glm::vec3& face) const;
+};
+
+/**
+* @brief Smooth vertex normals, weighted by the corner angle of every adjacent face
+*
+* Faces meeting at more than crease_degrees are not averaged together, so hard edges
+* stay hard. Vertices are matched by position, call before deduplicate_vertices.
+*
+* @param only_missing Keep the normals that are already set (non-zero)
+*/
+void generate_normals(std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, float crease_degrees = DEFAULT_CREASE_ANGLE, bool only_missing = false);
+
+/**
+* @brief Per-vertex tangent frames from the texture coordinates, in the MikkTSpace convention
+*
+* Face tangents are weighted by the corner angle, summed over every corner sharing
+* position, normal, texcoord and handedness, then orthogonalised against the vertex
+* normal. The frame is packed into m_tangent (tangent_encode), which the quantized
+* layouts store in the spare w of the position. Runs on every hardware thread and
+* writes straight into the vertices; call after the normals are final.
+*
+* A vertex used with both handednesses (mirrored UVs) is split, the new vertex is appended.
+*/
+void generate_tangents(std::vector<vertex>& vertices, std::vector<uint32_t>& indices);
+
+/**
+* @brief Time generate_normals and generate_tangents on a grid of triangle_count triangles
+*/
+void benchmark_normals_and_tangents(size_t triangle_count);
+
+#endif // _MESH_NORMALS_HPP
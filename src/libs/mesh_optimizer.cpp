@@ -0,0 +1,364 @@
+#include <glm/glm.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "log.hpp"
+#include "vertex.hpp"
+#include "mesh_optimizer.hpp"
+
+vertex_cache_stats analyze_vertex_cache(const std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size) {
+	vertex_cache_stats stats = { 0.0f, 0.0f };
+
+	if (indices.empty() || vertex_count == 0)
+		return stats;
+
+	// A vertex is in the FIFO while fewer than cache_size misses happened since it was inserted
+	std::vector<size_t> inserted(vertex_count, 0);
+	size_t misses = 0;
+	size_t time = cache_size + 1;
+
+	for (uint32_t index : indices) {
+		if (time - inserted[index] > cache_size) {
+			inserted[index] = time++;
+			++misses;
+		}
+	}
+
+	stats.acmr = (float)misses / (float)(indices.size() / 3);
+	stats.atvr = (float)misses / (float)vertex_count;
+
+	return stats;
+} // analyze_vertex_cache
+
+size_t deduplicate_vertices(std::vector<vertex>& vertices, std::vector<uint32_t>& indices) {
+	std::unordered_map<vertex, uint32_t> unique;
+	std::vector<vertex> result;
+
+	unique.reserve(vertices.size());
+	result.reserve(vertices.size());
+
+	// Unique vertices keep the order of their first use, so the result is deterministic
+	for (uint32_t& index : indices) {
+		auto [it, inserted] = unique.emplace(vertices[index], (uint32_t)result.size());
+		if (inserted) {
+			result.push_back(vertices[index]);
+		}
+
+		index = it->second;
+	}
+
+	vertices.swap(result);
+
+	return vertices.size();
+} // deduplicate_vertices
+
+std::vector<index_range> group_triangles(std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangle_keys, std::vector<uint32_t>& range_keys) {
+	std::vector<uint32_t> order(triangle_keys.size());
+	for (uint32_t t = 0; t < order.size(); ++t) {
+		order[t] = t;
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return triangle_keys[a] < triangle_keys[b]; });
+
+	std::vector<index_range> ranges;
+	std::vector<uint32_t> sorted(indices.size());
+	range_keys.clear();
+
+	for (uint32_t i = 0; i < order.size(); ++i) {
+		uint32_t t = order[i];
+
+		if (ranges.empty() || range_keys.back() != triangle_keys[t]) {
+			ranges.push_back({ i * 3, 0 });
+			range_keys.push_back(triangle_keys[t]);
+		}
+
+		ranges.back().index_count += 3;
+
+		for (uint32_t k = 0; k < 3; ++k) {
+			sorted[i * 3 + k] = indices[t * 3 + k];
+		}
+	}
+
+	indices.swap(sorted);
+
+	return ranges;
+} // group_triangles
+
+void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, std::vector<size_t>* clusters, size_t cache_size) {
+	size_t triangle_count = indices.size() / 3;
+
+	if (clusters) {
+		clusters->clear();
+	}
+
+	if (triangle_count == 0)
+		return;
+
+	// Vertex -> triangle adjacency, packed
+	std::vector<uint32_t> offsets(vertex_count + 1, 0);
+	for (uint32_t index : indices) {
+		++offsets[index + 1];
+	}
+
+	for (size_t v = 0; v < vertex_count; ++v) {
+		offsets[v + 1] += offsets[v];
+	}
+
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+	for (size_t t = 0; t < triangle_count; ++t) {
+		for (size_t k = 0; k < 3; ++k) {
+			adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+		}
+	}
+
+	std::vector<uint32_t> live(vertex_count);
+	for (size_t v = 0; v < vertex_count; ++v) {
+		live[v] = offsets[v + 1] - offsets[v];
+	}
+
+	std::vector<size_t> cache_time(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<uint32_t> dead_end;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	size_t time = cache_size + 1;
+	size_t cursor = 0;
+	int64_t fanning = indices[0];
+
+	if (clusters) {
+		clusters->push_back(0);
+	}
+
+	while (fanning >= 0) {
+		candidates.clear();
+
+		// Emit every remaining triangle around the fanning vertex
+		for (uint32_t i = offsets[fanning]; i < offsets[fanning + 1]; ++i) {
+			uint32_t t = adjacency[i];
+			if (emitted[t])
+				continue;
+
+			for (size_t k = 0; k < 3; ++k) {
+				uint32_t v = indices[t * 3 + k];
+
+				result.push_back(v);
+				dead_end.push_back(v);
+				candidates.push_back(v);
+				--live[v];
+
+				if (time - cache_time[v] > cache_size) {
+					cache_time[v] = time++;
+				}
+			}
+
+			emitted[t] = true;
+		}
+
+		// Next fanning vertex: the candidate still in cache the longest that will stay there while its triangles are emitted
+		int64_t best = -1;
+		int64_t best_priority = -1;
+
+		for (uint32_t v : candidates) {
+			if (live[v] == 0)
+				continue;
+
+			int64_t priority = 0;
+			if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+				priority = (int64_t)(time - cache_time[v]);
+			}
+
+			if (priority > best_priority) {
+				best = v;
+				best_priority = priority;
+			}
+		}
+
+		if (best >= 0) {
+			fanning = best;
+			continue;
+		}
+
+		// Dead end: most recently used vertex with triangles left, else the next one in input order
+		fanning = -1;
+
+		while (!dead_end.empty()) {
+			uint32_t v = dead_end.back();
+			dead_end.pop_back();
+
+			if (live[v] > 0) {
+				fanning = v;
+				break;
+			}
+		}
+
+		while (fanning < 0 && cursor < vertex_count) {
+			if (live[cursor] > 0) {
+				fanning = (int64_t)cursor;
+			}
+
+			++cursor;
+		}
+
+		if (fanning >= 0 && clusters) {
+			clusters->push_back(result.size());
+		}
+	}
+
+	indices.swap(result);
+} // optimize_vertex_cache
+
+void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<vertex>& vertices, const std::vector<size_t>& clusters, float threshold) {
+	if (indices.empty() || clusters.empty())
+		return;
+
+	float target_acmr = analyze_vertex_cache(indices, vertices.size()).acmr * threshold;
+
+	// Split the hard clusters further wherever the cache would restart with little loss (soft boundaries)
+	std::vector<size_t> boundaries;
+	std::vector<size_t> cache_time(vertices.size(), 0);
+	size_t time = VERTEX_CACHE_SIZE + 1;
+
+	for (size_t c = 0; c < clusters.size(); ++c) {
+		size_t end = c + 1 < clusters.size() ? clusters[c + 1] : indices.size();
+		size_t start = clusters[c];
+		size_t misses = 0;
+
+		time += VERTEX_CACHE_SIZE + 1; // Flush
+		boundaries.push_back(start);
+
+		for (size_t i = start; i < end; i += 3) {
+			for (size_t k = 0; k < 3; ++k) {
+				uint32_t v = indices[i + k];
+
+				if (time - cache_time[v] > VERTEX_CACHE_SIZE) {
+					cache_time[v] = time++;
+					++misses;
+				}
+			}
+
+			size_t triangles = (i + 3 - start) / 3;
+			if (i + 3 < end && (float)misses / (float)triangles <= target_acmr) {
+				start = i + 3;
+				misses = 0;
+				time += VERTEX_CACHE_SIZE + 1;
+				boundaries.push_back(start);
+			}
+		}
+	}
+
+	// Sort key of a cluster: how far its surface faces out from the mesh centre
+	glm::vec3 mesh_center(0.0f);
+	for (const vertex& v : vertices) {
+		mesh_center += v.m_pos;
+	}
+
+	mesh_center /= (float)vertices.size();
+
+	struct cluster {
+		size_t start, end;
+		float key;
+	};
+
+	std::vector<cluster> sorted;
+	sorted.reserve(boundaries.size());
+
+	for (size_t b = 0; b < boundaries.size(); ++b) {
+		size_t start = boundaries[b];
+		size_t end = b + 1 < boundaries.size() ? boundaries[b + 1] : indices.size();
+
+		glm::vec3 centroid(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (size_t i = start; i < end; i += 3) {
+			const glm::vec3& p0 = vertices[indices[i + 0]].m_pos;
+			const glm::vec3& p1 = vertices[indices[i + 1]].m_pos;
+			const glm::vec3& p2 = vertices[indices[i + 2]].m_pos;
+
+			glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+			float a = glm::length(n);
+
+			centroid += (p0 + p1 + p2) * (a / 3.0f);
+			normal += n;
+			area += a;
+		}
+
+		float key = 0.0f;
+		float normal_length = glm::length(normal);
+
+		if (area > 0.0f && normal_length > 0.0f) {
+			key = glm::dot(centroid / area - mesh_center, normal / normal_length);
+		}
+
+		sorted.push_back({ start, end, key });
+	}
+
+	// Stable so equal keys keep the cache optimised order
+	std::stable_sort(sorted.begin(), sorted.end(), [](const cluster& a, const cluster& b) { return a.key > b.key; });
+
+	std::vector<uint32_t> result;
+	result.reserve(indices.size());
+
+	for (const cluster& c : sorted) {
+		result.insert(result.end(), indices.begin() + c.start, indices.begin() + c.end);
+	}
+
+	if (analyze_vertex_cache(result, vertices.size()).acmr <= target_acmr) {
+		indices.swap(result);
+	}
+} // optimize_overdraw
+
+void optimize_vertex_fetch(std::vector<vertex>& vertices, std::vector<uint32_t>& indices) {
+	std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+	std::vector<vertex> result;
+	result.reserve(vertices.size());
+
+	for (uint32_t& index : indices) {
+		if (remap[index] == UINT32_MAX) {
+			remap[index] = (uint32_t)result.size();
+			result.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices.swap(result);
+} // optimize_vertex_fetch
+
+void optimize_mesh(std::vector<vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<index_range>& ranges) {
+	if (indices.empty())
+		return;
+
+	vertex_cache_stats before = analyze_vertex_cache(indices, vertices.size());
+
+	std::vector<index_range> parts = ranges;
+	if (parts.empty()) {
+		parts.push_back({ 0, (uint32_t)indices.size() });
+	}
+
+	std::vector<uint32_t> part;
+	std::vector<size_t> clusters;
+
+	for (const index_range& range : parts) {
+		part.assign(indices.begin() + range.first_index, indices.begin() + range.first_index + range.index_count);
+
+		optimize_vertex_cache(part, vertices.size(), &clusters);
+		optimize_overdraw(part, vertices, clusters);
+
+		std::copy(part.begin(), part.end(), indices.begin() + range.first_index);
+	}
+
+	optimize_vertex_fetch(vertices, indices);
+
+	vertex_cache_stats after = analyze_vertex_cache(indices, vertices.size());
+
+	LOG_DEBUG(MESH, "Optimised mesh: %zu triangles, %zu vertices, ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+		indices.size() / 3, vertices.size(), before.acmr, after.acmr, before.atvr, after.atvr);
+} // optimize_mesh
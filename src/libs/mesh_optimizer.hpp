@@ -0,0 +1,81 @@
+#ifndef _MESH_OPTIMIZER_HPP
+#define _MESH_OPTIMIZER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertex.hpp"
+
+constexpr size_t VERTEX_CACHE_SIZE = 16; // Post-transform cache entries assumed by the optimiser
+
+/**
+* @brief A contiguous range of an index buffer (e.g. one submesh)
+*/
+struct index_range {
+	uint32_t first_index;
+	uint32_t index_count;
+};
+
+/**
+* @brief Post-transform cache efficiency of an index buffer (FIFO cache simulation)
+*/
+struct vertex_cache_stats {
+	float acmr; // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal on a regular grid, 3 is worst)
+	float atvr; // Average transformed vertex ratio: transformed vertices per unique vertex (1 is ideal)
+};
+
+/**
+* @brief Simulate a FIFO post-transform cache over a triangle list
+*/
+vertex_cache_stats analyze_vertex_cache(const std::vector<uint32_t>& indices, size_t vertex_count, size_t cache_size = VERTEX_CACHE_SIZE);
+
+/**
+* @brief Merge identical vertices and rebuild the index buffer
+*
+* @return size_t Number of unique vertices
+*/
+size_t deduplicate_vertices(std::vector<vertex>& vertices, std::vector<uint32_t>& indices);
+
+/**
+* @brief Reorder the triangles so every key (e.g. a material id) forms one contiguous range
+*
+* Stable: triangles with the same key keep their order.
+*
+* @param triangle_keys One key per triangle
+* @param range_keys Set to the key of every range
+*
+* @return std::vector<index_range> The ranges, by ascending key
+*/
+std::vector<index_range> group_triangles(std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangle_keys, std::vector<uint32_t>& range_keys);
+
+/**
+* @brief Reorder triangles for post-transform cache locality (Tipsify, Sander et al. 2007)
+*
+* @param clusters Filled with the index offset of every cluster start (where the fan search hit a dead end), may be null
+*/
+void optimize_vertex_cache(std::vector<uint32_t>& indices, size_t vertex_count, std::vector<size_t>* clusters = nullptr, size_t cache_size = VERTEX_CACHE_SIZE);
+
+/**
+* @brief Reorder the clusters of a cache optimised triangle list so outward facing surfaces are drawn first
+*
+* Clusters are only moved as a whole, and the order is kept only if the ACMR stays
+* within threshold times the cache optimised ACMR.
+*/
+void optimize_overdraw(std::vector<uint32_t>& indices, const std::vector<vertex>& vertices, const std::vector<size_t>& clusters, float threshold = 1.05f);
+
+/**
+* @brief Reorder vertices in the order the index buffer first references them, unreferenced vertices are dropped
+*/
+void optimize_vertex_fetch(std::vector<vertex>& vertices, std::vector<uint32_t>& indices);
+
+/**
+* @brief Run the cache, overdraw and fetch passes on a deduplicated mesh and report ACMR/ATVR before and after
+*
+* Triangles are only reordered inside each range, so submesh ranges stay valid
+* (no ranges: the whole buffer is one range). Every pass is deterministic: the same
+* input always gives the same output.
+*/
+void optimize_mesh(std::vector<vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<index_range>& ranges = {});
+
+#endif // _MESH_OPTIMIZER_HPP
@@ -0,0 +1,339 @@
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cfloat>
+#include <cstdio>
+#include <vector>
+
+#include "log.hpp"
+#include "vertex.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
+
+constexpr int MAX_SIMPLIFY_PASSES = 64;
+constexpr float MIN_LOD_REDUCTION = 0.85f; // A level must keep less than this fraction of the previous level's triangles
+
+/**
+* @brief Sum of squared distances to a set of planes, weighted by triangle area
+*/
+struct quadric {
+	double a2 = 0, ab = 0, ac = 0, ad = 0;
+	double b2 = 0, bc = 0, bd = 0;
+	double c2 = 0, cd = 0;
+	double d2 = 0;
+	double weight = 0;
+
+	void add_plane(const glm::dvec3& n, double d, double w) {
+		a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+		b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+		c2 += w * n.z * n.z; cd += w * n.z * d;
+		d2 += w * d * d;
+		weight += w;
+	}
+
+	void add(const quadric& q) {
+		a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+		b2 += q.b2; bc += q.bc; bd += q.bd;
+		c2 += q.c2; cd += q.cd;
+		d2 += q.d2;
+		weight += q.weight;
+	}
+
+	/**
+	* @brief Mean squared distance of p to the planes
+	*/
+	double error(const glm::dvec3& p) const {
+		double e = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+		         + b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+		         + c2 * p.z * p.z + 2 * cd * p.z
+		         + d2;
+
+		return weight > 0 ? glm::max(e, 0.0) / weight : 0.0;
+	}
+}; // quadric
+
+struct collapse {
+	uint32_t from, to;
+	double error;
+};
+
+/**
+* @brief Lock vertices on attribute seams and open borders
+*/
+static std::vector<bool> find_locked(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices) {
+	std::vector<bool> locked(vertices.size(), false);
+
+	// Seams: several vertices at one position
+	std::unordered_map<glm::vec3, uint32_t> positions;
+	std::vector<uint32_t> position_id(vertices.size());
+
+	for (uint32_t v = 0; v < vertices.size(); ++v) {
+		auto [it, inserted] = positions.emplace(vertices[v].m_pos, v);
+		position_id[v] = it->second;
+
+		if (!inserted) {
+			locked[v] = true;
+			locked[it->second] = true;
+		}
+	}
+
+	// Borders: edges (by position) used by one triangle only
+	std::unordered_map<uint64_t, uint32_t> edges;
+	edges.reserve(indices.size());
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		for (size_t k = 0; k < 3; ++k) {
+			uint32_t a = position_id[indices[i + k]];
+			uint32_t b = position_id[indices[i + (k + 1) % 3]];
+
+			++edges[((uint64_t)glm::min(a, b) << 32) | glm::max(a, b)];
+		}
+	}
+
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		for (size_t k = 0; k < 3; ++k) {
+			uint32_t a = indices[i + k];
+			uint32_t b = indices[i + (k + 1) % 3];
+			uint32_t pa = position_id[a], pb = position_id[b];
+
+			if (edges[((uint64_t)glm::min(pa, pb) << 32) | glm::max(pa, pb)] == 1) {
+				locked[a] = true;
+				locked[b] = true;
+			}
+		}
+	}
+
+	return locked;
+} // find_locked
+
+/**
+* @brief Would moving from onto to flip (or collapse) any triangle around from
+*/
+static bool flips(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, const std::vector<uint32_t>& remap,
+                  const std::vector<uint32_t>& offsets, const std::vector<uint32_t>& adjacency, uint32_t from, uint32_t to) {
+	const glm::vec3& target = vertices[to].m_pos;
+
+	for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i) {
+		size_t t = adjacency[i] * 3;
+		uint32_t corners[3] = { remap[indices[t]], remap[indices[t + 1]], remap[indices[t + 2]] };
+
+		if (corners[0] == to || corners[1] == to || corners[2] == to)
+			continue; // Removed by the collapse
+
+		if (corners[0] == corners[1] || corners[1] == corners[2] || corners[0] == corners[2])
+			continue; // Already degenerate
+
+		glm::vec3 p[3], q[3];
+		for (size_t k = 0; k < 3; ++k) {
+			p[k] = vertices[corners[k]].m_pos;
+			q[k] = corners[k] == from ? target : p[k];
+		}
+
+		glm::vec3 before = glm::cross(p[1] - p[0], p[2] - p[0]);
+		glm::vec3 after = glm::cross(q[1] - q[0], q[2] - q[0]);
+
+		if (glm::dot(before, after) <= 0.0f)
+			return true;
+	}
+
+	return false;
+} // flips
+
+std::vector<uint32_t> simplify_mesh(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, size_t target_index_count, float max_error, float* result_error) {
+	std::vector<uint32_t> result = indices;
+	std::vector<bool> locked = find_locked(vertices, indices);
+	std::vector<quadric> quadrics(vertices.size());
+	double worst = 0.0;
+
+	// Plane of every triangle, weighted by its area, on each corner
+	for (size_t i = 0; i < result.size(); i += 3) {
+		glm::dvec3 p0 = vertices[result[i + 0]].m_pos;
+		glm::dvec3 p1 = vertices[result[i + 1]].m_pos;
+		glm::dvec3 p2 = vertices[result[i + 2]].m_pos;
+
+		glm::dvec3 n = glm::cross(p1 - p0, p2 - p0);
+		double area = glm::length(n);
+		if (area <= 0.0)
+			continue;
+
+		n /= area;
+		double d = -glm::dot(n, p0);
+
+		for (size_t k = 0; k < 3; ++k) {
+			quadrics[result[i + k]].add_plane(n, d, area * 0.5);
+		}
+	}
+
+	double max_error2 = (double)max_error * (double)max_error;
+
+	std::vector<uint32_t> remap(vertices.size());
+	std::vector<uint32_t> offsets(vertices.size() + 1);
+	std::vector<uint32_t> adjacency;
+	std::vector<collapse> collapses;
+	std::vector<bool> touched(vertices.size());
+
+	for (int pass = 0; pass < MAX_SIMPLIFY_PASSES && result.size() > target_index_count; ++pass) {
+		// Vertex -> triangle adjacency of the current triangles
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (uint32_t index : result) {
+			++offsets[index + 1];
+		}
+
+		for (size_t v = 0; v < vertices.size(); ++v) {
+			offsets[v + 1] += offsets[v];
+		}
+
+		adjacency.resize(result.size());
+		std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+		for (size_t t = 0; t < result.size() / 3; ++t) {
+			for (size_t k = 0; k < 3; ++k) {
+				adjacency[fill[result[t * 3 + k]]++] = (uint32_t)t;
+			}
+		}
+
+		// Cheapest direction of every edge
+		collapses.clear();
+
+		for (size_t i = 0; i < result.size(); i += 3) {
+			for (size_t k = 0; k < 3; ++k) {
+				uint32_t a = result[i + k];
+				uint32_t b = result[i + (k + 1) % 3];
+
+				if (a > b)
+					continue; // Each edge once (from the triangle that has it in this direction)
+
+				quadric q = quadrics[a];
+				q.add(quadrics[b]);
+
+				double to_b = locked[a] ? DBL_MAX : q.error(vertices[b].m_pos);
+				double to_a = locked[b] ? DBL_MAX : q.error(vertices[a].m_pos);
+
+				if (to_b == DBL_MAX && to_a == DBL_MAX)
+					continue;
+
+				if (to_b <= to_a) {
+					collapses.push_back({ a, b, to_b });
+				}
+				else {
+					collapses.push_back({ b, a, to_a });
+				}
+			}
+		}
+
+		if (collapses.empty())
+			break;
+
+		// Ties broken by vertex ids so the result is deterministic
+		std::sort(collapses.begin(), collapses.end(), [](const collapse& x, const collapse& y) {
+			if (x.error != y.error) return x.error < y.error;
+			if (x.from != y.from) return x.from < y.from;
+			return x.to < y.to;
+		});
+
+		for (uint32_t v = 0; v < vertices.size(); ++v) {
+			remap[v] = v;
+		}
+
+		std::fill(touched.begin(), touched.end(), false);
+
+		// Each collapse removes about two triangles, stop at the target
+		size_t triangles_to_remove = (result.size() - target_index_count) / 3;
+		size_t removed = 0;
+		size_t done = 0;
+
+		for (const collapse& c : collapses) {
+			if (removed >= triangles_to_remove || c.error > max_error2)
+				break;
+
+			if (touched[c.from] || touched[c.to])
+				continue;
+
+			if (flips(vertices, result, remap, offsets, adjacency, c.from, c.to))
+				continue;
+
+			remap[c.from] = c.to;
+			quadrics[c.to].add(quadrics[c.from]);
+			worst = glm::max(worst, c.error);
+
+			// Neighbours of the moved vertex see its new position this pass
+			for (uint32_t i = offsets[c.from]; i < offsets[c.from + 1]; ++i) {
+				size_t t = adjacency[i] * 3;
+				for (size_t k = 0; k < 3; ++k) {
+					touched[result[t + k]] = true;
+				}
+			}
+
+			removed += 2;
+			++done;
+		}
+
+		if (done == 0)
+			break;
+
+		// Apply the collapses and drop the degenerate triangles
+		size_t write = 0;
+		for (size_t i = 0; i < result.size(); i += 3) {
+			uint32_t a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+
+			if (a == b || b == c || a == c)
+				continue;
+
+			result[write++] = a;
+			result[write++] = b;
+			result[write++] = c;
+		}
+
+		result.resize(write);
+	}
+
+	if (result_error) {
+		*result_error = (float)glm::sqrt(worst);
+	}
+
+	return result;
+} // simplify_mesh
+
+std::vector<mesh_lod> build_lod_chain(const std::vector<vertex>& vertices, std::vector<uint32_t>& indices, index_range base, size_t max_levels) {
+	std::vector<mesh_lod> lods;
+	lods.push_back({ base.first_index, base.index_count, 0.0f });
+
+	std::vector<uint32_t> previous(indices.begin() + base.first_index, indices.begin() + base.first_index + base.index_count);
+
+	// Allow each level to deviate by up to 5% of the range's size
+	glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+	for (uint32_t index : previous) {
+		min = glm::min(min, vertices[index].m_pos);
+		max = glm::max(max, vertices[index].m_pos);
+	}
+
+	float max_error = previous.empty() ? 0.0f : glm::length(max - min) * 0.05f;
+
+	float error = 0.0f;
+
+	while (lods.size() < max_levels) {
+		float level_error = 0.0f;
+		std::vector<uint32_t> level = simplify_mesh(vertices, previous, previous.size() / 6 * 3, max_error, &level_error);
+
+		if (level.empty() || (float)level.size() > (float)previous.size() * MIN_LOD_REDUCTION)
+			break;
+
+		optimize_vertex_cache(level, vertices.size());
+
+		// Errors add up along the chain
+		error += level_error;
+
+		lods.push_back({ (uint32_t)indices.size(), (uint32_t)level.size(), error });
+		indices.insert(indices.end(), level.begin(), level.end());
+
+		previous.swap(level);
+	}
+
+	for (size_t i = 0; i < lods.size(); ++i) {
+		LOG_DEBUG(MESH, "LOD %zu: %u triangles, error %g", i, lods[i].index_count / 3, lods[i].error);
+	}
+
+	return lods;
+} // build_lod_chain
@@ -0,0 +1,51 @@
+#ifndef _MESH_SIMPLIFIER_HPP
+#define _MESH_SIMPLIFIER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertex.hpp"
+#include "mesh_optimizer.hpp"
+
+constexpr size_t MAX_MESH_LODS = 5;
+
+/**
+* @brief One level of detail: a range of the mesh index buffer
+*/
+struct mesh_lod {
+	uint32_t first_index;
+	uint32_t index_count;
+	float error; // Largest geometric deviation from LOD 0 (model units)
+
+	uint32_t first_meshlet = 0; // Range of mesh::m_meshlets covering this level
+	uint32_t meshlet_count = 0;
+};
+
+/**
+* @brief Simplify a triangle list with quadric error metrics (Garland & Heckbert 1997)
+*
+* Edges are collapsed onto one of their existing vertices, so the result indexes the
+* same vertex buffer. Vertices on open borders and attribute seams (UV or normal
+* splits) never move.
+*
+* @param target_index_count Stop once the result has this many indices or fewer
+* @param max_error Stop before a collapse would move the surface further than this (model units)
+* @param result_error Set to the largest error of the collapses done, may be null
+*
+* @return std::vector<uint32_t> The simplified triangle list
+*/
+std::vector<uint32_t> simplify_mesh(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, size_t target_index_count, float max_error, float* result_error = nullptr);
+
+/**
+* @brief Build a chain of LODs, each about half the triangles of the previous one
+*
+* LOD 0 is the base range of the index buffer. The coarser levels are appended to
+* indices so every level lives in the one index buffer; generation stops early once
+* a level barely shrinks.
+*
+* @return std::vector<mesh_lod> The levels, finest first
+*/
+std::vector<mesh_lod> build_lod_chain(const std::vector<vertex>& vertices, std::vector<uint32_t>& indices, index_range base, size_t max_levels = MAX_MESH_LODS);
+
+#endif // _MESH_SIMPLIFIER_HPP
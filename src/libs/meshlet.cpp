@@ -0,0 +1,219 @@
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "gl.hpp"
+#include <cstdint>
+#include <chrono>
+#include <vector>
+
+#include "vertex.hpp"
+#include "meshlet.hpp"
+
+frustum_planes frustum_planes::extract(const glm::mat4& m) {
+	frustum_planes result;
+	glm::vec4 row0 = glm::vec4(m[0][0], m[1][0], m[2][0], m[3][0]);
+	glm::vec4 row1 = glm::vec4(m[0][1], m[1][1], m[2][1], m[3][1]);
+	glm::vec4 row2 = glm::vec4(m[0][2], m[1][2], m[2][2], m[3][2]);
+	glm::vec4 row3 = glm::vec4(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+	result.planes[0] = row3 + row0; // Left
+	result.planes[1] = row3 - row0; // Right
+	result.planes[2] = row3 + row1; // Bottom
+	result.planes[3] = row3 - row1; // Top
+	result.planes[4] = row3 + row2; // Near
+	result.planes[5] = row3 - row2; // Far
+
+	for (glm::vec4& plane : result.planes) {
+		plane /= glm::length(glm::vec3(plane));
+	}
+
+	return result;
+} // extract
+
+bool frustum_planes::contains(const glm::vec3& center, float radius) const {
+	for (const glm::vec4& plane : planes) {
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+
+	return true;
+} // contains
+
+static meshlet finish_meshlet(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t first_index, uint32_t index_count) {
+	meshlet m = { first_index, index_count, glm::vec3(0.0f), 0.0f, glm::vec3(0.0f), 1.0f };
+
+	// Bounding sphere around the box centre
+	glm::vec3 min = vertices[indices[first_index]].m_pos;
+	glm::vec3 max = min;
+
+	for (uint32_t i = first_index; i < first_index + index_count; ++i) {
+		min = glm::min(min, vertices[indices[i]].m_pos);
+		max = glm::max(max, vertices[indices[i]].m_pos);
+	}
+
+	m.center = (min + max) * 0.5f;
+
+	for (uint32_t i = first_index; i < first_index + index_count; ++i) {
+		m.radius = glm::max(m.radius, glm::length(vertices[indices[i]].m_pos - m.center));
+	}
+
+	// Normal cone from the face normals
+	std::vector<glm::vec3> normals;
+	normals.reserve(index_count / 3);
+
+	glm::vec3 axis(0.0f);
+	for (uint32_t i = first_index; i < first_index + index_count; i += 3) {
+		const glm::vec3& p0 = vertices[indices[i + 0]].m_pos;
+		const glm::vec3& p1 = vertices[indices[i + 1]].m_pos;
+		const glm::vec3& p2 = vertices[indices[i + 2]].m_pos;
+
+		glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+		float length = glm::length(n);
+		if (length <= 0.0f)
+			continue;
+
+		normals.push_back(n / length);
+		axis += normals.back();
+	}
+
+	float axis_length = glm::length(axis);
+	if (normals.empty() || axis_length <= 0.0f)
+		return m;
+
+	m.cone_axis = axis / axis_length;
+
+	float min_dot = 1.0f;
+	for (const glm::vec3& n : normals) {
+		min_dot = glm::min(min_dot, glm::dot(n, m.cone_axis));
+	}
+
+	// Wider than a hemisphere can never be entirely back-facing
+	if (min_dot > 0.0f) {
+		m.cone_cutoff = glm::sqrt(1.0f - min_dot * min_dot);
+	}
+
+	return m;
+} // finish_meshlet
+
+std::vector<meshlet> build_meshlets(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t first_index, uint32_t index_count, size_t max_vertices, size_t max_triangles) {
+	std::vector<meshlet> result;
+	std::vector<uint32_t> stamp(vertices.size(), 0); // Meshlet number + 1 that last used the vertex
+
+	uint32_t start = first_index;
+	uint32_t end = first_index + index_count;
+	size_t unique = 0;
+	uint32_t current = 1;
+
+	for (uint32_t i = first_index; i < end; i += 3) {
+		size_t added = 0;
+		for (size_t k = 0; k < 3; ++k) {
+			added += stamp[indices[i + k]] != current;
+		}
+
+		// Close the meshlet when the triangle does not fit
+		if (unique + added > max_vertices || (i - start) / 3 >= max_triangles) {
+			result.push_back(finish_meshlet(vertices, indices, start, i - start));
+
+			start = i;
+			unique = 0;
+			++current;
+		}
+
+		for (size_t k = 0; k < 3; ++k) {
+			uint32_t v = indices[i + k];
+
+			if (stamp[v] != current) {
+				stamp[v] = current;
+				++unique;
+			}
+		}
+	}
+
+	if (start < end) {
+		result.push_back(finish_meshlet(vertices, indices, start, end - start));
+	}
+
+	return result;
+} // build_meshlets
+
+size_t cull_meshlets(const meshlet* meshlets, size_t count, const frustum_planes& planes, const glm::vec3& camera, draw_ranges& out) {
+	size_t kept = 0;
+	uint32_t run_start = 0, run_end = 0; // Index range being merged
+
+	out.clear();
+
+	for (size_t i = 0; i < count; ++i) {
+		const meshlet& m = meshlets[i];
+
+		// Every triangle faces away from the camera
+		glm::vec3 to_center = m.center - camera;
+		if (glm::dot(to_center, m.cone_axis) >= m.cone_cutoff * glm::length(to_center) + m.radius)
+			continue;
+
+		if (!planes.contains(m.center, m.radius))
+			continue;
+
+		++kept;
+
+		if (run_end == m.first_index && run_end != run_start) {
+			run_end += m.index_count; // Extends the current range
+			continue;
+		}
+
+		if (run_end != run_start) {
+			out.counts.push_back((GLsizei)(run_end - run_start));
+			out.offsets.push_back((const void*)(uintptr_t)(run_start * sizeof(uint32_t)));
+		}
+
+		run_start = m.first_index;
+		run_end = m.first_index + m.index_count;
+	}
+
+	if (run_end != run_start) {
+		out.counts.push_back((GLsizei)(run_end - run_start));
+		out.offsets.push_back((const void*)(uintptr_t)(run_start * sizeof(uint32_t)));
+	}
+
+	return kept;
+} // cull_meshlets
+
+double benchmark_meshlet_culling(const std::vector<meshlet>& meshlets, int iterations) {
+	if (meshlets.empty() || iterations <= 0)
+		return 0.0;
+
+	// Orbit at three times the radius of the whole set
+	glm::vec3 center(0.0f);
+	for (const meshlet& m : meshlets) {
+		center += m.center;
+	}
+
+	center /= (float)meshlets.size();
+
+	float radius = 0.0f;
+	for (const meshlet& m : meshlets) {
+		radius = glm::max(radius, glm::length(m.center - center) + m.radius);
+	}
+
+	glm::mat4 projection = glm::perspective(glm::radians(65.0f), 16.0f / 9.0f, 0.1f, radius * 10.0f);
+	draw_ranges ranges;
+	ranges.reserve(meshlets.size());
+
+	size_t kept = 0;
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (int i = 0; i < iterations; ++i) {
+		float angle = glm::two_pi<float>() * (float)i / (float)iterations;
+		glm::vec3 camera = center + glm::vec3(glm::cos(angle), 0.3f, glm::sin(angle)) * radius * 3.0f;
+
+		frustum_planes planes = frustum_planes::extract(projection * glm::lookAt(camera, center, glm::vec3(0.0f, 1.0f, 0.0f)));
+		kept += cull_meshlets(meshlets.data(), meshlets.size(), planes, camera, ranges);
+	}
+
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	// Keep the work observable so it is not optimised away
+	if (kept == SIZE_MAX)
+		return 0.0;
+
+	return ms > 0.0 ? (double)meshlets.size() * iterations / ms : 0.0;
+} // benchmark_meshlet_culling
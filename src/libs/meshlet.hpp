@@ -0,0 +1,93 @@
+#ifndef _MESHLET_HPP
+#define _MESHLET_HPP
+
+#include <glm/glm.hpp>
+#include "gl.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "vertex.hpp"
+#include "frame_arena.hpp"
+
+constexpr size_t MESHLET_MAX_VERTICES = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 124;
+
+/**
+* @brief A small cluster of triangles, a contiguous range of the mesh index buffer
+*/
+struct meshlet {
+	uint32_t first_index;
+	uint32_t index_count;
+
+	glm::vec3 center; // Bounding sphere (model space)
+	float radius;
+
+	glm::vec3 cone_axis; // Average facing of the triangles
+	float cone_cutoff;   // Sine of the cone half angle, 1 when the triangles face too many ways to cull
+};
+
+/**
+* @brief The six planes of a view frustum, normalised, pointing inside
+*/
+struct frustum_planes {
+	glm::vec4 planes[6];
+
+	/**
+	* @brief Extract the planes of a projection matrix (Gribb & Hartmann), in the space the matrix transforms from
+	*/
+	static frustum_planes extract(const glm::mat4& m);
+
+	bool contains(const glm::vec3& center, float radius) const;
+};
+
+/**
+* @brief Index ranges left after culling, ready for glMultiDrawElements
+*
+* Transient, the lists live in the frame arena.
+*/
+struct draw_ranges {
+	frame_vector<GLsizei> counts;
+	frame_vector<const void*> offsets;
+
+	/**
+	* @brief Make room for the ranges of count meshlets (at most one range each), so culling never grows the lists
+	*/
+	void reserve(size_t count) {
+		counts.reserve(count);
+		offsets.reserve(count);
+	}
+
+	void clear() {
+		counts.clear();
+		offsets.clear();
+	}
+};
+
+/**
+* @brief Split a range of a triangle list into meshlets, in index order
+*
+* The triangles are not reordered, so a meshlet is always a contiguous index range and
+* neighbouring visible meshlets can be submitted as one range.
+*/
+std::vector<meshlet> build_meshlets(const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices, uint32_t first_index, uint32_t index_count,
+                                    size_t max_vertices = MESHLET_MAX_VERTICES, size_t max_triangles = MESHLET_MAX_TRIANGLES);
+
+/**
+* @brief Drop back-facing and out of frustum meshlets and merge the index ranges of the rest
+*
+* @param planes Frustum planes in model space (extracted from projection * view * model)
+* @param camera Camera position in model space
+*
+* @return size_t Number of meshlets kept
+*/
+size_t cull_meshlets(const meshlet* meshlets, size_t count, const frustum_planes& planes, const glm::vec3& camera, draw_ranges& out);
+
+/**
+* @brief Time cull_meshlets from cameras orbiting the meshlets
+*
+* @return double Meshlets culled per millisecond
+*/
+double benchmark_meshlet_culling(const std::vector<meshlet>& meshlets, int iterations = 1000);
+
+#endif // _MESHLET_HPP
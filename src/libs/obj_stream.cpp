@@ -0,0 +1,758 @@
+#include <glm/glm.hpp>
+#include <tiny_obj_loader.h>
+#include <filesystem>
+#include <algorithm>
+#include <fstream>
+#include <cstdint>
+#include <cstring>
+#include <cstdlib>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <memory>
+#include <map>
+
+#include "log.hpp"
+#include "vertex.hpp"
+#include "mesh.hpp"
+#include "object.hpp"
+#include "mesh_normals.hpp"
+#include "mesh_cooked.hpp"
+#include "obj_stream.hpp"
+
+constexpr size_t SPILL_PAGE_BYTES = 64 * 1024; // Granularity of the attribute page cache
+
+/**
+* @brief Reads a file line by line through one fixed size buffer
+*/
+struct line_window {
+	std::ifstream m_file;
+	std::vector<char> m_buffer; // One extra byte to terminate a last line without a line break
+	size_t m_begin, m_end;
+	bool m_eof;
+	bool m_overflow; // A line did not fit the window
+
+	line_window(const char* filename, size_t window_bytes) : m_file(filename, std::ios::binary), m_buffer(window_bytes + 1), m_begin(0), m_end(0), m_eof(false), m_overflow(false) {}
+
+	/**
+	* @brief The next line, null terminated and without its line break
+	*
+	* @return bool False at the end of the file or on a line longer than the window
+	*/
+	bool next(char*& line) {
+		for (;;) {
+			char* start = m_buffer.data() + m_begin;
+			char* end = (char*)memchr(start, '\n', m_end - m_begin);
+
+			if (end || (m_eof && m_begin < m_end)) {
+				if (!end) {
+					end = m_buffer.data() + m_end;
+				}
+
+				m_begin = (size_t)(end - m_buffer.data()) + (end < m_buffer.data() + m_end ? 1 : 0);
+
+				if (end > start && end[-1] == '\r') {
+					--end;
+				}
+
+				*end = '\0';
+				line = start;
+				return true;
+			}
+
+			if (m_eof)
+				return false;
+
+			// Move the partial line to the front and refill behind it
+			size_t partial = m_end - m_begin;
+			if (partial == m_buffer.size() - 1) {
+				m_overflow = true;
+				return false;
+			}
+
+			memmove(m_buffer.data(), start, partial);
+			m_begin = 0;
+			m_end = partial;
+
+			m_file.read(m_buffer.data() + m_end, (std::streamsize)(m_buffer.size() - 1 - m_end));
+			m_end += (size_t)m_file.gcount();
+
+			if (!m_file) {
+				m_eof = true;
+			}
+		}
+	}
+}; // line_window
+
+/**
+* @brief Float tuples spilled to a temporary file, read back through a direct mapped page cache
+*
+* Tuples can also be changed in place (modify), their page is written back when its slot is reused.
+*/
+struct attribute_spill {
+	std::string m_path;
+	std::fstream m_file;
+	size_t m_components;
+	uint64_t m_count;
+
+	std::vector<float> m_pending; // Write buffer, one page
+
+	size_t m_page_elements;
+	std::vector<int64_t> m_slot_page; // Page held by every cache slot (-1: none)
+	std::vector<uint8_t> m_slot_dirty; // Changed since the page was read
+	std::vector<float> m_slots;
+
+	attribute_spill(const std::string& path, size_t components, size_t cache_bytes) : m_path(path), m_components(components), m_count(0) {
+		m_page_elements = SPILL_PAGE_BYTES / (components * sizeof(float));
+
+		size_t slot_count = std::max<size_t>(cache_bytes / SPILL_PAGE_BYTES, 1);
+		m_slot_page.assign(slot_count, -1);
+		m_slot_dirty.assign(slot_count, 0);
+		m_slots.resize(slot_count * m_page_elements * components);
+
+		m_file.open(m_path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	}
+
+	~attribute_spill() {
+		m_file.close();
+
+		std::error_code ec;
+		std::filesystem::remove(m_path, ec);
+	}
+
+	attribute_spill(attribute_spill&) = delete; // No copy constructor
+	attribute_spill& operator=(const attribute_spill&) = delete; // No copy assignment
+
+	void append(const float* values) {
+		m_pending.insert(m_pending.end(), values, values + m_components);
+		++m_count;
+
+		if (m_pending.size() == m_page_elements * m_components) {
+			flush();
+		}
+	}
+
+	/**
+	* @brief Append count zeroed tuples and write them out
+	*/
+	bool fill(uint64_t count) {
+		std::vector<float> zero(m_components, 0.0f);
+
+		for (uint64_t i = 0; i < count; ++i) {
+			append(zero.data());
+		}
+
+		return flush();
+	}
+
+	bool flush() {
+		m_file.write((const char*)m_pending.data(), (std::streamsize)(m_pending.size() * sizeof(float)));
+		m_pending.clear();
+
+		return (bool)m_file;
+	}
+
+	/**
+	* @brief The tuple at index, its page is read into the cache if it is not there yet
+	*
+	* @return bool False if the page could not be read (values is left as it is)
+	*/
+	bool get(uint64_t index, const float*& values) {
+		float* data = nullptr;
+		if (!load(index, data))
+			return false;
+
+		values = data;
+		return true;
+	}
+
+	/**
+	* @brief Like get, but the tuple may be changed until the next call
+	*/
+	bool modify(uint64_t index, float*& values) {
+		if (!load(index, values))
+			return false;
+
+		m_slot_dirty[(size_t)(index / m_page_elements % m_slot_page.size())] = 1;
+		return true;
+	}
+
+	bool load(uint64_t index, float*& values) {
+		uint64_t page = index / m_page_elements;
+		size_t slot = (size_t)(page % m_slot_page.size());
+		float* data = m_slots.data() + slot * m_page_elements * m_components;
+
+		if (m_slot_page[slot] != (int64_t)page) {
+			if (m_slot_dirty[slot]) {
+				if (!write_slot(slot))
+					return false;
+
+				m_slot_dirty[slot] = 0;
+			}
+
+			uint64_t first = page * m_page_elements;
+			uint64_t count = std::min<uint64_t>(m_page_elements, m_count - first);
+
+			m_file.seekg((std::streamoff)(first * m_components * sizeof(float)));
+			m_file.read((char*)data, (std::streamsize)(count * m_components * sizeof(float)));
+
+			if (!m_file) {
+				m_slot_page[slot] = -1; // Partly overwritten
+				return false;
+			}
+
+			m_slot_page[slot] = (int64_t)page;
+		}
+
+		values = data + (index % m_page_elements) * m_components;
+		return true;
+	}
+
+	bool write_slot(size_t slot) {
+		uint64_t first = (uint64_t)m_slot_page[slot] * m_page_elements;
+		uint64_t count = std::min<uint64_t>(m_page_elements, m_count - first);
+
+		m_file.seekp((std::streamoff)(first * m_components * sizeof(float)));
+		m_file.write((const char*)(m_slots.data() + slot * m_page_elements * m_components), (std::streamsize)(count * m_components * sizeof(float)));
+
+		return (bool)m_file;
+	}
+}; // attribute_spill
+
+struct spilled_triangle {
+	uint32_t material;
+	vertex corners[3];
+	uint64_t positions[3]; // OBJ v index of every corner, keys the generated normals
+};
+
+static_assert(sizeof(normal_clusters) == NORMAL_CLUSTERS * 3 * sizeof(float), "normal_clusters is spilled as plain floats");
+
+struct cell_block_header {
+	int64_t previous; // Offset of the cell's previous block (-1: first)
+	uint32_t count;
+};
+
+/**
+* @brief Triangles binned into a uniform grid, every cell spilled as a backwards linked chain of blocks
+*/
+struct cell_spill {
+	std::string m_path;
+	std::fstream m_file;
+	int64_t m_size;
+
+	glm::vec3 m_min;
+	float m_cell_size;
+	glm::ivec3 m_dims;
+
+	std::vector<int64_t> m_last_block; // Per cell
+	std::vector<std::vector<spilled_triangle>> m_pending;
+	size_t m_buffer_triangles;
+
+	cell_spill(const std::string& path, const glm::vec3& min, const glm::vec3& max, uint64_t triangle_count, const obj_stream_options& options) : m_path(path), m_size(0), m_min(min), m_buffer_triangles(options.cell_buffer_triangles) {
+		// Cubic cells, about one chunk each, never more than max_cells of them
+		glm::vec3 extent = glm::max(max - min, glm::vec3(0.0f));
+		float largest = glm::max(glm::max(extent.x, extent.y), glm::max(extent.z, FLT_MIN));
+		glm::vec3 volume_extent = glm::max(extent, glm::vec3(largest * 1e-3f));
+
+		uint64_t target = std::clamp<uint64_t>((triangle_count + options.chunk_triangles - 1) / options.chunk_triangles, 1, options.max_cells);
+		m_cell_size = std::cbrt(volume_extent.x * volume_extent.y * volume_extent.z / (float)target);
+
+		for (;;) {
+			m_dims = glm::max(glm::ivec3(glm::ceil(extent / m_cell_size)), glm::ivec3(1));
+
+			if ((size_t)m_dims.x * m_dims.y * m_dims.z <= options.max_cells)
+				break;
+
+			m_cell_size *= 1.1f;
+		}
+
+		size_t cells = (size_t)m_dims.x * m_dims.y * m_dims.z;
+		m_last_block.assign(cells, -1);
+		m_pending.resize(cells);
+
+		m_file.open(m_path, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	}
+
+	~cell_spill() {
+		m_file.close();
+
+		std::error_code ec;
+		std::filesystem::remove(m_path, ec);
+	}
+
+	cell_spill(cell_spill&) = delete; // No copy constructor
+	cell_spill& operator=(const cell_spill&) = delete; // No copy assignment
+
+	size_t cell_count() const { return m_last_block.size(); }
+
+	void add(const spilled_triangle& triangle) {
+		glm::vec3 centroid = (triangle.corners[0].m_pos + triangle.corners[1].m_pos + triangle.corners[2].m_pos) / 3.0f;
+		glm::ivec3 cell = glm::clamp(glm::ivec3((centroid - m_min) / m_cell_size), glm::ivec3(0), m_dims - 1);
+		size_t index = ((size_t)cell.z * m_dims.y + cell.y) * m_dims.x + cell.x;
+
+		m_pending[index].push_back(triangle);
+
+		if (m_pending[index].size() >= m_buffer_triangles) {
+			flush(index);
+		}
+	}
+
+	void flush(size_t cell) {
+		std::vector<spilled_triangle>& pending = m_pending[cell];
+		if (pending.empty())
+			return;
+
+		cell_block_header header = { m_last_block[cell], (uint32_t)pending.size() };
+
+		m_file.seekp((std::streamoff)m_size);
+		m_file.write((const char*)&header, sizeof(header));
+		m_file.write((const char*)pending.data(), (std::streamsize)(pending.size() * sizeof(spilled_triangle)));
+
+		m_last_block[cell] = m_size;
+		m_size += (int64_t)(sizeof(header) + pending.size() * sizeof(spilled_triangle));
+
+		pending.clear();
+	}
+
+	/**
+	* @brief Read one block of a cell, offset moves on to the previous block
+	*/
+	bool read_block(int64_t& offset, std::vector<spilled_triangle>& triangles) {
+		cell_block_header header = {};
+
+		m_file.seekg((std::streamoff)offset);
+		m_file.read((char*)&header, sizeof(header));
+
+		triangles.resize(header.count);
+		m_file.read((char*)triangles.data(), (std::streamsize)(header.count * sizeof(spilled_triangle)));
+
+		offset = header.previous;
+
+		return (bool)m_file;
+	}
+}; // cell_spill
+
+/**
+* @brief Resolve a 1-based (or negative, relative) OBJ index against the elements read so far
+*
+* @return int64_t 0-based index, or -1 if it is out of range
+*/
+static int64_t resolve_index(long long index, uint64_t count) {
+	int64_t resolved = index > 0 ? (int64_t)index - 1 : (int64_t)count + index;
+
+	return resolved >= 0 && (uint64_t)resolved < count ? resolved : -1;
+}
+
+static char* skip_spaces(char* cursor) {
+	while (*cursor == ' ' || *cursor == '\t') {
+		++cursor;
+	}
+
+	return cursor;
+}
+
+/**
+* @brief Read up to count floats, missing ones are left as they are
+*/
+static void parse_floats(char* cursor, float* values, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		char* end = cursor;
+		float value = strtof(cursor, &end);
+
+		if (end == cursor)
+			return;
+
+		values[i] = value;
+		cursor = end;
+	}
+}
+
+/**
+* @brief A keyword line ("v", "usemtl", ...) and its arguments
+*/
+static bool keyword(char* line, const char* name, char*& arguments) {
+	line = skip_spaces(line);
+	size_t length = strlen(name);
+
+	if (strncmp(line, name, length) != 0 || (line[length] != ' ' && line[length] != '\t'))
+		return false;
+
+	arguments = skip_spaces(line + length);
+	return true;
+}
+
+bool import_obj_streaming(const char* baseDir, const char* filename, const char* cooked_filename, const obj_stream_options& options) {
+	std::string spill_base = cooked_filename;
+
+	attribute_spill positions(spill_base + ".v.tmp", 3, options.cache_bytes / 4);
+	attribute_spill texcoords(spill_base + ".vt.tmp", 2, options.cache_bytes / 4);
+	attribute_spill normals(spill_base + ".vn.tmp", 3, options.cache_bytes / 4);
+
+	if (!positions.m_file.is_open() || !texcoords.m_file.is_open() || !normals.m_file.is_open()) {
+		LOG_ERROR(MESH, "Failed to create temporary files next to %s", cooked_filename);
+		return false;
+	}
+
+	std::vector<tinyobj::material_t> obj_materials;
+	std::map<std::string, int> material_map;
+
+	glm::vec3 min(FLT_MAX), max(-FLT_MAX);
+	uint64_t triangle_count = 0;
+	bool faces_missing_normals = false; // Some face corner has no vn
+
+	// Pass 1: spill the attributes, load the materials, measure the bounds
+	{
+		line_window window(filename, options.window_bytes);
+		if (!window.m_file.is_open()) {
+			LOG_ERROR(MESH, "Failed to open obj file %s", filename);
+			return false;
+		}
+
+		char* line;
+		char* arguments;
+
+		while (window.next(line)) {
+			float values[3] = { 0.0f, 0.0f, 0.0f };
+
+			if (keyword(line, "v", arguments)) {
+				parse_floats(arguments, values, 3);
+				positions.append(values);
+
+				min = glm::min(min, glm::vec3(values[0], values[1], values[2]));
+				max = glm::max(max, glm::vec3(values[0], values[1], values[2]));
+			}
+			else if (keyword(line, "vt", arguments)) {
+				parse_floats(arguments, values, 2);
+				texcoords.append(values);
+			}
+			else if (keyword(line, "vn", arguments)) {
+				parse_floats(arguments, values, 3);
+				normals.append(values);
+			}
+			else if (keyword(line, "f", arguments)) {
+				size_t corners = 0;
+
+				for (char* cursor = arguments; *cursor; ) {
+					++corners;
+
+					// v//vn or v/vt/vn: something after the second slash
+					size_t slashes = 0;
+					bool normal = false;
+
+					for (; *cursor && *cursor != ' ' && *cursor != '\t'; ++cursor) {
+						normal |= slashes == 2 && *cursor != '/';
+						slashes += *cursor == '/';
+					}
+
+					faces_missing_normals |= !normal;
+					cursor = skip_spaces(cursor);
+				}
+
+				triangle_count += corners >= 3 ? corners - 2 : 0;
+			}
+			else if (keyword(line, "mtllib", arguments)) {
+				std::string mtl_path = (std::filesystem::path(baseDir) / arguments).generic_string();
+				std::ifstream mtl_file(mtl_path);
+
+				if (mtl_file.is_open()) {
+					std::string warning;
+					tinyobj::LoadMtl(&material_map, &obj_materials, &mtl_file, &warning);
+				}
+				else {
+					LOG_WARNING(MESH, "Material file %s not found", mtl_path.c_str());
+				}
+			}
+		}
+
+		if (window.m_overflow) {
+			LOG_ERROR(MESH, "Line longer than the %zu byte read window in %s", options.window_bytes, filename);
+			return false;
+		}
+	}
+
+	if (!positions.flush() || !texcoords.flush() || !normals.flush()) {
+		LOG_ERROR(MESH, "Failed to write temporary files next to %s", cooked_filename);
+		return false;
+	}
+
+	if (triangle_count == 0) {
+		LOG_ERROR(MESH, "No faces in %s", filename);
+		return false;
+	}
+
+	// Normals are generated over the whole file as the faces are binned, not per chunk, so chunks meet without lighting seams
+	std::unique_ptr<attribute_spill> clusters;
+	float cos_crease = glm::cos(glm::radians(DEFAULT_CREASE_ANGLE));
+
+	if (faces_missing_normals) {
+		clusters = std::make_unique<attribute_spill>(spill_base + ".vc.tmp", NORMAL_CLUSTERS * 3, options.cache_bytes / 4);
+
+		if (!clusters->m_file.is_open() || !clusters->fill(positions.m_count)) {
+			LOG_ERROR(MESH, "Failed to write temporary files next to %s", cooked_filename);
+			return false;
+		}
+	}
+
+	cell_spill cells(spill_base + ".cells.tmp", min, max, triangle_count, options);
+	if (!cells.m_file.is_open()) {
+		LOG_ERROR(MESH, "Failed to create temporary files next to %s", cooked_filename);
+		return false;
+	}
+
+	size_t working_set = options.window_bytes + options.cache_bytes + cells.cell_count() * options.cell_buffer_triangles * sizeof(spilled_triangle)
+		+ options.chunk_triangles * 3 * (sizeof(vertex) + sizeof(uint32_t)) * 4; // Chunk and the cooking scratch, the upper bound reached once chunks are full
+	LOG_DEBUG(MESH, "Streaming %s: %llu triangles into %zu cells, working set ~%.1f MB", filename, (unsigned long long)triangle_count, cells.cell_count(), working_set / (1024.0 * 1024.0));
+
+	uint32_t default_material = (uint32_t)obj_materials.size();
+	bool default_used = false;
+	uint64_t skipped = 0;
+
+	// Pass 2: bin every triangle into its cell, indices resolve through the attribute caches
+	{
+		line_window window(filename, options.window_bytes);
+
+		uint64_t counts[3] = { 0, 0, 0 }; // v, vt, vn read so far (for relative indices)
+		uint32_t material = default_material;
+		std::vector<int64_t> corners; // v, vt, vn per corner
+
+		char* line;
+		char* arguments;
+
+		while (window.next(line)) {
+			if (keyword(line, "v", arguments)) {
+				++counts[0];
+			}
+			else if (keyword(line, "vt", arguments)) {
+				++counts[1];
+			}
+			else if (keyword(line, "vn", arguments)) {
+				++counts[2];
+			}
+			else if (keyword(line, "usemtl", arguments)) {
+				auto it = material_map.find(arguments);
+				material = it != material_map.end() ? (uint32_t)it->second : default_material;
+			}
+			else if (keyword(line, "f", arguments)) {
+				corners.clear();
+				bool valid = true;
+
+				// v, v/vt, v//vn or v/vt/vn
+				for (char* cursor = arguments; *cursor; cursor = skip_spaces(cursor)) {
+					int64_t corner[3] = { -1, -1, -1 };
+
+					for (size_t k = 0; k < 3; ++k) {
+						char* end = cursor;
+						long long index = strtoll(cursor, &end, 10);
+
+						if (end != cursor) {
+							corner[k] = resolve_index(index, counts[k]);
+							valid &= corner[k] >= 0;
+							cursor = end;
+						}
+						else if (k == 0) {
+							valid = false;
+						}
+
+						if (*cursor != '/')
+							break;
+
+						++cursor;
+					}
+
+					while (*cursor && *cursor != ' ' && *cursor != '\t') ++cursor;
+
+					corners.insert(corners.end(), corner, corner + 3);
+				}
+
+				size_t corner_count = corners.size() / 3;
+
+				if (!valid || corner_count < 3) {
+					skipped += corner_count >= 3 ? corner_count - 2 : 1;
+					continue;
+				}
+
+				default_used |= material == default_material;
+
+				// Fan triangulation, like tinyobj
+				for (size_t c = 1; c + 1 < corner_count; ++c) {
+					spilled_triangle triangle = {};
+					triangle.material = material;
+
+					size_t fan[3] = { 0, c, c + 1 };
+
+					for (size_t k = 0; k < 3; ++k) {
+						const int64_t* corner = &corners[fan[k] * 3];
+						vertex& vert = triangle.corners[k];
+						triangle.positions[k] = (uint64_t)corner[0];
+
+						const float* p = nullptr;
+						const float* t = nullptr;
+						const float* n = nullptr;
+
+						if (!positions.get((uint64_t)corner[0], p) || (corner[1] >= 0 && !texcoords.get((uint64_t)corner[1], t)) || (corner[2] >= 0 && !normals.get((uint64_t)corner[2], n))) {
+							LOG_ERROR(MESH, "Failed to read temporary files next to %s", cooked_filename);
+							return false;
+						}
+
+						vert.m_pos = glm::vec3(p[0], p[1], p[2]);
+
+						if (t) {
+							vert.m_texCoord = glm::vec2(t[0], t[1]);
+						}
+
+						if (n) {
+							vert.m_normal = glm::vec3(n[0], n[1], n[2]);
+						}
+						else {
+							vert.m_normal = glm::vec3(0.0f, 0.0f, 0.0f); // Resolved from the clusters when cooked
+						}
+					}
+
+					if (clusters) {
+						float angles[3];
+						glm::vec3 face = face_normal(triangle.corners[0].m_pos, triangle.corners[1].m_pos, triangle.corners[2].m_pos, angles);
+
+						for (size_t k = 0; k < 3; ++k) {
+							float* sums = nullptr;
+							if (!clusters->modify(triangle.positions[k], sums)) {
+								LOG_ERROR(MESH, "Failed to read temporary files next to %s", cooked_filename);
+								return false;
+							}
+
+							normal_clusters group;
+							memcpy(&group, sums, sizeof(group));
+							group.add(face, angles[k], cos_crease);
+							memcpy(sums, &group, sizeof(group));
+						}
+					}
+
+					cells.add(triangle);
+				}
+			}
+		}
+
+		if (window.m_overflow) {
+			LOG_ERROR(MESH, "Line longer than the %zu byte read window in %s", options.window_bytes, filename);
+			return false;
+		}
+	}
+
+	for (size_t cell = 0; cell < cells.cell_count(); ++cell) {
+		cells.flush(cell);
+	}
+
+	if (!cells.m_file) {
+		LOG_ERROR(MESH, "Failed to write temporary files next to %s", cooked_filename);
+		return false;
+	}
+
+	if (skipped) {
+		LOG_WARNING(MESH, "Skipped %llu faces with invalid indices", (unsigned long long)skipped);
+	}
+
+	// Pass 3: cook every cell in chunks, straight into the output
+	std::vector<mesh_material> materials;
+	for (const auto& mat : obj_materials) {
+		materials.push_back({ mat.name, glm::vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]), mat.diffuse_texname });
+	}
+
+	if (default_used) {
+		mesh_material fallback;
+		fallback.name = "default";
+
+		materials.push_back(fallback);
+	}
+
+	cooked_mesh_writer writer(cooked_filename);
+	if (!writer.begin(materials))
+		return false;
+
+	bool has_texcoords = texcoords.m_count > 0;
+
+	std::vector<spilled_triangle> block;
+	std::vector<vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> triangle_material;
+	std::vector<submesh> submeshes;
+	bool missing_normals = false; // Left unresolved by the clusters (degenerate faces), generated per chunk
+
+	auto cook_chunk = [&]() {
+		if (indices.empty())
+			return true;
+
+		submeshes.clear();
+		build_submeshes(vertices, indices, triangle_material, missing_normals, has_texcoords, submeshes);
+
+		bool written = writer.write_chunk(vertices, indices, submeshes);
+
+		vertices.clear();
+		indices.clear();
+		triangle_material.clear();
+		missing_normals = false;
+
+		return written;
+	};
+
+	for (size_t cell = 0; cell < cells.cell_count(); ++cell) {
+		int64_t offset = cells.m_last_block[cell];
+
+		while (offset >= 0) {
+			if (!cells.read_block(offset, block)) {
+				LOG_ERROR(MESH, "Failed to read temporary files next to %s", cooked_filename);
+				return false;
+			}
+
+			for (spilled_triangle& triangle : block) {
+				if (clusters) {
+					float angles[3];
+					glm::vec3 face = face_normal(triangle.corners[0].m_pos, triangle.corners[1].m_pos, triangle.corners[2].m_pos, angles);
+
+					for (size_t k = 0; k < 3; ++k) {
+						vertex& corner = triangle.corners[k];
+						if (corner.m_normal != glm::vec3(0.0f))
+							continue;
+
+						const float* sums = nullptr;
+						if (!clusters->get(triangle.positions[k], sums)) {
+							LOG_ERROR(MESH, "Failed to read temporary files next to %s", cooked_filename);
+							return false;
+						}
+
+						normal_clusters group;
+						memcpy(&group, sums, sizeof(group));
+						corner.m_normal = group.normal(face);
+					}
+				}
+
+				for (const vertex& corner : triangle.corners) {
+					missing_normals |= corner.m_normal == glm::vec3(0.0f);
+
+					indices.push_back((uint32_t)vertices.size());
+					vertices.push_back(corner);
+				}
+
+				triangle_material.push_back(triangle.material);
+
+				if (triangle_material.size() >= options.chunk_triangles && !cook_chunk()) {
+					LOG_ERROR(MESH, "Failed to write cooked mesh %s", cooked_filename);
+					return false;
+				}
+			}
+		}
+
+		// Chunks never span cells, so they stay spatially compact
+		if (!cook_chunk()) {
+			LOG_ERROR(MESH, "Failed to write cooked mesh %s", cooked_filename);
+			return false;
+		}
+	}
+
+	if (!writer.finish())
+		return false;
+
+	LOG_INFO(MESH, "Cooked %s into %s: %u chunk(s)", filename, cooked_filename, writer.chunk_count());
+
+	return true;
+} // import_obj_streaming
@@ -0,0 +1,40 @@
+#ifndef _OBJ_STREAM_HPP
+#define _OBJ_STREAM_HPP
+
+#include <cstddef>
+
+/**
+* @brief Memory limits of a streaming OBJ import, none of them depend on the file size
+*
+* Peak memory is bounded, not constant: the window, the page cache and the cell
+* buffers are fixed, but cooking needs scratch in proportion to the largest chunk.
+* Small files fill their cells with fewer than chunk_triangles and peak lower; once
+* the chunks reach chunk_triangles the peak stops growing with the input.
+*/
+struct obj_stream_options {
+	size_t window_bytes = 4 * 1024 * 1024;      // Read window, also the longest line that can be parsed
+	size_t cache_bytes = 24 * 1024 * 1024;      // Page cache over the spilled v/vt/vn the faces index into, and the generated normals
+	size_t chunk_triangles = 64 * 1024;         // Most triangles cooked together (one chunk)
+	size_t max_cells = 512;                     // Spatial grid cells the triangles are binned into
+	size_t cell_buffer_triangles = 64;          // Triangles buffered per cell before they are spilled
+};
+
+/**
+* @brief Convert an OBJ of any size into a cooked mesh with bounded memory
+*
+* The file is read twice through a fixed window. The first pass spills v, vt and vn
+* to temporary files and measures the bounds; the second bins every face into a
+* spatial grid spilled to disk and, when the file lacks normals, sums the face
+* normals of every position (normal_clusters) so they do not depend on the chunking.
+* Each cell is then cooked (deduplication, tangents, optimisation, LODs) in chunks
+* of at most chunk_triangles and written straight to the cooked mesh, see
+* cooked_mesh_writer.
+*
+* @param baseDir Directory of the OBJ (mtllib files are relative to it)
+* @param cooked_filename Output file, the temporary files are written next to it
+*
+* @return bool True if the cooked mesh was written
+*/
+bool import_obj_streaming(const char* baseDir, const char* filename, const char* cooked_filename, const obj_stream_options& options = {});
+
+#endif // _OBJ_STREAM_HPP
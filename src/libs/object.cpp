@@ -1,23 +1,77 @@
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <string>
 #include <tiny_obj_loader.h>
 
-#include "scolor.hpp"
+#include "log.hpp"
+#include "memory_tracker.hpp"
 #include "vertex.hpp"
+#include "mesh_normals.hpp"
+#include "mesh_optimizer.hpp"
+#include "mesh_simplifier.hpp"
 
 #include "object.hpp"
 
+void build_submeshes(std::vector<vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangle_material, bool missing_normals, bool has_texcoords, std::vector<submesh>& submeshes) {
+	// Group the triangles of every material, over all shapes, into one contiguous range each
+	std::vector<uint32_t> range_material;
+	std::vector<index_range> ranges = group_triangles(indices, triangle_material, range_material);
+
+	// Smooth normals where the file has none (every corner is still its own vertex here)
+	if (missing_normals) {
+		generate_normals(vertices, indices, DEFAULT_CREASE_ANGLE, true);
+	}
+
+	// Identical corners of neighbouring faces share one vertex, then order everything for the GPU
+	size_t raw_vertices = vertices.size();
+	deduplicate_vertices(vertices, indices);
+	LOG_DEBUG(MESH, "Deduplicated %zu -> %zu vertices", raw_vertices, vertices.size());
+
+	if (has_texcoords) {
+		generate_tangents(vertices, indices);
+	}
+
+	optimize_mesh(vertices, indices, ranges);
+
+	// Coarser levels of every submesh go after the full mesh in the same index buffer
+	for (size_t r = 0; r < ranges.size(); ++r) {
+		submeshes.push_back({ range_material[r], build_lod_chain(vertices, indices, ranges[r]) });
+	}
+} // build_submeshes
+
 bool load_obj(const char* baseDir, const char* filename, mesh* mesh) {
+	memory_scope scope(memory_tag::MESHES);
+
 	tinyobj::attrib_t v_attrib;
 	std::vector<tinyobj::shape_t> shapes;
 	std::vector<tinyobj::material_t> materials;
 	std::string err;
 
-	if (!tinyobj::LoadObj(&v_attrib, &shapes, &materials, &err, filename, baseDir)) {
+	// tinyobj appends the mtllib name to the directory as is
+	std::string mtl_dir = baseDir;
+	if (!mtl_dir.empty() && mtl_dir.back() != '/') {
+		mtl_dir += '/';
+	}
+
+	if (!tinyobj::LoadObj(&v_attrib, &shapes, &materials, &err, filename, mtl_dir.c_str())) {
 		return false;
 	}
 
+	bool missing_normals = false;
+
+	// MTL materials, plus a default one for faces without a (known) material
+	for (const auto& mat : materials) {
+		mesh->m_materials.push_back({ mat.name, glm::vec3(mat.diffuse[0], mat.diffuse[1], mat.diffuse[2]), mat.diffuse_texname });
+	}
+
+	uint32_t default_material = (uint32_t)mesh->m_materials.size();
+	std::vector<uint32_t> triangle_material;
+
 	for (const auto& shape : shapes) {
+		for (int material_id : shape.mesh.material_ids) {
+			triangle_material.push_back(material_id >= 0 && material_id < (int)materials.size() ? (uint32_t)material_id : default_material);
+		}
+
 		for (const auto& index : shape.mesh.indices) {
 			vertex vert = {};
 
@@ -32,10 +86,15 @@ bool load_obj(const char* baseDir, const char* filename, mesh* mesh) {
 			vert.m_color = { 1.0f, 1.0f, 1.0f };
 
 			// Texture Coordinates
-			vert.m_texCoord = {
-				v_attrib.texcoords[2 * index.texcoord_index + 0],
-				v_attrib.texcoords[2 * index.texcoord_index + 1]
-			};
+			if (index.texcoord_index >= 0) {
+				vert.m_texCoord = {
+					v_attrib.texcoords[2 * index.texcoord_index + 0],
+					v_attrib.texcoords[2 * index.texcoord_index + 1]
+				};
+			}
+			else {
+				vert.m_texCoord = glm::vec2(0.0f, 0.0f);
+			}
 
 			// Normals
 			if (index.normal_index >= 0) {
@@ -46,7 +105,8 @@ bool load_obj(const char* baseDir, const char* filename, mesh* mesh) {
 				};
 			}
 			else {
-				vert.m_normal = glm::vec3(0.0f, 0.0f, 0.0f); //TODO: Calculate normals
+				vert.m_normal = glm::vec3(0.0f, 0.0f, 0.0f); // Generated below
+				missing_normals = true;
 			}
 
 			mesh->m_vertices.push_back(vert);
@@ -54,12 +114,28 @@ bool load_obj(const char* baseDir, const char* filename, mesh* mesh) {
 		}
 	}
 
-	printf(GREEN("\nSuccessfully Loaded obj: %s\n").c_str(), filename);
-	printf("# of vertices  = %d\n", (int)(v_attrib.vertices.size()) / 3);
-	printf("# of normals   = %d\n", (int)(v_attrib.normals.size()) / 3);
-	printf("# of texcoords = %d\n", (int)(v_attrib.texcoords.size()) / 2);
-	printf("# of materials = %d\n", (int)materials.size());
-	printf("# of shapes    = %d\n", (int)shapes.size());
+	// Faces without a (known) material share a default one
+	if (std::find(triangle_material.begin(), triangle_material.end(), default_material) != triangle_material.end()) {
+		mesh_material fallback;
+		fallback.name = "default";
+
+		mesh->m_materials.push_back(fallback);
+	}
+
+	build_submeshes(mesh->m_vertices, mesh->m_indices, triangle_material, missing_normals, !v_attrib.texcoords.empty(), mesh->m_submeshes);
+
+	mesh->split_meshlets();
+
+	LOG_DEBUG(MESH, "%zu submesh(es), split into %zu meshlets", mesh->m_submeshes.size(), mesh->m_meshlets.size());
+
+	mesh->compute_bounds();
+
+	LOG_INFO(MESH, "Successfully Loaded obj: %s", filename);
+	LOG_DEBUG(MESH, "# of vertices  = %d", (int)(v_attrib.vertices.size()) / 3);
+	LOG_DEBUG(MESH, "# of normals   = %d", (int)(v_attrib.normals.size()) / 3);
+	LOG_DEBUG(MESH, "# of texcoords = %d", (int)(v_attrib.texcoords.size()) / 2);
+	LOG_DEBUG(MESH, "# of materials = %d", (int)materials.size());
+	LOG_DEBUG(MESH, "# of shapes    = %d", (int)shapes.size());
 
 	return true;
 } // load_obj
\ No newline at end of file
@@ -11,7 +11,7 @@ struct object {
 
 	object() {}
 
-	~object() {
+	virtual ~object() {
 		deinit();
 
 		for (auto c : m_components) {
@@ -25,12 +25,24 @@ struct object {
 	virtual bool init() { return true; }
 	virtual void deinit() {}
 	
+	/**
+	* @brief Render time update, transforms are drawn between their last two simulation steps
+	*/
 	virtual void update(float dt) {
 		for (auto c : m_components) {
 			c->update(dt);
 		}
 	}
 
+	/**
+	* @brief Simulation step of fixed length dt (see fixed_clock), overrides call this first
+	*/
+	virtual void fixedUpdate(float dt) {
+		for (auto c : m_components) {
+			c->fixedUpdate(dt);
+		}
+	}
+
 	component* addComponent(component* component) {
 		component->m_object = this;
 
@@ -51,4 +63,15 @@ struct object {
  */
 bool load_obj(const char* baseDir, const char* filename, mesh* mesh);
 
+/**
+ * Turn loose triangles (three vertices each, indexed in order) into optimised submeshes with LODs
+ *
+ * Triangles are grouped by material, normals are generated where missing, then the
+ * vertices are deduplicated, given tangents (when textured) and optimised.
+ *
+ * @param triangle_material The mesh material id of every triangle
+ * @param submeshes Receives one submesh per material used
+ */
+void build_submeshes(std::vector<vertex>& vertices, std::vector<uint32_t>& indices, const std::vector<uint32_t>& triangle_material, bool missing_normals, bool has_texcoords, std::vector<submesh>& submeshes);
+
 #endif // _GAME_DATA_HPP
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef _POOL_HPP
+#define _POOL_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <new>
+
+#include "memory_tracker.hpp"
+
+constexpr size_t POOL_SLAB_OBJECTS = 64; // Objects per slab
+
+/**
+* @brief Slab allocator for objects of type T
+*
+* Slabs of POOL_SLAB_OBJECTS slots are taken from the heap (charged to memory_tag::POOLS)
+* and never given back, freed slots go on a free list and are reused first, so objects
+* of one type stay packed together. Objects in use are charged to tag. One thread.
+*/
+template <typename T, memory_tag tag>
+struct pool {
+	static void* allocate() {
+		if (!m_free) {
+			grow();
+		}
+
+		slot* s = m_free;
+		m_free = s->next;
+
+		++m_live;
+		memory_tracker::allocated(tag, sizeof(T));
+
+		return s->storage;
+	}
+
+	static void release(void* ptr) {
+		slot* s = static_cast<slot*>(ptr);
+		s->next = m_free;
+		m_free = s;
+
+		--m_live;
+		memory_tracker::freed(tag, sizeof(T));
+	}
+
+	static size_t live() { return m_live; }
+	static size_t capacity() { return m_slabs * POOL_SLAB_OBJECTS; }
+
+private:
+	union slot {
+		slot* next;
+		alignas(T) unsigned char storage[sizeof(T)];
+	};
+
+	static void grow() {
+		memory_scope scope(memory_tag::POOLS);
+
+		slot* slab = static_cast<slot*>(::operator new(sizeof(slot) * POOL_SLAB_OBJECTS, std::align_val_t(alignof(slot))));
+
+		for (size_t i = 0; i < POOL_SLAB_OBJECTS; ++i) {
+			slab[i].next = i + 1 < POOL_SLAB_OBJECTS ? &slab[i + 1] : m_free;
+		}
+
+		m_free = slab;
+		++m_slabs;
+	}
+
+	inline static slot* m_free = nullptr;
+	inline static size_t m_live = 0;
+	inline static size_t m_slabs = 0;
+}; // pool
+
+/**
+* @brief Gives T a class operator new/delete backed by pool<T, tag>
+*
+* Inherit from it in the most derived class (class earth : public loaded_obj, public pooled<earth, ...>).
+* Classes deriving further fall back to the global heap, their size does not fit the slots.
+*/
+template <typename T, memory_tag tag>
+struct pooled {
+	static void* operator new(size_t size) {
+		return size == sizeof(T) ? pool<T, tag>::allocate() : ::operator new(size);
+	}
+
+	static void operator delete(void* ptr, size_t size) {
+		if (size == sizeof(T)) {
+			pool<T, tag>::release(ptr);
+		}
+		else {
+			::operator delete(ptr);
+		}
+	}
+}; // pooled
+
+#endif // _POOL_HPP
@@ -0,0 +1,468 @@
+#include "gl.hpp"
+#include <unordered_map>
+#include <string_view>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <map>
+#include <string>
+#include <vector>
+#include <mutex>
+
+#include "log.hpp"
+#include "profiler.hpp"
+
+constexpr size_t PROFILE_THREAD_EVENTS = 8192;  // Scopes a thread can record between two end_frame() calls (power of two)
+constexpr size_t GPU_QUERY_FRAMES = 4;          // Frames a GPU query has to finish before it is read back
+constexpr size_t GPU_QUERIES_PER_FRAME = 32;
+constexpr uint32_t GPU_TRACK = 0xffff;          // Trace thread id of the GPU scopes
+
+struct profile_event {
+	uint32_t node;
+	int64_t start_ns;
+	int64_t end_ns;
+};
+
+/**
+* @brief Single producer (the owning thread), single consumer (end_frame) event ring
+*/
+struct profile_thread {
+	uint32_t id;
+	std::string name; // Guarded by profiler_state::threads_mutex
+
+	profile_event events[PROFILE_THREAD_EVENTS];
+	std::atomic<size_t> head; // Next event written by the owner
+	std::atomic<size_t> tail; // Next event collected by end_frame
+	std::atomic<size_t> dropped;
+
+	// Owner only
+	std::vector<uint32_t> open;                                    // Nodes of the scopes open on the thread, innermost last
+	std::map<std::pair<uint32_t, const char*>, uint32_t> children; // (parent node, name) seen by this thread, saves the lock
+};
+
+/**
+* @brief A scope name under a given parent, node 0 is the root every outermost scope hangs from
+*/
+struct profile_node {
+	const char* name;
+	uint32_t parent;
+	uint32_t depth;
+	std::string path;
+};
+
+struct gpu_query_frame {
+	GLuint queries[GPU_QUERIES_PER_FRAME];
+	uint32_t nodes[GPU_QUERIES_PER_FRAME];
+	int64_t cpu_start[GPU_QUERIES_PER_FRAME]; // Where the GPU scope goes in a trace
+	size_t count;
+};
+
+struct profile_entry {
+	profile_stats stats;
+	float frame_ms;
+	uint32_t frame_calls;
+};
+
+struct captured_event {
+	profile_event event;
+	uint32_t thread;
+};
+
+struct profiler_state {
+	std::mutex threads_mutex;
+	std::vector<std::unique_ptr<profile_thread>> threads;
+
+	std::mutex nodes_mutex;
+	std::vector<profile_node> nodes = { { "", 0, 0, "" } };
+	std::unordered_map<std::string, uint32_t> paths; // Path to node
+
+	std::unordered_map<uint32_t, profile_entry> cpu_entries; // Keyed by node
+	std::unordered_map<uint32_t, profile_entry> gpu_entries;
+
+	int gpu_supported = -1; // -1: not checked yet
+	bool gpu_active = false;
+	size_t gpu_frame = 0;
+	size_t gpu_unavailable = 0; // Frames whose queries were still running when their slot came round again
+	gpu_query_frame gpu_frames[GPU_QUERY_FRAMES] = {};
+
+	size_t capture_frames = 0;
+	std::string capture_path;
+	std::vector<captured_event> captured;
+};
+
+static profiler_state& state() {
+	static profiler_state instance;
+	return instance;
+}
+
+static const std::chrono::steady_clock::time_point profiler_epoch = std::chrono::steady_clock::now();
+
+static profile_thread* register_thread() {
+	profiler_state& s = state();
+	std::lock_guard<std::mutex> lock(s.threads_mutex);
+
+	profile_thread* thread = new profile_thread();
+	thread->id = (uint32_t)s.threads.size();
+	thread->name = "Thread " + std::to_string(thread->id);
+
+	s.threads.emplace_back(thread);
+
+	return thread;
+}
+
+static profile_thread* this_thread() {
+	thread_local profile_thread* thread = register_thread();
+	return thread;
+}
+
+/**
+* @brief Node of name under parent, created the first time any thread opens that path
+*/
+static uint32_t intern_node(uint32_t parent, const char* name) {
+	profiler_state& s = state();
+	std::lock_guard<std::mutex> lock(s.nodes_mutex);
+
+	std::string path = parent ? s.nodes[parent].path + "/" + name : std::string(name);
+
+	auto [it, inserted] = s.paths.try_emplace(path, (uint32_t)s.nodes.size());
+	if (inserted) {
+		uint32_t depth = parent ? s.nodes[parent].depth + 1 : 0;
+		s.nodes.push_back({ name, parent, depth, std::move(path) });
+	}
+
+	return it->second;
+}
+
+/**
+* @brief Node of name under the innermost scope open on thread
+*/
+static uint32_t child_node(profile_thread* thread, const char* name) {
+	uint32_t parent = thread->open.empty() ? 0 : thread->open.back();
+
+	auto [it, inserted] = thread->children.try_emplace({ parent, name }, 0);
+	if (inserted) {
+		it->second = intern_node(parent, name);
+	}
+
+	return it->second;
+}
+
+static void accumulate(std::unordered_map<uint32_t, profile_entry>& entries, const profile_event& event) {
+	profile_entry& entry = entries[event.node];
+
+	entry.frame_ms += (float)((event.end_ns - event.start_ns) / 1e6);
+	entry.frame_calls += 1;
+}
+
+static void update_stats(std::unordered_map<uint32_t, profile_entry>& entries) {
+	for (auto& [node, entry] : entries) {
+		profile_stats& stats = entry.stats;
+
+		stats.history[stats.frames % PROFILE_HISTORY] = entry.frame_ms;
+		stats.frames += 1;
+		stats.last_ms = entry.frame_ms;
+		stats.calls = entry.frame_calls;
+
+		size_t count = std::min(stats.frames, PROFILE_HISTORY);
+		float sum = 0.0f;
+		stats.min_ms = stats.history[0];
+		stats.max_ms = stats.history[0];
+
+		for (size_t i = 0; i < count; ++i) {
+			sum += stats.history[i];
+			stats.min_ms = std::min(stats.min_ms, stats.history[i]);
+			stats.max_ms = std::max(stats.max_ms, stats.history[i]);
+		}
+
+		stats.average_ms = sum / (float)count;
+
+		entry.frame_ms = 0.0f;
+		entry.frame_calls = 0;
+	}
+}
+
+static void write_json_string(FILE* file, std::string_view str) {
+	fputc('"', file);
+
+	for (char c : str) {
+		if (c == '"' || c == '\\') {
+			fputc('\\', file);
+		}
+
+		fputc(c, file);
+	}
+
+	fputc('"', file);
+}
+
+static void write_trace(profiler_state& s) {
+	FILE* file = fopen(s.capture_path.c_str(), "w");
+	if (!file) {
+		LOG_ERROR(CORE, "Failed to write profiler trace %s", s.capture_path.c_str());
+		return;
+	}
+
+	fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+	{
+		std::lock_guard<std::mutex> lock(s.threads_mutex);
+
+		for (const auto& thread : s.threads) {
+			fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", thread->id);
+			write_json_string(file, thread->name);
+			fprintf(file, "}},\n");
+		}
+	}
+
+	fprintf(file, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"GPU\"}}", GPU_TRACK);
+
+	std::lock_guard<std::mutex> lock(s.nodes_mutex);
+
+	for (const captured_event& captured : s.captured) {
+		fprintf(file, ",\n{\"name\":");
+		write_json_string(file, s.nodes[captured.event.node].name);
+		fprintf(file, ",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u}", captured.thread == GPU_TRACK ? "gpu" : "cpu",
+			captured.event.start_ns / 1e3, (captured.event.end_ns - captured.event.start_ns) / 1e3, captured.thread);
+	}
+
+	fprintf(file, "\n]}\n");
+	fclose(file);
+
+	LOG_INFO(CORE, "Wrote %zu profiler events to %s", s.captured.size(), s.capture_path.c_str());
+}
+
+int64_t profiler::now() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - profiler_epoch).count();
+} // now
+
+uint32_t profiler::begin(const char* name) {
+	profile_thread* thread = this_thread();
+
+	uint32_t node = child_node(thread, name);
+	thread->open.push_back(node);
+
+	return node;
+} // begin
+
+void profiler::record(uint32_t node, int64_t start_ns, int64_t end_ns) {
+	profile_thread* thread = this_thread();
+	thread->open.pop_back();
+
+	size_t head = thread->head.load(std::memory_order_relaxed);
+	if (head - thread->tail.load(std::memory_order_acquire) >= PROFILE_THREAD_EVENTS) {
+		thread->dropped.fetch_add(1, std::memory_order_relaxed); // No end_frame for too long
+		return;
+	}
+
+	thread->events[head & (PROFILE_THREAD_EVENTS - 1)] = { node, start_ns, end_ns };
+	thread->head.store(head + 1, std::memory_order_release);
+} // record
+
+bool profiler::gpu_begin(const char* name) {
+	profiler_state& s = state();
+
+	if (s.gpu_supported < 0) {
+		s.gpu_supported = GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+
+		if (s.gpu_supported) {
+			for (gpu_query_frame& frame : s.gpu_frames) {
+				glGenQueries(GPU_QUERIES_PER_FRAME, frame.queries);
+			}
+		}
+		else {
+			LOG_WARNING(CORE, "GL_TIME_ELAPSED queries not supported, GPU scopes disabled");
+		}
+	}
+
+	gpu_query_frame& frame = s.gpu_frames[s.gpu_frame];
+
+	if (!s.gpu_supported || s.gpu_active || frame.count == GPU_QUERIES_PER_FRAME)
+		return false;
+
+	frame.nodes[frame.count] = child_node(this_thread(), name);
+	frame.cpu_start[frame.count] = now();
+	glBeginQuery(GL_TIME_ELAPSED, frame.queries[frame.count]);
+
+	s.gpu_active = true;
+
+	return true;
+} // gpu_begin
+
+void profiler::gpu_end() {
+	profiler_state& s = state();
+
+	glEndQuery(GL_TIME_ELAPSED);
+
+	s.gpu_frames[s.gpu_frame].count += 1;
+	s.gpu_active = false;
+} // gpu_end
+
+void profiler::end_frame() {
+	profiler_state& s = state();
+	bool capturing = s.capture_frames > 0;
+
+	// CPU scopes of every thread
+	{
+		std::lock_guard<std::mutex> lock(s.threads_mutex);
+
+		for (const auto& thread : s.threads) {
+			size_t head = thread->head.load(std::memory_order_acquire);
+			size_t tail = thread->tail.load(std::memory_order_relaxed);
+
+			for (; tail != head; ++tail) {
+				const profile_event& event = thread->events[tail & (PROFILE_THREAD_EVENTS - 1)];
+
+				accumulate(s.cpu_entries, event);
+
+				if (capturing) {
+					s.captured.push_back({ event, thread->id });
+				}
+			}
+
+			thread->tail.store(tail, std::memory_order_release);
+		}
+	}
+
+	// GPU scopes of the oldest frame in the ring, its slot is reused next
+	if (s.gpu_supported > 0) {
+		s.gpu_frame = (s.gpu_frame + 1) % GPU_QUERY_FRAMES;
+		gpu_query_frame& frame = s.gpu_frames[s.gpu_frame];
+
+		if (frame.count > 0) {
+			GLint available = 0;
+			glGetQueryObjectiv(frame.queries[frame.count - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+
+			if (available) {
+				for (size_t i = 0; i < frame.count; ++i) {
+					GLuint64 elapsed = 0;
+					glGetQueryObjectui64v(frame.queries[i], GL_QUERY_RESULT, &elapsed);
+
+					profile_event event = { frame.nodes[i], frame.cpu_start[i], frame.cpu_start[i] + (int64_t)elapsed };
+					accumulate(s.gpu_entries, event);
+
+					if (capturing) {
+						s.captured.push_back({ event, GPU_TRACK });
+					}
+				}
+			}
+			else {
+				++s.gpu_unavailable; // Never stall on the GPU, drop the frame instead
+			}
+
+			frame.count = 0;
+		}
+	}
+
+	update_stats(s.cpu_entries);
+	update_stats(s.gpu_entries);
+
+	if (capturing && --s.capture_frames == 0) {
+		write_trace(s);
+		s.captured.clear();
+	}
+} // end_frame
+
+void profiler::set_thread_name(const char* name) {
+	profile_thread* thread = this_thread();
+	profiler_state& s = state();
+
+	std::lock_guard<std::mutex> lock(s.threads_mutex);
+	thread->name = name;
+} // set_thread_name
+
+void profiler::capture(size_t frames, const std::string& path) {
+	profiler_state& s = state();
+
+	s.capture_frames = frames;
+	s.capture_path = path;
+	s.captured.clear();
+
+	LOG_INFO(CORE, "Capturing %zu frames to %s", frames, path.c_str());
+} // capture
+
+const profile_stats* profiler::stats(const char* path, bool gpu) {
+	profiler_state& s = state();
+	auto& entries = gpu ? s.gpu_entries : s.cpu_entries;
+
+	uint32_t node;
+	{
+		std::lock_guard<std::mutex> lock(s.nodes_mutex);
+
+		auto path_it = s.paths.find(path);
+		if (path_it == s.paths.end())
+			return nullptr;
+
+		node = path_it->second;
+	}
+
+	auto it = entries.find(node);
+	return it != entries.end() ? &it->second.stats : nullptr;
+} // stats
+
+void profiler::log_stats() {
+	profiler_state& s = state();
+	std::lock_guard<std::mutex> lock(s.nodes_mutex);
+
+	// Depth first over the call tree, siblings by name
+	std::vector<std::vector<uint32_t>> children(s.nodes.size());
+
+	for (uint32_t node = 1; node < (uint32_t)s.nodes.size(); ++node) {
+		children[s.nodes[node].parent].push_back(node);
+	}
+
+	std::vector<uint32_t> order;
+	std::vector<uint32_t> pending = { 0 };
+
+	while (!pending.empty()) {
+		uint32_t node = pending.back();
+		pending.pop_back();
+
+		if (node) {
+			order.push_back(node);
+		}
+
+		std::vector<uint32_t>& next = children[node];
+		std::sort(next.begin(), next.end(), [&](uint32_t a, uint32_t b) {
+			return std::string_view(s.nodes[a].name) > std::string_view(s.nodes[b].name); // Reversed, popped from the back
+		});
+
+		pending.insert(pending.end(), next.begin(), next.end());
+	}
+
+	// CPU scopes indented under their parent, GPU scopes by their full path (their parent is a CPU scope)
+	for (bool gpu : { false, true }) {
+		auto& entries = gpu ? s.gpu_entries : s.cpu_entries;
+
+		for (uint32_t node : order) {
+			auto it = entries.find(node);
+			if (it == entries.end())
+				continue;
+
+			const profile_node& info = s.nodes[node];
+			const profile_stats& stats = it->second.stats;
+
+			int indent = gpu ? 0 : (int)info.depth * 2;
+			const char* name = gpu ? info.path.c_str() : info.name;
+
+			LOG_INFO(CORE, "%s %*s%-*s avg %7.3f ms  min %7.3f  max %7.3f  (%u call(s) last frame)", gpu ? "GPU" : "CPU",
+				indent, "", std::max(32 - indent, 0), name, stats.average_ms, stats.min_ms, stats.max_ms, stats.calls);
+		}
+	}
+
+	size_t dropped = 0;
+	{
+		std::lock_guard<std::mutex> lock(s.threads_mutex);
+
+		for (const auto& thread : s.threads) {
+			dropped += thread->dropped.load(std::memory_order_relaxed);
+		}
+	}
+
+	if (dropped || s.gpu_unavailable) {
+		LOG_WARNING(CORE, "Profiler dropped %zu CPU scopes and %zu GPU frames", dropped, s.gpu_unavailable);
+	}
+} // log_stats
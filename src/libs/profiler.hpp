@@ -0,0 +1,125 @@
+#ifndef _PROFILER_HPP
+#define _PROFILER_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Set to 0 to compile every PROFILE_* marker out
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+constexpr size_t PROFILE_HISTORY = 120; // Frames the rolling statistics cover
+
+/**
+* @brief Rolling per frame statistics of one scope in the call tree (summed over every call in a frame)
+*/
+struct profile_stats {
+	float last_ms;
+	float average_ms;
+	float min_ms;
+	float max_ms;
+	uint32_t calls; // In the last frame
+
+	float history[PROFILE_HISTORY];
+	size_t frames;
+};
+
+/**
+* @brief Hierarchical CPU/GPU frame profiler
+*
+* Statistics are kept per call path ("Frame/Objects/Draw"), a scope is keyed by the
+* scopes open around it on its thread, so one name under two parents stays two entries.
+* A GPU scope hangs under the CPU scope open around it, the same way. CPU scopes go to a lock-free buffer owned by the recording thread and are collected
+* by end_frame() on the main thread. GPU scopes wrap GL_TIME_ELAPSED queries from a
+* ring a few frames deep, results are read back once available so the CPU never
+* waits on the GPU. GPU scopes cannot nest (one GL_TIME_ELAPSED query at a time),
+* nested ones are ignored.
+*/
+struct profiler {
+	/**
+	* @brief Close the frame: collect every thread's scopes, read back finished GPU queries and update the statistics
+	*/
+	static void end_frame();
+
+	/**
+	* @brief Name of the calling thread in exported traces
+	*/
+	static void set_thread_name(const char* name);
+
+	/**
+	* @brief Record the next frames and write them to path as Chrome trace-event JSON (chrome://tracing, Perfetto)
+	*/
+	static void capture(size_t frames, const std::string& path);
+
+	/**
+	* @brief Statistics of a scope, null if it never ran
+	*
+	* @param path Names from the outermost scope down, separated by '/' ("Frame/Sprites/Sprite sort")
+	*/
+	static const profile_stats* stats(const char* path, bool gpu = false);
+
+	/**
+	* @brief Log the rolling statistics of every scope, CPU scopes as a call tree
+	*/
+	static void log_stats();
+
+	// Used by the scope markers
+	static int64_t now();
+	static uint32_t begin(const char* name); // Opens a scope on the calling thread, returns its call tree node
+	static void record(uint32_t node, int64_t start_ns, int64_t end_ns); // Closes the innermost scope
+	static bool gpu_begin(const char* name);
+	static void gpu_end();
+}; // profiler
+
+/**
+* @brief Times the CPU from construction to destruction
+*/
+struct profile_scope {
+	uint32_t m_node;
+	int64_t m_start;
+
+	profile_scope(const char* name) : m_node(profiler::begin(name)), m_start(profiler::now()) {}
+
+	~profile_scope() {
+		profiler::record(m_node, m_start, profiler::now());
+	}
+
+	profile_scope(profile_scope&) = delete; // No copy constructor
+	profile_scope& operator=(const profile_scope&) = delete; // No copy assignment
+}; // profile_scope
+
+/**
+* @brief Times the GPU work submitted from construction to destruction
+*/
+struct gpu_profile_scope {
+	bool m_active;
+
+	gpu_profile_scope(const char* name) : m_active(profiler::gpu_begin(name)) {}
+
+	~gpu_profile_scope() {
+		if (m_active) {
+			profiler::gpu_end();
+		}
+	}
+
+	gpu_profile_scope(gpu_profile_scope&) = delete; // No copy constructor
+	gpu_profile_scope& operator=(const gpu_profile_scope&) = delete; // No copy assignment
+}; // gpu_profile_scope
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Names must be string literals (or otherwise outlive the profiler)
+#if PROFILER_ENABLED
+#define PROFILE_SCOPE(name) profile_scope PROFILE_CONCAT(profile_scope_, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) gpu_profile_scope PROFILE_CONCAT(gpu_profile_scope_, __LINE__)(name)
+#define PROFILE_FRAME() profiler::end_frame()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_GPU_SCOPE(name)
+#define PROFILE_FRAME()
+#endif
+
+#endif // _PROFILER_HPP
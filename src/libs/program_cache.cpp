@@ -0,0 +1,138 @@
+#include "gl.hpp"
+#include <filesystem>
+#include <cinttypes>
+#include <fstream>
+#include <cstdio>
+
+#include "log.hpp"
+#include "hash.hpp"
+#include "program_cache.hpp"
+
+constexpr uint32_t PROGRAM_CACHE_MAGIC = 0x504c474c; // "LGLP"
+constexpr uint32_t PROGRAM_CACHE_VERSION = 1;
+
+struct program_cache_header {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;
+	uint32_t format;
+	uint32_t length;
+};
+
+uint64_t program_cache::key(const std::vector<shader_source*>& sources) {
+	uint64_t hash = FNV_OFFSET_BASIS;
+
+	for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+		const char* str = (const char*)glGetString(name);
+		hash = fnv1a(str ? str : "", hash);
+	}
+
+	for (const shader_source* source : sources) {
+		hash = fnv1a(&source->m_type, sizeof(source->m_type), hash);
+		hash = fnv1a(&source->m_preprocessed.hash, sizeof(source->m_preprocessed.hash), hash);
+	}
+
+	return hash;
+} // key
+
+bool program_cache::load(uint64_t key, GLuint program) {
+	if (!enabled || !supported())
+		return false;
+
+	std::ifstream file(path(key), std::ios::binary);
+	if (!file.is_open())
+		return false; // Cold cache
+
+	program_cache_header header = {};
+	file.read((char*)&header, sizeof(header));
+
+	if (!file || header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION || header.key != key) {
+		LOG_ERROR(SHADER, "Ignoring invalid program cache entry %s", path(key).c_str());
+		return false;
+	}
+
+	std::vector<char> binary(header.length);
+	file.read(binary.data(), header.length);
+
+	if (!file) {
+		LOG_ERROR(SHADER, "Truncated program cache entry %s", path(key).c_str());
+		return false;
+	}
+
+	glProgramBinary(program, header.format, binary.data(), (GLsizei)header.length);
+
+	GLint linked = GL_FALSE;
+	glGetProgramiv(program, GL_LINK_STATUS, &linked);
+
+	if (!linked) {
+		// Driver rejected the blob (e.g. driver update with the same version string), rebuild it
+		LOG_WARNING(SHADER, "Driver rejected cached program %016" PRIx64 ", recompiling", key);
+		file.close();
+		std::filesystem::remove(path(key));
+		return false;
+	}
+
+	return true;
+} // load
+
+void program_cache::store(uint64_t key, GLuint program) {
+	if (!enabled || !supported())
+		return;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+
+	if (length <= 0)
+		return;
+
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(program, length, &length, &format, binary.data());
+
+	program_cache_header header = { PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, key, format, (uint32_t)length };
+
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+
+	// Write to a temporary and rename so a crash never leaves a half written entry behind
+	std::string final_path = path(key);
+	std::string temp_path = final_path + ".tmp";
+
+	{
+		std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open()) {
+			LOG_ERROR(SHADER, "Failed to write program cache entry %s", temp_path.c_str());
+			return;
+		}
+
+		file.write((const char*)&header, sizeof(header));
+		file.write(binary.data(), length);
+	}
+
+	std::filesystem::rename(temp_path, final_path, ec);
+	if (ec) {
+		LOG_ERROR(SHADER, "Failed to write program cache entry %s", final_path.c_str());
+		std::filesystem::remove(temp_path, ec);
+	}
+} // store
+
+std::string program_cache::path(uint64_t key) {
+	char name[32];
+	snprintf(name, sizeof(name), "%016" PRIx64 ".bin", key);
+
+	return directory + "/" + name;
+} // path
+
+bool program_cache::supported() {
+	static GLint formats = -1;
+
+	if (formats < 0) {
+		glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+
+		if (formats == 0) {
+			LOG_WARNING(SHADER, "Driver exposes no program binary formats, program cache disabled");
+		}
+	}
+
+	return formats > 0;
+} // supported
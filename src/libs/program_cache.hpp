@@ -0,0 +1,43 @@
+#ifndef _PROGRAM_CACHE_HPP
+#define _PROGRAM_CACHE_HPP
+
+#include "gl.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shader_source.hpp"
+
+/**
+* @brief On-disk cache of linked program binaries (glGetProgramBinary / glProgramBinary)
+*
+* Entries are keyed by a hash of the preprocessed shader sources and the GL vendor, renderer and
+* version strings, so a driver update or a source edit simply misses the cache.
+*/
+struct program_cache {
+	inline static std::string directory = "cache/shaders";
+	inline static bool enabled = true;
+
+	/**
+	* @brief Hash the preprocessed sources of a program together with the current GL driver
+	*/
+	static uint64_t key(const std::vector<shader_source*>& sources);
+
+	/**
+	* @brief Load a cached binary into the program
+	*
+	* @return bool True if the driver accepted the binary and the program is linked
+	*/
+	static bool load(uint64_t key, GLuint program);
+
+	/**
+	* @brief Save the binary of a linked program (must be linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT)
+	*/
+	static void store(uint64_t key, GLuint program);
+
+private:
+	static std::string path(uint64_t key);
+	static bool supported();
+}; // program_cache
+
+#endif // _PROGRAM_CACHE_HPP
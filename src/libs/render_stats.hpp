@@ -0,0 +1,35 @@
+#ifndef _RENDER_STATS_HPP
+#define _RENDER_STATS_HPP
+
+#include <cstdint>
+
+/**
+* @brief GL work submitted since the last reset(), counted where the engine issues it
+*
+* Only the main thread draws, so the counters are plain integers. State changes are
+* the binds that make the driver revalidate (programs, vertex arrays, textures);
+* uniform uploads are counted apart since they do not.
+*/
+struct render_stats {
+	inline static uint32_t draw_calls = 0;      // glDraw* and glMultiDraw* calls
+	inline static uint32_t draw_ranges = 0;     // Index ranges drawn (a multi draw counts each of its ranges)
+	inline static uint32_t program_binds = 0;
+	inline static uint32_t vao_binds = 0;
+	inline static uint32_t texture_binds = 0;
+	inline static uint32_t uniform_uploads = 0;
+
+	static uint32_t state_changes() {
+		return program_binds + vao_binds + texture_binds;
+	}
+
+	static void reset() {
+		draw_calls = 0;
+		draw_ranges = 0;
+		program_binds = 0;
+		vao_binds = 0;
+		texture_binds = 0;
+		uniform_uploads = 0;
+	}
+}; // render_stats
+
+#endif // _RENDER_STATS_HPP
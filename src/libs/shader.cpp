@@ -1,28 +1,156 @@
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <string>
+#include <chrono>
 #include <cstdio>
 
-#include "scolor.hpp"
+#include "log.hpp"
+#include "vertex.hpp"
+#include "program_cache.hpp"
 #include "shader_source.hpp"
 #include "shader.hpp"
+#include "render_stats.hpp"
 
-void shader::add(GLuint type, const char* filepath) {
-	auto _ = shader_source(this->m_handle, type, filepath);
+void shader::add(GLuint type, const char* filepath, const std::vector<shader_define>& defines) {
+	this->m_shaders.push_back(new shader_source(type, filepath, defines));
 } // add
 
 void shader::link() {
-	// Link the program
+	submit();
+	finish();
+} // link
+
+void shader::submit() {
+	this->m_submitTime = std::chrono::steady_clock::now();
+	this->m_key = program_cache::key(this->m_shaders);
+	this->m_isPending = true;
+
+	// Warm start: skip compiling entirely
+	this->m_fromCache = program_cache::load(this->m_key, this->m_handle);
+
+	if (this->m_fromCache)
+		return;
+
+	for (auto s : this->m_shaders) {
+		s->submit(this->m_handle);
+	}
+
+	// Fixed attribute locations so vertex arrays stay valid when the program is reloaded
+	for (GLuint i = 0; i < sizeof(vertex_attr_strings) / sizeof(vertex_attr_strings[0]); ++i) {
+		glBindAttribLocation(this->m_handle, i, vertex_attr_strings[i]);
+	}
+
+	// Link the program, the driver may keep working on it in the background
+	glProgramParameteri(this->m_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
 	glLinkProgram(this->m_handle);
+} // submit
+
+bool shader::isComplete() const {
+	if (!this->m_isPending || this->m_fromCache)
+		return true;
+
+	// Without the extension every query blocks, so report done and let finish() wait
+	if (!GLEW_KHR_parallel_shader_compile && !GLEW_ARB_parallel_shader_compile)
+		return true;
+
+	GLint complete = GL_TRUE;
+	glGetProgramiv(this->m_handle, GL_COMPLETION_STATUS_KHR, &complete);
+
+	return complete == GL_TRUE;
+} // isComplete
+
+bool shader::finish() {
+	if (!this->m_isPending)
+		return this->m_isLinked;
+
+	this->m_isPending = false;
+
+	if (this->m_fromCache) {
+		this->m_isLinked = GL_TRUE;
+		this->m_reflection.reflect(this->m_handle);
+		++this->m_generation;
+
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - this->m_submitTime;
+		LOG_INFO(SHADER, "Link Success (program cache, %.2f ms)", elapsed.count());
+		return true;
+	}
+
+	for (auto s : this->m_shaders) {
+		s->finish();
+	}
+
 	glGetProgramiv(this->m_handle, GL_LINK_STATUS, &this->m_isLinked);
 
 	if (!this->m_isLinked) {
-		fprintf(stderr, RED("Link Failed\n").c_str());
-		return;
+		LOG_ERROR(SHADER, "Link Failed");
+		return false;
 	}
 
-	printf(GREEN("Link Success\n").c_str());
-} // link
+	program_cache::store(this->m_key, this->m_handle);
+
+	this->m_reflection.reflect(this->m_handle);
+	++this->m_generation;
+
+	std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - this->m_submitTime;
+	LOG_INFO(SHADER, "Link Success (compiled, %.2f ms since submit)", elapsed.count());
+
+	return true;
+} // finish
 
 void shader::use() const {
 	glUseProgram(m_handle);
-} // use
\ No newline at end of file
+
+	render_stats::program_binds += 1;
+} // use
+
+bool shader::reload() {
+	shader next = shader();
+
+	for (auto s : this->m_shaders) {
+		next.add(s->m_type, s->m_source, s->m_defines);
+	}
+
+	next.link();
+
+	if (!next.m_isLinked) {
+		LOG_ERROR(SHADER, "Reload failed, keeping the previous program");
+		return false;
+	}
+
+	// The old program and sources are deleted with next
+	std::swap(this->m_handle, next.m_handle);
+	std::swap(this->m_shaders, next.m_shaders);
+	std::swap(this->m_reflection, next.m_reflection);
+	this->m_isLinked = GL_TRUE;
+	++this->m_generation;
+
+	return true;
+} // reload
+
+void shader::reloadChanged(const std::vector<std::string>& files) {
+	shader_preprocessor& preprocessor = shader_preprocessor::get();
+	std::unordered_set<std::string> roots;
+
+	for (const std::string& file : files) {
+		preprocessor.invalidate(file);
+
+		for (const std::string& dependent : preprocessor.dependents(file)) {
+			roots.insert(dependent);
+		}
+	}
+
+	// Copy, reloading constructs and destroys temporary shaders
+	std::vector<shader*> shaders(registry.begin(), registry.end());
+
+	for (shader* s : shaders) {
+		bool affected = false;
+
+		for (auto source : s->m_shaders) {
+			affected |= roots.count(shader_preprocessor::normalize(source->m_source)) != 0;
+		}
+
+		if (affected && s->m_isLinked) {
+			LOG_INFO(SHADER, "Reloading shader %s", s->m_shaders.empty() ? "" : s->m_shaders[0]->m_source);
+			s->reload();
+		}
+	}
+} // reloadChanged
@@ -1,31 +1,49 @@
 #ifndef _COMPLILE_SHADERS_HPP
 #define _COMPLILE_SHADERS_HPP
 
-#include <GLEW/glew.h>
+#include "gl.hpp"
+#include <unordered_set>
 #include <stdexcept>
+#include <cstdint>
 #include <vector>
+#include <chrono>
 #include <string>
 #include <cstdio>
 
-#include "scolor.hpp"
+#include "log.hpp"
 #include "shader_source.hpp"
+#include "shader_reflection.hpp"
 
 class shader {
 public:
 	GLuint m_handle;
 	GLint m_isLinked;
+	bool m_isPending; // Submitted to the driver, results not collected yet
+	uint32_t m_generation; // Bumped every time a program is linked or reload() swaps one in
 
-	std::vector<shader_source> m_shaders;
+	shader_reflection m_reflection; // Uniforms, blocks and attributes of the linked program
+
+	std::vector<shader_source*> m_shaders;
+
+	inline static std::unordered_set<shader*> registry; // Every live shader, for hot reloading
 
 	/**
 	* @brief Buider style shader compiler
 	*/
-	shader() : m_handle(glCreateProgram()), m_isLinked(GL_FALSE) {
-		printf(BLUE("Constructing shader\n").c_str());
+	shader() : m_handle(glCreateProgram()), m_isLinked(GL_FALSE), m_isPending(false), m_generation(0), m_key(0), m_fromCache(false) {
+		LOG_TRACE(SHADER, "Constructing shader");
 		if (!this->m_handle) { throw std::runtime_error("Failed to create shader handle"); }
+
+		registry.insert(this);
 	}
 
 	~shader() {
+		registry.erase(this);
+
+		for (auto s : m_shaders) {
+			delete s;
+		}
+
 		glDeleteProgram(this->m_handle);
 	}
 
@@ -33,19 +51,62 @@ public:
 	shader& operator=(const shader&) = delete; // No copy assignment
 
 	/**
-	* @brief Attach a shader source to the shader program
+	* @brief Read a shader source for the shader program
+	*
+	* @param defines Injected as #define NAME VALUE after the #version line
 	*/
-	void add(GLuint type, const char* filepath);
+	void add(GLuint type, const char* filepath, const std::vector<shader_define>& defines = {});
 
 	/**
-	* @brief Link the shader to the GPU
+	* @brief Link the shader to the GPU, loading the program binary from the program cache when possible
 	*/
 	void link();
 
+	/**
+	* @brief Start compiling and linking without waiting for the driver (see shader_batch)
+	*/
+	void submit();
+
+	/**
+	* @brief Non-blocking check whether the driver finished compiling and linking (GL_COMPLETION_STATUS_KHR)
+	*/
+	bool isComplete() const;
+
+	/**
+	* @brief Collect the compile and link results of a submitted shader, blocking if it is still compiling
+	*
+	* @return bool True if the program linked
+	*/
+	bool finish();
+
+	/**
+	* @brief True if the last submit restored the program from the program cache instead of compiling it
+	*/
+	bool fromCache() const { return m_fromCache; }
+
 	/**
 	* @brief
 	*/
 	void use() const;
+
+	/**
+	* @brief Rebuild the program from its source files, keeping the current program if the new one fails
+	*
+	* @return bool True if a new program was swapped in
+	*/
+	bool reload();
+
+	/**
+	* @brief Reload every shader built from the changed files, directly or through #include
+	*
+	* Call at the start of a frame so a frame never mixes old and new programs.
+	*/
+	static void reloadChanged(const std::vector<std::string>& files);
+
+private:
+	uint64_t m_key;
+	bool m_fromCache;
+	std::chrono::steady_clock::time_point m_submitTime;
 }; // shader
 
 #endif // _COMPLILE_SHADERS_HPP
@@ -0,0 +1,52 @@
+#include "gl.hpp"
+#include <algorithm>
+#include <cstdio>
+
+#include "log.hpp"
+#include "shader_batch.hpp"
+
+void shader_batch::add(shader* s) {
+	if (std::find(this->m_shaders.begin(), this->m_shaders.end(), s) != this->m_shaders.end())
+		return;
+
+	this->m_shaders.push_back(s);
+} // add
+
+void shader_batch::submit() {
+	// Let the driver pick how many compiler threads to use
+	if (GLEW_KHR_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF);
+	}
+	else if (GLEW_ARB_parallel_shader_compile) {
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+	}
+	else {
+		LOG_WARNING(SHADER, "KHR_parallel_shader_compile not supported, shaders will compile serially");
+	}
+
+	for (shader* s : this->m_shaders) {
+		s->submit();
+	}
+} // submit
+
+size_t shader_batch::poll() const {
+	size_t pending = 0;
+
+	for (const shader* s : this->m_shaders) {
+		if (!s->isComplete()) {
+			++pending;
+		}
+	}
+
+	return pending;
+} // poll
+
+bool shader_batch::finish() {
+	bool linked = true;
+
+	for (shader* s : this->m_shaders) {
+		linked &= s->finish();
+	}
+
+	return linked;
+} // finish
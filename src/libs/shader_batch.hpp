@@ -0,0 +1,49 @@
+#ifndef _SHADER_BATCH_HPP
+#define _SHADER_BATCH_HPP
+
+#include "gl.hpp"
+#include <vector>
+
+#include "shader.hpp"
+
+/**
+* @brief Compile many shader programs in parallel
+*
+* All programs are submitted up front so a driver with KHR_parallel_shader_compile
+* can build them on its own threads while the caller keeps loading other assets.
+*/
+class shader_batch {
+public:
+	std::vector<shader*> m_shaders;
+
+	shader_batch() {}
+
+	shader_batch(shader_batch&) = delete; // No copy constructor
+	shader_batch& operator=(const shader_batch&) = delete; // No copy assignment
+
+	/**
+	* @brief Add a shader whose sources have been added but which has not been linked (duplicates are ignored)
+	*/
+	void add(shader* s);
+
+	/**
+	* @brief Start compiling and linking every program in the batch
+	*/
+	void submit();
+
+	/**
+	* @brief Non-blocking poll
+	*
+	* @return size_t Number of programs the driver is still working on
+	*/
+	size_t poll() const;
+
+	/**
+	* @brief Collect the results of every program, blocking on the ones still compiling
+	*
+	* @return bool True if every program linked
+	*/
+	bool finish();
+}; // shader_batch
+
+#endif // _SHADER_BATCH_HPP
@@ -0,0 +1,256 @@
+#include <filesystem>
+#include <sstream>
+#include <cstdio>
+#include <string>
+#include <regex>
+#include <deque>
+
+#include "log.hpp"
+#include "hash.hpp"
+#include "shader_preprocessor.hpp"
+
+constexpr int MAX_INCLUDE_DEPTH = 32;
+constexpr long MAX_SHADER_FILE_SIZE = 1024 * 1024;
+
+shader_preprocessor& shader_preprocessor::get() {
+	static shader_preprocessor preprocessor;
+
+	return preprocessor;
+} // get
+
+preprocessed_shader shader_preprocessor::process(const std::string& path, const std::vector<shader_define>& defines) {
+	preprocessed_shader out;
+	std::string root = normalize(path);
+
+	const parsed_file& file = parse(root);
+	if (!file.ok)
+		return out;
+
+	// Hoist #version so the defines and #line directives come after it
+	for (const parsed_line& line : file.lines) {
+		if (line.kind == line_kind::VERSION) {
+			out.text += line.text;
+			out.text += '\n';
+			break;
+		}
+	}
+
+	for (const shader_define& define : defines) {
+		out.text += "#define " + define.name + " " + define.value + "\n";
+	}
+
+	std::unordered_set<std::string> included;
+	out.ok = emit(root, out, included, 0);
+	out.hash = fnv1a(out.text);
+
+	return out;
+} // process
+
+void shader_preprocessor::invalidate(const std::string& path) {
+	m_files.erase(normalize(path));
+} // invalidate
+
+std::vector<std::string> shader_preprocessor::dependents(const std::string& path) const {
+	std::vector<std::string> result;
+	std::unordered_set<std::string> seen;
+	std::deque<std::string> queue;
+
+	queue.push_back(normalize(path));
+	seen.insert(queue.front());
+
+	while (!queue.empty()) {
+		std::string file = queue.front();
+		queue.pop_front();
+		result.push_back(file);
+
+		auto it = m_includedBy.find(file);
+		if (it == m_includedBy.end())
+			continue;
+
+		for (const std::string& parent : it->second) {
+			if (seen.insert(parent).second) {
+				queue.push_back(parent);
+			}
+		}
+	}
+
+	return result;
+} // dependents
+
+std::string shader_preprocessor::translate_log(const std::string& log, const preprocessed_shader& shader) {
+	// Mesa "0:12(5): error", NVIDIA "0(12) : error", AMD "ERROR: 0:12: ..."
+	static const std::regex location(R"(^((?:ERROR|WARNING): )?(\d+)([:(]))");
+
+	std::istringstream lines(log);
+	std::string line, out;
+	std::smatch match;
+
+	while (std::getline(lines, line)) {
+		if (std::regex_search(line, match, location)) {
+			size_t id = std::stoul(match[2].str());
+
+			if (id < shader.files.size()) {
+				line = match[1].str() + shader.files[id] + match[3].str() + match.suffix().str();
+			}
+		}
+
+		out += line;
+		out += '\n';
+	}
+
+	return out;
+} // translate_log
+
+std::string shader_preprocessor::normalize(const std::string& path) {
+	return std::filesystem::path(path).lexically_normal().generic_string();
+} // normalize
+
+const shader_preprocessor::parsed_file& shader_preprocessor::parse(const std::string& path) {
+	parsed_file& file = m_files[path];
+
+	if (file.ok)
+		return file; // Cached
+
+	std::string data;
+	if (!read_file(path, data))
+		return file;
+
+	std::string directory = std::filesystem::path(path).parent_path().generic_string();
+	file.lines.clear();
+
+	size_t start = 0;
+	while (start <= data.size()) {
+		size_t end = data.find('\n', start);
+		if (end == std::string::npos) {
+			end = data.size();
+		}
+
+		std::string text = data.substr(start, end - start);
+		if (!text.empty() && text.back() == '\r') {
+			text.pop_back();
+		}
+
+		start = end + 1;
+
+		// Directives may have whitespace before and after the '#'
+		size_t pos = text.find_first_not_of(" \t");
+		if (pos == std::string::npos || text[pos] != '#') {
+			file.lines.push_back({ line_kind::TEXT, text });
+			continue;
+		}
+
+		pos = text.find_first_not_of(" \t", pos + 1);
+		std::string directive = pos == std::string::npos ? "" : text.substr(pos);
+
+		if (directive.rfind("include", 0) == 0) {
+			size_t open = directive.find_first_of("\"<");
+			size_t close = open == std::string::npos ? open : directive.find_first_of("\">", open + 1);
+
+			if (close == std::string::npos) {
+				LOG_ERROR(SHADER, "%s(%zu): malformed #include", path.c_str(), file.lines.size() + 1);
+				return file;
+			}
+
+			std::string include = normalize((std::filesystem::path(directory) / directive.substr(open + 1, close - open - 1)).generic_string());
+
+			m_includedBy[include].insert(path);
+			file.lines.push_back({ line_kind::INCLUDE, include });
+		}
+		else if (directive.rfind("version", 0) == 0) {
+			file.lines.push_back({ line_kind::VERSION, text });
+		}
+		else if (directive.rfind("pragma", 0) == 0 && directive.find("once") != std::string::npos) {
+			file.lines.push_back({ line_kind::PRAGMA_ONCE, text });
+		}
+		else {
+			file.lines.push_back({ line_kind::TEXT, text });
+		}
+	}
+
+	file.ok = true;
+
+	return file;
+} // parse
+
+bool shader_preprocessor::emit(const std::string& path, preprocessed_shader& out, std::unordered_set<std::string>& included, int depth) {
+	if (depth > MAX_INCLUDE_DEPTH) {
+		LOG_ERROR(SHADER, "Include depth limit reached at %s", path.c_str());
+		return false;
+	}
+
+	// Implicit include guard, also breaks include cycles
+	if (!included.insert(path).second)
+		return true;
+
+	const parsed_file& file = parse(path);
+	if (!file.ok)
+		return false;
+
+	std::string id = std::to_string(out.files.size());
+	out.files.push_back(path);
+	out.text += "#line 1 " + id + "\n";
+
+	for (size_t i = 0; i < file.lines.size(); ++i) {
+		const parsed_line& line = file.lines[i];
+
+		switch (line.kind) {
+			case line_kind::TEXT:
+				out.text += line.text;
+				out.text += '\n';
+				break;
+			case line_kind::VERSION:     // Hoisted by process()
+			case line_kind::PRAGMA_ONCE: // Every file is included once anyway
+				out.text += '\n';
+				break;
+			case line_kind::INCLUDE:
+				if (!emit(line.text, out, included, depth + 1)) {
+					LOG_ERROR(SHADER, "%s(%zu): failed to include %s", path.c_str(), i + 1, line.text.c_str());
+					return false;
+				}
+
+				// Resume numbering after the include line
+				out.text += "#line " + std::to_string(i + 2) + " " + id + "\n";
+				break;
+		}
+	}
+
+	return true;
+} // emit
+
+bool shader_preprocessor::read_file(const std::string& path, std::string& data) {
+	FILE* input_file = fopen(path.c_str(), "rb");
+	if (!input_file) {
+		LOG_ERROR(SHADER, "Failed to open file %s", path.c_str());
+		return false;
+	}
+
+	fseek(input_file, 0, SEEK_END);
+	long size = ftell(input_file);
+	fseek(input_file, 0, SEEK_SET);
+
+	if (size <= 0) {
+		LOG_ERROR(SHADER, "File %s is empty or unreadable: %ld bytes", path.c_str(), size);
+		fclose(input_file);
+		return false;
+	}
+
+	if (size > MAX_SHADER_FILE_SIZE) {
+		LOG_ERROR(SHADER, "File %s is too large (Larger than 1MB): %ld bytes", path.c_str(), size);
+		fclose(input_file);
+		return false;
+	}
+
+	// Read the whole file in one go
+	data.resize((size_t)size);
+	size_t read = fread(data.data(), 1, data.size(), input_file);
+	fclose(input_file);
+
+	if (read != data.size()) {
+		LOG_ERROR(SHADER, "Failed to read file %s", path.c_str());
+		return false;
+	}
+
+	LOG_TRACE(SHADER, "Read %zu bytes from %s", data.size(), path.c_str());
+
+	return true;
+} // read_file
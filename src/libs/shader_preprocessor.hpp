@@ -0,0 +1,100 @@
+#ifndef _SHADER_PREPROCESSOR_HPP
+#define _SHADER_PREPROCESSOR_HPP
+
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct shader_define {
+	std::string name;
+	std::string value;
+};
+
+struct preprocessed_shader {
+	std::string text;
+	uint64_t hash;                  // Hash of text, usable as a cache key
+	std::vector<std::string> files; // #line source string number -> file path
+	bool ok;
+
+	preprocessed_shader() : hash(0), ok(false) {}
+};
+
+/**
+* @brief Expands #include directives in GLSL sources
+*
+* - #include "file" is resolved relative to the including file
+* - Every file is included at most once per program (implicit include guard), #pragma once is accepted
+* - Defines are injected right after #version
+* - #line directives map every line back to its file so compile logs can be translated
+*
+* Parsed files are cached in memory until invalidated, and the preprocessor keeps
+* a reverse dependency graph so a changed file can be traced to every root shader.
+*/
+class shader_preprocessor {
+public:
+	/**
+	* @brief The preprocessor shared by every shader
+	*/
+	static shader_preprocessor& get();
+
+	shader_preprocessor() {}
+
+	shader_preprocessor(shader_preprocessor&) = delete; // No copy constructor
+	shader_preprocessor& operator=(const shader_preprocessor&) = delete; // No copy assignment
+
+	/**
+	* @brief Preprocess a root shader file
+	*/
+	preprocessed_shader process(const std::string& path, const std::vector<shader_define>& defines = {});
+
+	/**
+	* @brief Drop a file from the cache so the next process() re-reads it
+	*/
+	void invalidate(const std::string& path);
+
+	/**
+	* @brief Every file that includes path (directly or not), including path itself
+	*/
+	std::vector<std::string> dependents(const std::string& path) const;
+
+	/**
+	* @brief Replace source string numbers in a compile log with file names ("0:12(5)" -> "lighting.glsl:12(5)")
+	*/
+	static std::string translate_log(const std::string& log, const preprocessed_shader& shader);
+
+	/**
+	* @brief Normalised form of a path, used as the key of the file cache and dependency graph
+	*/
+	static std::string normalize(const std::string& path);
+
+private:
+	enum class line_kind {
+		TEXT,
+		INCLUDE,
+		VERSION,
+		PRAGMA_ONCE
+	};
+
+	struct parsed_line {
+		line_kind kind;
+		std::string text; // Line text, or the resolved path of an include
+	};
+
+	struct parsed_file {
+		std::vector<parsed_line> lines;
+		bool ok = false;
+	};
+
+	std::unordered_map<std::string, parsed_file> m_files;
+	std::unordered_map<std::string, std::unordered_set<std::string>> m_includedBy;
+
+	const parsed_file& parse(const std::string& path);
+
+	bool emit(const std::string& path, preprocessed_shader& out, std::unordered_set<std::string>& included, int depth);
+
+	static bool read_file(const std::string& path, std::string& data);
+}; // shader_preprocessor
+
+#endif // _SHADER_PREPROCESSOR_HPP
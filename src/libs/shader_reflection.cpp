@@ -0,0 +1,100 @@
+#include "gl.hpp"
+#include <string_view>
+#include <string>
+
+#include "shader_reflection.hpp"
+
+/**
+* @brief Name of a program resource, with "[0]" removed from arrays
+*/
+static std::string resource_name(GLuint program, GLenum interface, GLuint index, GLint length) {
+	std::string name(length, '\0');
+	glGetProgramResourceName(program, interface, index, length, nullptr, name.data());
+	name.resize(length > 0 ? length - 1 : 0); // Length includes the terminator
+
+	if (name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0) {
+		name.resize(name.size() - 3);
+	}
+
+	return name;
+} // resource_name
+
+void shader_reflection::reflect(GLuint program) {
+	uniforms.clear();
+	blocks.clear();
+	attributes.clear();
+
+	GLint count = 0;
+
+	// Uniform blocks first so uniforms can refer to them by index
+	glGetProgramInterfaceiv(program, GL_UNIFORM_BLOCK, GL_ACTIVE_RESOURCES, &count);
+
+	for (GLint i = 0; i < count; ++i) {
+		const GLenum props[] = { GL_NAME_LENGTH, GL_BUFFER_BINDING, GL_BUFFER_DATA_SIZE };
+		GLint values[3] = {};
+		glGetProgramResourceiv(program, GL_UNIFORM_BLOCK, i, 3, props, 3, nullptr, values);
+
+		blocks.push_back({ resource_name(program, GL_UNIFORM_BLOCK, i, values[0]), (GLuint)i, values[1], values[2] });
+	}
+
+	glGetProgramInterfaceiv(program, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+
+	for (GLint i = 0; i < count; ++i) {
+		const GLenum props[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION, GL_ARRAY_SIZE, GL_BLOCK_INDEX, GL_OFFSET };
+		GLint values[6] = {};
+		glGetProgramResourceiv(program, GL_UNIFORM, i, 6, props, 6, nullptr, values);
+
+		reflected_uniform u;
+		u.name = resource_name(program, GL_UNIFORM, i, values[0]);
+		u.type = (GLenum)values[1];
+		u.location = values[2];
+		u.array_size = values[3];
+		u.block = values[4];
+		u.offset = values[4] < 0 ? -1 : values[5];
+
+		uniforms.push_back(u);
+	}
+
+	glGetProgramInterfaceiv(program, GL_PROGRAM_INPUT, GL_ACTIVE_RESOURCES, &count);
+
+	for (GLint i = 0; i < count; ++i) {
+		const GLenum props[] = { GL_NAME_LENGTH, GL_TYPE, GL_LOCATION };
+		GLint values[3] = {};
+		glGetProgramResourceiv(program, GL_PROGRAM_INPUT, i, 3, props, 3, nullptr, values);
+
+		if (values[2] < 0)
+			continue; // Built-ins like gl_VertexID
+
+		attributes.push_back({ resource_name(program, GL_PROGRAM_INPUT, i, values[0]), values[2], (GLenum)values[1] });
+	}
+} // reflect
+
+const reflected_uniform* shader_reflection::find_uniform(std::string_view name) const {
+	for (const reflected_uniform& u : uniforms) {
+		if (u.name == name) {
+			return &u;
+		}
+	}
+
+	return nullptr;
+} // find_uniform
+
+const reflected_block* shader_reflection::find_block(std::string_view name) const {
+	for (const reflected_block& b : blocks) {
+		if (b.name == name) {
+			return &b;
+		}
+	}
+
+	return nullptr;
+} // find_block
+
+const reflected_attribute* shader_reflection::find_attribute(std::string_view name) const {
+	for (const reflected_attribute& a : attributes) {
+		if (a.name == name) {
+			return &a;
+		}
+	}
+
+	return nullptr;
+} // find_attribute
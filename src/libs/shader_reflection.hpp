@@ -0,0 +1,60 @@
+#ifndef _SHADER_REFLECTION_HPP
+#define _SHADER_REFLECTION_HPP
+
+#include "gl.hpp"
+#include <string_view>
+#include <string>
+#include <vector>
+
+struct reflected_uniform {
+	std::string name;  // Arrays are stored without the trailing [0]
+	GLint location;    // -1 for members of uniform blocks
+	GLenum type;
+	GLint array_size;
+	GLint block;       // Index into shader_reflection::blocks, -1 for default block uniforms
+	GLint offset;      // Byte offset inside the block, -1 for default block uniforms
+};
+
+struct reflected_block {
+	std::string name;
+	GLuint index;
+	GLint binding;
+	GLint size;
+};
+
+struct reflected_attribute {
+	std::string name;
+	GLint location;
+	GLenum type;
+};
+
+/**
+* @brief Everything a linked program exposes, introspected once after linking
+*/
+struct shader_reflection {
+	std::vector<reflected_uniform> uniforms;
+	std::vector<reflected_block> blocks;
+	std::vector<reflected_attribute> attributes;
+
+	/**
+	* @brief Rebuild the tables from a linked program (glGetProgramInterfaceiv / glGetProgramResource*)
+	*/
+	void reflect(GLuint program);
+
+	/**
+	* @return The uniform, nullptr if the program has no active uniform with that name
+	*/
+	const reflected_uniform* find_uniform(std::string_view name) const;
+
+	/**
+	* @return The block, nullptr if the program has no active block with that name
+	*/
+	const reflected_block* find_block(std::string_view name) const;
+
+	/**
+	* @return The attribute, nullptr if the program has no active input with that name
+	*/
+	const reflected_attribute* find_attribute(std::string_view name) const;
+}; // shader_reflection
+
+#endif // _SHADER_REFLECTION_HPP
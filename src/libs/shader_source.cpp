@@ -1,64 +1,54 @@
-#include <GLEW/glew.h>
-#include <iterator>
-#include <fstream>
+#include "gl.hpp"
 #include <string>
 #include <cstdio>
 
-#include "scolor.hpp"
+#include "log.hpp"
+#include "memory_tracker.hpp"
 #include "shader_source.hpp"
 
 bool shader_source::load() {
-	std::ifstream input_file(this->m_source, std::ios::binary);
-	if (!input_file.is_open()) {
-		fprintf(stderr, RED("Failed to open file %s\n").c_str(), this->m_source);
-		return false;
-	}
-
-	// Read file into std::string
-	std::string s_data((std::istreambuf_iterator<char>(input_file)), std::istreambuf_iterator<char>());
-	input_file.close();
-
-	if (s_data.empty()) {
-		fprintf(stderr, RED("File %s is empty or unreadable: %lld bytes\n").c_str(), this->m_source, s_data.size());
-		return false;
-	}
+	memory_scope scope(memory_tag::STRINGS);
 
-	if (s_data.size() > (1024 * 1024)) {
-		fprintf(stderr, RED("File %s is too large (Larger than 1MB): %lld bytes\n").c_str(), this->m_source, s_data.size());
-		return false;
-	}
+	this->m_preprocessed = shader_preprocessor::get().process(this->m_source, this->m_defines);
 
-	printf(YELLOW("Read %zu bytes from %s\n").c_str(), s_data.size(), this->m_source);
-
-	// Pass to OpenGL
-	const char* buffer = s_data.c_str();
-	glShaderSource(this->m_handle, 1, &buffer, NULL);
-
-	return true;
+	return this->m_preprocessed.ok;
 } // load
 
-void shader_source::compile(GLuint shader_handle) {
+void shader_source::submit(GLuint shader_handle) {
 	if (!this->m_source)
 		return;
 
-	this->m_handle = glCreateShader(this->m_type);
-
-	if (!load()) {
-		fprintf(stderr, RED("Failed to read shader source from %s\n").c_str(), this->m_source);
+	if (!this->m_isLoaded) {
+		LOG_ERROR(SHADER, "Failed to read shader source from %s", this->m_source);
 		return;
 	}
 
-	// Compile
+	this->m_handle = glCreateShader(this->m_type);
+
+	// Pass to OpenGL
+	const char* buffer = this->m_preprocessed.text.c_str();
+	glShaderSource(this->m_handle, 1, &buffer, NULL);
+
+	// Compile, querying anything here would force the driver to finish synchronously
 	glCompileShader(this->m_handle);
-	glGetShaderInfoLog(this->m_handle, BUFFER_SIZE, NULL, this->m_error);
+	glAttachShader(shader_handle, this->m_handle);
+} // submit
+
+bool shader_source::finish() {
+	if (!this->m_handle) // Never submitted, 0 is never a shader name
+		return false;
+
 	glGetShaderiv(this->m_handle, GL_COMPILE_STATUS, &this->m_isCompiled);
 
 	if (!this->m_isCompiled) {
-		fprintf(stderr, RED("Compile Failed: %s\n").c_str(), this->m_error);
-		return;
+		glGetShaderInfoLog(this->m_handle, BUFFER_SIZE, NULL, this->m_error);
+
+		std::string log = shader_preprocessor::translate_log(this->m_error, this->m_preprocessed);
+		LOG_ERROR(SHADER, "Compile Failed (%s):\n%s", this->m_source, log.c_str());
+		return false;
 	}
 
-	fprintf(stdout, GREEN("Compile Success\n").c_str());
+	LOG_INFO(SHADER, "Compile Success (%s)", this->m_source);
 
-	glAttachShader(shader_handle, this->m_handle);
-}
\ No newline at end of file
+	return true;
+} // finish
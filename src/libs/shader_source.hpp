@@ -1,8 +1,12 @@
 #ifndef _SHADER_SOURCE_HPP
 #define _SHADER_SOURCE_HPP
 
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <cstring>
+#include <string>
+#include <vector>
+
+#include "shader_preprocessor.hpp"
 
 constexpr auto BUFFER_SIZE = 1024;
 
@@ -11,27 +15,29 @@ public:
 	GLuint m_handle;
 	GLuint m_type;
 	const char* m_source;
+	std::vector<shader_define> m_defines;
+	preprocessed_shader m_preprocessed;
 	char m_error[BUFFER_SIZE];
 
 	GLint m_isCompiled;
+	bool m_isLoaded;
 
 	//TODO: Add the shader vertex attributes here rather than in the material
-	//TODO: change this to some kind of compiler to read #include statements in the shader (i.e. https://github.com/HorseTrain/antworld/blob/main/antworld/assets/shaders/stl/shared_shader_data.h)
 
 	// Allow shader access to private class
 	friend class shader;
 
 	/**
-	* @brief Construct and compile the provided shader
+	* @brief Read and preprocess the provided shader, compiling is deferred until the program is not found in the program cache
 	*/
-	shader_source(GLuint shader_handle, GLuint type, const char* source) : m_handle(-1), m_type(type), m_source(source), m_isCompiled(GL_FALSE) {
+	shader_source(GLuint type, const char* source, const std::vector<shader_define>& defines = {}) : m_handle(0), m_type(type), m_source(source), m_defines(defines), m_isCompiled(GL_FALSE), m_isLoaded(false) {
 		memset(m_error, 0, BUFFER_SIZE);
 
-		this->compile(shader_handle);
+		this->m_isLoaded = this->load();
 	}
 
 	~shader_source() {
-		if (this->m_handle != -1) { glDeleteShader(this->m_handle); }
+		if (this->m_handle) { glDeleteShader(this->m_handle); }
 	}
 
 	shader_source(shader_source&) = delete; // No copy constructor
@@ -39,18 +45,23 @@ public:
 
 private:
 	/**
-	* @brief Load shader source from filepath
+	* @brief Load shader source from filepath, expanding includes and injecting the defines
 	*
 	* @returns bool Returns true if loading was successful, false on failure
 	*/
 	bool load();
 
 	/**
-	* @brief Create a shader source
+	* @brief Start compiling the loaded source and attach it to the program (does not wait for the driver)
+	*/
+	void submit(GLuint shader_handle);
+
+	/**
+	* @brief Fetch the compile status and log, blocking until the driver is done
 	*
-	* @return The shader source, nullptr on fail
+	* @returns bool Returns true if the source compiled
 	*/
-	void compile(GLuint shader_handle);
+	bool finish();
 }; // shader_source
 
-#endif // _SHADER_SOURCE_HPP
\ No newline at end of file
+#endif // _SHADER_SOURCE_HPP
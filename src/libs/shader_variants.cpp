@@ -0,0 +1,172 @@
+#include "gl.hpp"
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+
+#include "log.hpp"
+#include "shader_variants.hpp"
+
+constexpr uint32_t MAX_SHADER_KEYWORDS = 32;
+
+void shader_variants::add(GLuint type, const char* filepath, const std::vector<shader_define>& defines) {
+	this->m_stages.push_back({ type, filepath, defines });
+} // add
+
+uint32_t shader_variants::keyword(const char* name) {
+	for (size_t i = 0; i < this->m_keywords.size(); ++i) {
+		if (this->m_keywords[i] == name) {
+			return 1u << i;
+		}
+	}
+
+	if (this->m_keywords.size() == MAX_SHADER_KEYWORDS) {
+		throw std::runtime_error("Too many shader keywords in " + this->m_name);
+	}
+
+	this->m_keywords.push_back(name);
+
+	return 1u << (this->m_keywords.size() - 1);
+} // keyword
+
+shader* shader_variants::create(uint32_t mask) {
+	this->m_used.insert(mask);
+
+	uint32_t resolved = resolve(mask);
+
+	auto it = this->m_variants.find(resolved);
+	if (it != this->m_variants.end())
+		return it->second;
+
+	// Defines in keyword order so the same variant always hashes the same for the program cache
+	std::vector<shader_define> defines;
+	for (size_t i = 0; i < this->m_keywords.size(); ++i) {
+		if (resolved & (1u << i)) {
+			defines.push_back({ this->m_keywords[i], "1" });
+		}
+	}
+
+	LOG_DEBUG(SHADER, "Creating %s variant [%s]", this->m_name.c_str(), describe(resolved).c_str());
+
+	shader* variant = new shader();
+	for (const stage& s : this->m_stages) {
+		std::vector<shader_define> stage_defines = s.defines;
+		stage_defines.insert(stage_defines.end(), defines.begin(), defines.end());
+
+		variant->add(s.type, s.path.c_str(), stage_defines);
+	}
+
+	this->m_variants.emplace(resolved, variant);
+
+	return variant;
+} // create
+
+shader* shader_variants::get(uint32_t mask) {
+	shader* variant = create(mask);
+
+	if (!variant->m_isLinked && !variant->m_isPending) {
+		variant->link();
+	}
+
+	return variant;
+} // get
+
+void shader_variants::prewarm(shader_batch& batch) {
+	for (uint32_t mask : this->m_kept) {
+		shader* variant = create(mask);
+
+		if (!variant->m_isLinked && !variant->m_isPending) {
+			batch.add(variant);
+		}
+	}
+
+	// Prewarming is not usage
+	this->m_used.clear();
+} // prewarm
+
+bool shader_variants::load_manifest(const char* path) {
+	std::ifstream file(path);
+	if (!file.is_open())
+		return false;
+
+	std::string line;
+	while (std::getline(file, line)) {
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		uint32_t mask = 0;
+		std::istringstream names(line);
+		std::string name;
+
+		while (names >> name) {
+			if (name != "-") {
+				mask |= keyword(name.c_str());
+			}
+		}
+
+		this->m_kept.insert(mask);
+	}
+
+	this->m_isStripped = true;
+
+	LOG_DEBUG(SHADER, "Loaded %zu %s variant(s) from %s", this->m_kept.size(), this->m_name.c_str(), path);
+
+	return true;
+} // load_manifest
+
+bool shader_variants::save_manifest(const char* path) const {
+	std::ofstream file(path, std::ios::trunc);
+	if (!file.is_open()) {
+		LOG_ERROR(SHADER, "Failed to write variant manifest %s", path);
+		return false;
+	}
+
+	// Sorted so the manifest diffs cleanly between runs
+	std::vector<uint32_t> masks(this->m_used.begin(), this->m_used.end());
+	std::sort(masks.begin(), masks.end());
+
+	file << "# " << this->m_name << " shader variants in use, one per line (- is no keywords)\n";
+	for (uint32_t mask : masks) {
+		file << describe(mask) << "\n";
+	}
+
+	return true;
+} // save_manifest
+
+uint32_t shader_variants::resolve(uint32_t mask) const {
+	if (!this->m_isStripped || this->m_kept.count(mask))
+		return mask;
+
+	// Stripped: drop keywords, highest bit first, until a kept variant is found
+	for (uint32_t candidate = mask; candidate != 0;) {
+		uint32_t highest = 1u << (31 - std::countl_zero(candidate));
+		candidate &= ~highest;
+
+		if (this->m_kept.count(candidate)) {
+			LOG_WARNING(SHADER, "%s variant [%s] was stripped, using [%s]", this->m_name.c_str(), describe(mask).c_str(), describe(candidate).c_str());
+			return candidate;
+		}
+	}
+
+	LOG_WARNING(SHADER, "%s variant [%s] was stripped, compiling it anyway", this->m_name.c_str(), describe(mask).c_str());
+
+	return mask;
+} // resolve
+
+std::string shader_variants::describe(uint32_t mask) const {
+	std::string names;
+
+	for (size_t i = 0; i < this->m_keywords.size(); ++i) {
+		if (mask & (1u << i)) {
+			if (!names.empty()) {
+				names += ' ';
+			}
+
+			names += this->m_keywords[i];
+		}
+	}
+
+	return names.empty() ? "-" : names;
+} // describe
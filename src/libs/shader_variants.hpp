@@ -0,0 +1,99 @@
+#ifndef _SHADER_VARIANTS_HPP
+#define _SHADER_VARIANTS_HPP
+
+#include "gl.hpp"
+#include <unordered_map>
+#include <unordered_set>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "shader.hpp"
+#include "shader_batch.hpp"
+
+/**
+* @brief Compiles permutations of one set of shader sources on demand
+*
+* Every declared keyword is a bit; a variant is the program compiled with
+* #define KEYWORD 1 for each set bit, looked up by its mask.
+*
+* Usage is recorded so a manifest of the variants a build actually needs can be
+* written offline (save_manifest, Engine --record-variants); loading that manifest strips every other
+* variant and lets all kept variants be compiled up front (prewarm).
+*/
+class shader_variants {
+public:
+	std::string m_name;
+
+	shader_variants(const char* name) : m_name(name), m_isStripped(false) {}
+
+	~shader_variants() {
+		for (auto& [mask, s] : m_variants) {
+			delete s;
+		}
+	}
+
+	shader_variants(shader_variants&) = delete; // No copy constructor
+	shader_variants& operator=(const shader_variants&) = delete; // No copy assignment
+
+	/**
+	* @brief Add a shader stage shared by every variant
+	*
+	* @param defines Defines of this stage only (e.g. the vertex layout), keyword defines are added per variant
+	*/
+	void add(GLuint type, const char* filepath, const std::vector<shader_define>& defines = {});
+
+	/**
+	* @brief Declare a keyword
+	*
+	* @return uint32_t The bit of the keyword, combine with | to build a variant mask
+	*/
+	uint32_t keyword(const char* name);
+
+	/**
+	* @brief Get the variant for mask without linking it (e.g. to add it to a shader_batch)
+	*/
+	shader* create(uint32_t mask);
+
+	/**
+	* @brief Get the variant for mask, compiling and linking it if needed
+	*/
+	shader* get(uint32_t mask);
+
+	/**
+	* @brief Add every variant kept by the manifest to a batch so they compile in parallel
+	*/
+	void prewarm(shader_batch& batch);
+
+	/**
+	* @brief Keep only the variants listed in the manifest, others resolve to the closest kept variant
+	*
+	* @return bool True if the manifest was read
+	*/
+	bool load_manifest(const char* path);
+
+	/**
+	* @brief Write every variant requested so far, the input of load_manifest in shipping builds
+	*/
+	bool save_manifest(const char* path) const;
+
+private:
+	struct stage {
+		GLuint type;
+		std::string path;
+		std::vector<shader_define> defines;
+	};
+
+	std::vector<stage> m_stages;
+	std::vector<std::string> m_keywords;
+
+	std::unordered_map<uint32_t, shader*> m_variants;
+	std::unordered_set<uint32_t> m_used;
+	std::unordered_set<uint32_t> m_kept;
+	bool m_isStripped;
+
+	uint32_t resolve(uint32_t mask) const;
+	std::string describe(uint32_t mask) const;
+}; // shader_variants
+
+#endif // _SHADER_VARIANTS_HPP
@@ -0,0 +1,314 @@
+#include <glm/glm.hpp>
+#include "gl.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "log.hpp"
+#include "profiler.hpp"
+#include "material.hpp"
+#include "render_stats.hpp"
+#include "stream_buffer.hpp"
+#include "sprite_batch.hpp"
+
+/**
+* @brief Vertex as sprite_batch::layout stores it
+*/
+struct sprite_vertex {
+	float x, y, z;
+	uint32_t texcoord; // UNORM16x2
+	uint32_t color;    // UNORM8x4
+};
+
+static_assert(sizeof(sprite_vertex) == sprite_batch::layout::stride, "sprite_vertex must match sprite_batch::layout");
+
+struct batch_state {
+	material* mat = nullptr;
+	uniform_handle u_projection = 0;
+
+	stream_buffer* vertices = nullptr;
+	uint32_t bound_generation = 0; // Stream buffer the VAO points at, 0 for none
+	GLuint vao = 0;
+	GLuint ibo = 0;
+	texture white;           // 1x1, for untextured sprites
+
+	size_t max_sprites = 0;
+	std::vector<sprite> sprites;
+	std::vector<uint64_t> keys; // Sort key << 32 | sprite index
+	std::vector<uint64_t> scratch;
+
+	size_t last_sprites = 0;
+	size_t last_draws = 0;
+	bool warned = false; // More than max_sprites submitted in a frame, logged once per run
+};
+
+static batch_state& state() {
+	static batch_state instance;
+	return instance;
+}
+
+/**
+* @brief Layer, then texture in the high bits, equal keys draw together
+*/
+static uint32_t sort_key(const sprite& s, GLuint white) {
+	GLuint handle = s.tex ? s.tex->m_handle : white;
+
+	// A handle collision only splits a run, the draw loop compares the textures themselves
+	return (uint32_t)((uint16_t)s.layer ^ 0x8000) << 16 | (handle & 0xFFFF);
+}
+
+/**
+* @brief Stable LSD radix sort on the upper 32 bits, 8 bits a pass, passes where every key has the same digit are skipped
+*/
+static void radix_sort(std::vector<uint64_t>& keys, std::vector<uint64_t>& scratch) {
+	size_t count = keys.size();
+	scratch.resize(count);
+
+	uint64_t* src = keys.data();
+	uint64_t* dst = scratch.data();
+
+	for (int shift = 32; shift < 64; shift += 8) {
+		size_t offsets[256] = {};
+
+		for (size_t i = 0; i < count; ++i) {
+			++offsets[(src[i] >> shift) & 0xFF];
+		}
+
+		if (offsets[(src[0] >> shift) & 0xFF] == count)
+			continue;
+
+		size_t sum = 0;
+		for (size_t& offset : offsets) {
+			size_t digits = offset;
+			offset = sum;
+			sum += digits;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			dst[offsets[(src[i] >> shift) & 0xFF]++] = src[i];
+		}
+
+		std::swap(src, dst);
+	}
+
+	if (src != keys.data()) {
+		keys.swap(scratch);
+	}
+} // radix_sort
+
+// Scalar on purpose: glm::packUnorm* round with a library call and the vector glm::clamp goes through a function pointer
+static uint32_t unorm(float value, float scale) {
+	return (uint32_t)(std::min(std::max(value, 0.0f), 1.0f) * scale + 0.5f);
+}
+
+static uint32_t unorm8x4(const glm::vec4& value) {
+	return unorm(value.x, 255.0f) | unorm(value.y, 255.0f) << 8 | unorm(value.z, 255.0f) << 16 | unorm(value.w, 255.0f) << 24;
+}
+
+static void write_quad(const sprite& s, sprite_vertex* v) {
+	glm::vec2 half = s.size * 0.5f;
+
+	float x0 = s.position.x - half.x, x1 = s.position.x + half.x;
+	float y0 = s.position.y - half.y, y1 = s.position.y + half.y;
+
+	uint32_t u0 = unorm(s.uv.x, 65535.0f), u1 = unorm(s.uv.z, 65535.0f);
+	uint32_t v0 = unorm(s.uv.y, 65535.0f) << 16, v1 = unorm(s.uv.w, 65535.0f) << 16;
+
+	uint32_t color = unorm8x4(s.color);
+
+	v[0] = { x0, y0, 0.0f, u0 | v0, color };
+	v[1] = { x1, y0, 0.0f, u1 | v0, color };
+	v[2] = { x1, y1, 0.0f, u1 | v1, color };
+	v[3] = { x0, y1, 0.0f, u0 | v1, color };
+}
+
+void sprite_batch::init(shader* sprite_shader, size_t max_sprites) {
+	batch_state& s = state();
+
+	shutdown();
+
+	s.max_sprites = max_sprites;
+	s.sprites.reserve(max_sprites);
+	s.keys.reserve(max_sprites);
+	s.scratch.reserve(max_sprites);
+
+	// White texel, untextured sprites sample it so one program draws both
+	const uint32_t white = 0xFFFFFFFF;
+
+	glGenTextures(1, &s.white.m_handle);
+	glBindTexture(GL_TEXTURE_2D, s.white.m_handle);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, &white);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	s.white.m_width = 1;
+	s.white.m_height = 1;
+
+	s.mat = new material(sprite_shader, &s.white);
+	s.u_projection = s.mat->uniform("projection");
+
+	// Two triangles per quad, the same for every batch
+	std::vector<uint32_t> indices(max_sprites * 6);
+
+	for (uint32_t quad = 0; quad < (uint32_t)max_sprites; ++quad) {
+		const uint32_t corners[] = { 0, 1, 2, 0, 2, 3 };
+
+		for (uint32_t i = 0; i < 6; ++i) {
+			indices[quad * 6 + i] = quad * 4 + corners[i];
+		}
+	}
+
+	glGenVertexArrays(1, &s.vao);
+	glBindVertexArray(s.vao);
+
+	glGenBuffers(1, &s.ibo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s.ibo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(uint32_t), indices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+
+	s.vertices = new stream_buffer(GL_ARRAY_BUFFER, SPRITE_STREAM_BYTES);
+} // init
+
+void sprite_batch::shutdown() {
+	batch_state& s = state();
+
+	delete s.vertices;
+	delete s.mat;
+
+	if (s.vao) {
+		glDeleteVertexArrays(1, &s.vao);
+		glDeleteBuffers(1, &s.ibo);
+		glDeleteTextures(1, &s.white.m_handle);
+	}
+
+	s.vertices = nullptr;
+	s.mat = nullptr;
+	s.bound_generation = 0;
+	s.vao = 0;
+	s.ibo = 0;
+	s.white = texture();
+
+	s.sprites.clear();
+} // shutdown
+
+void sprite_batch::submit(const sprite& sp) {
+	batch_state& s = state();
+
+	if (s.sprites.size() == s.max_sprites && !s.warned) {
+		LOG_WARNING(RENDER, "More than %zu sprites in a frame, the batch grows on the heap", s.max_sprites);
+		s.warned = true;
+	}
+
+	s.sprites.push_back(sp);
+}
+
+void sprite_batch::flush(const glm::mat4& projection) {
+	batch_state& s = state();
+
+	s.last_sprites = s.sprites.size();
+	s.last_draws = 0;
+
+	if (s.sprites.empty())
+		return;
+
+	if (!s.vertices) {
+		s.sprites.clear(); // Nothing to draw them with, they must not pile up frame after frame
+		return;
+	}
+
+	PROFILE_SCOPE("Sprites");
+
+	{
+		PROFILE_SCOPE("Sprite sort");
+
+		s.keys.resize(s.sprites.size());
+
+		for (size_t i = 0; i < s.sprites.size(); ++i) {
+			s.keys[i] = (uint64_t)sort_key(s.sprites[i], s.white.m_handle) << 32 | (uint32_t)i;
+		}
+
+		radix_sort(s.keys, s.scratch);
+	}
+
+	glDisable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	s.mat->set_uniform(s.u_projection, projection);
+	s.mat->use();
+
+	glActiveTexture(GL_TEXTURE0);
+
+	// More sprites than the index buffer covers draw in several chunks
+	for (size_t first = 0; first < s.keys.size(); first += s.max_sprites) {
+		size_t count = std::min(s.max_sprites, s.keys.size() - first);
+
+		stream_range range;
+		sprite_vertex* v = static_cast<sprite_vertex*>(s.vertices->reserve(count * 4 * sizeof(sprite_vertex), range, layout::stride));
+
+		// Out of stream space: skip the rest, the state is restored and the sprites dropped below
+		if (!v)
+			break;
+
+		{
+			PROFILE_SCOPE("Sprite vertices");
+
+			for (size_t i = 0; i < count; ++i, v += 4) {
+				write_quad(s.sprites[(uint32_t)s.keys[first + i]], v);
+			}
+		}
+
+		s.vertices->commit(range);
+
+		glBindVertexArray(s.vao);
+		render_stats::vao_binds += 1;
+
+		if (s.bound_generation != s.vertices->generation()) {
+			s.bound_generation = s.vertices->generation();
+
+			glBindBuffer(GL_ARRAY_BUFFER, s.vertices->handle());
+			layout::setup();
+		}
+
+		GLint base_vertex = (GLint)(range.offset / layout::stride);
+
+		// One draw per run of a texture
+		size_t run = 0;
+		texture* tex = s.sprites[(uint32_t)s.keys[first]].tex;
+
+		for (size_t i = 1; i <= count; ++i) {
+			texture* next = i < count ? s.sprites[(uint32_t)s.keys[first + i]].tex : nullptr;
+
+			if (i < count && next == tex)
+				continue;
+
+			glBindTexture(GL_TEXTURE_2D, tex ? tex->m_handle : s.white.m_handle);
+			glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)((i - run) * 6), GL_UNSIGNED_INT, (void*)(uintptr_t)(run * 6 * sizeof(uint32_t)), base_vertex);
+
+			render_stats::texture_binds += 1;
+			render_stats::draw_calls += 1;
+			render_stats::draw_ranges += 1;
+			s.last_draws += 1;
+
+			run = i;
+			tex = next;
+		}
+	}
+
+	// Every path past the state changes ends here
+	glBindVertexArray(0);
+
+	glDisable(GL_BLEND);
+	glEnable(GL_DEPTH_TEST);
+
+	s.sprites.clear();
+} // flush
+
+size_t sprite_batch::sprites() {
+	return state().last_sprites;
+}
+
+size_t sprite_batch::draws() {
+	return state().last_draws;
+}
@@ -0,0 +1,70 @@
+#ifndef _SPRITE_BATCH_HPP
+#define _SPRITE_BATCH_HPP
+
+#include <glm/glm.hpp>
+#include "gl.hpp"
+#include <cstdint>
+#include <cstddef>
+
+#include "shader.hpp"
+#include "texture.hpp"
+#include "vertex_layout.hpp"
+
+constexpr size_t SPRITE_BATCH_MAX = 131072;              // Sprites one draw can reach (size of the quad index buffer)
+constexpr size_t SPRITE_STREAM_BYTES = 4 * 1024 * 1024;  // Per frame vertex data (grows when a frame needs more)
+
+/**
+* @brief A textured, coloured quad
+*/
+struct sprite {
+	glm::vec2 position = glm::vec2(0.0f); // Centre, in the space flush() projects from
+	glm::vec2 size = glm::vec2(1.0f);
+	glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f); // Min xy, max xy in [0, 1]
+	glm::vec4 color = glm::vec4(1.0f);
+	texture* tex = nullptr; // nullptr is untextured
+	int16_t layer = 0;      // Lower layers are drawn first
+};
+
+/**
+* @brief Immediate mode 2D renderer, every sprite submitted in a frame is drawn by flush()
+*
+* flush() sorts the sprites by layer, then texture (a radix sort, stable, so sprites
+* sharing both keep their submission order), writes their vertices straight into a
+* persistently mapped stream_buffer and draws every run of one texture with a single
+* glDrawElementsBaseVertex over a shared quad index buffer. A frame's draw count is
+* the number of texture changes in layer order, not the number of sprites.
+*
+* Sprites of one layer are reordered by texture, put sprites that must overlap in a
+* given order on different layers. Drawn without depth test, alpha blended. Main thread only.
+*/
+struct sprite_batch {
+	// 20 bytes per vertex, 4 per sprite
+	using layout = vertex_layout<
+		attribute<vertex_attr::VERTEX, attr_format::FLOAT3>,
+		attribute<vertex_attr::TEXCOORD, attr_format::UNORM16x2>,
+		attribute<vertex_attr::COLOR, attr_format::UNORM8x4>
+	>;
+
+	/**
+	* @brief Create the buffers, the white texture and the material
+	*
+	* @param sprite_shader Program built with layout::defines() (src/shaders/sprite_*.glsl)
+	*/
+	static void init(shader* sprite_shader, size_t max_sprites = SPRITE_BATCH_MAX);
+
+	static void shutdown();
+
+	static void submit(const sprite& s);
+
+	/**
+	* @brief Draw and clear the sprites submitted since the last flush
+	*
+	* @param projection From sprite space to clip space, identity draws in normalized device coordinates
+	*/
+	static void flush(const glm::mat4& projection = glm::mat4(1.0f));
+
+	static size_t sprites(); // Drawn by the last flush
+	static size_t draws();   // Draw calls of the last flush
+}; // sprite_batch
+
+#endif // _SPRITE_BATCH_HPP
@@ -0,0 +1,217 @@
+#include "gl.hpp"
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+
+#include "log.hpp"
+#include "profiler.hpp"
+#include "gl_trace.hpp"
+#include "frame_manager.hpp"
+#include "stream_buffer.hpp"
+
+constexpr GLbitfield STREAM_MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+constexpr GLbitfield STREAM_STORAGE_FLAGS = STREAM_MAP_FLAGS | GL_DYNAMIC_STORAGE_BIT; // glBufferSubData while tracing
+constexpr GLuint64 STREAM_FENCE_TIMEOUT_NS = 100000000;
+
+static GLint offset_alignment(GLenum target) {
+	GLint alignment = 16;
+
+	if (target == GL_UNIFORM_BUFFER) {
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	}
+	else if (target == GL_SHADER_STORAGE_BUFFER) {
+		glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	}
+
+	return std::max(alignment, 16);
+}
+
+static size_t align_up(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+stream_buffer::stream_buffer(GLenum target, size_t bytes_per_frame)
+	: m_target(target), m_alignment(offset_alignment(target)), m_handle(0), m_generation(0), m_mapped(nullptr), m_region_bytes(0),
+	  m_region(0), m_offset(0), m_frame(UINT64_MAX), m_fences() {
+	create(bytes_per_frame);
+}
+
+stream_buffer::~stream_buffer() {
+	destroy();
+}
+
+void stream_buffer::create(size_t bytes_per_frame) {
+	m_region_bytes = align_up(bytes_per_frame, (size_t)m_alignment);
+
+	GLsizeiptr size = (GLsizeiptr)(m_region_bytes * FRAMES_IN_FLIGHT);
+
+	glGenBuffers(1, &m_handle);
+	glBindBuffer(m_target, m_handle);
+	glBufferStorage(m_target, size, nullptr, STREAM_STORAGE_FLAGS);
+
+	m_mapped = static_cast<unsigned char*>(glMapBufferRange(m_target, 0, size, STREAM_MAP_FLAGS));
+
+	if (!m_mapped) {
+		LOG_ERROR(RENDER, "Failed to map a %zu byte stream buffer", (size_t)size);
+	}
+
+	m_region = 0;
+	m_offset = 0;
+	m_generation += 1;
+}
+
+void stream_buffer::destroy() {
+	for (GLsync& fence : m_fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	if (m_handle) {
+		// Unmapped by the delete, draws still using the buffer keep it alive in the driver
+		glDeleteBuffers(1, &m_handle);
+		m_handle = 0;
+	}
+
+	for (retired_buffer& retired : m_retired) {
+		glDeleteBuffers(1, &retired.handle);
+
+		if (retired.fence) {
+			glDeleteSync(retired.fence);
+		}
+	}
+
+	m_retired.clear();
+	m_mapped = nullptr;
+}
+
+void stream_buffer::grow(size_t bytes_per_frame) {
+	// Deleting would also unbind it, taking ranges bound earlier in the frame with it
+	m_retired.push_back({ m_handle, nullptr });
+	m_handle = 0;
+
+	// The new buffer starts unused, the old regions' fences mean nothing for it
+	for (GLsync& fence : m_fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+
+	create(bytes_per_frame);
+}
+
+void stream_buffer::release_retired() {
+	for (size_t i = 0; i < m_retired.size();) {
+		retired_buffer& retired = m_retired[i];
+
+		if (!retired.fence) {
+			retired.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			++i;
+			continue;
+		}
+
+		GLenum status = glClientWaitSync(retired.fence, 0, 0);
+
+		if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+			++i;
+			continue;
+		}
+
+		glDeleteSync(retired.fence);
+		glDeleteBuffers(1, &retired.handle);
+
+		m_retired[i] = m_retired.back();
+		m_retired.pop_back();
+	}
+}
+
+void stream_buffer::next_region() {
+	GLsync& done = m_fences[m_region];
+
+	if (done) {
+		glDeleteSync(done);
+	}
+
+	done = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	if (!m_retired.empty()) {
+		release_retired();
+	}
+
+	m_region = (m_region + 1) % FRAMES_IN_FLIGHT;
+	m_offset = m_region * m_region_bytes;
+
+	GLsync& pending = m_fences[m_region];
+	if (!pending)
+		return;
+
+	GLenum status = glClientWaitSync(pending, 0, 0);
+
+	if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+		PROFILE_SCOPE("Stream buffer wait");
+
+		do {
+			status = glClientWaitSync(pending, GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_FENCE_TIMEOUT_NS);
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+
+	glDeleteSync(pending);
+	pending = nullptr;
+}
+
+void* stream_buffer::reserve(size_t size, stream_range& range, size_t alignment) {
+	if (m_frame != frame_manager::frame()) {
+		m_frame = frame_manager::frame();
+		next_region();
+	}
+
+	if (alignment == 0) {
+		alignment = (size_t)m_alignment;
+	}
+
+	size_t offset = align_up(m_offset, alignment);
+
+	if (offset + size > (m_region + 1) * m_region_bytes) {
+		size_t grown = std::max(m_region_bytes * 2, size + alignment);
+		LOG_WARNING(RENDER, "Stream buffer region full, growing it to %zu bytes", align_up(grown, (size_t)m_alignment));
+
+		grow(grown);
+
+		offset = 0;
+	}
+
+	m_offset = offset + size;
+	range = { (GLintptr)offset, (GLsizeiptr)size };
+
+	if (gl_trace::active()) {
+		m_staging.resize(size);
+		return m_staging.data();
+	}
+
+	return m_mapped ? m_mapped + offset : nullptr;
+} // reserve
+
+void stream_buffer::commit(const stream_range& range) {
+	if (gl_trace::active()) {
+		glBindBuffer(m_target, m_handle);
+		glBufferSubData(m_target, range.offset, range.size, m_staging.data());
+	}
+}
+
+stream_range stream_buffer::write(const void* data, size_t size) {
+	stream_range range;
+	void* dst = reserve(size, range);
+
+	if (dst) {
+		memcpy(dst, data, size);
+		commit(range);
+	}
+
+	return range;
+}
+
+void stream_buffer::bind(GLuint index, const stream_range& range) const {
+	glBindBufferRange(m_target, index, m_handle, range.offset, range.size);
+}
@@ -0,0 +1,127 @@
+#ifndef _STREAM_BUFFER_HPP
+#define _STREAM_BUFFER_HPP
+
+#include "gl.hpp"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include "frame_arena.hpp"
+
+/**
+* @brief A range written into a stream_buffer, valid until the end of the frame
+*/
+struct stream_range {
+	GLintptr offset;
+	GLsizeiptr size;
+};
+
+/**
+* @brief Ring of persistently mapped buffer memory for per draw data (uniform blocks, instances)
+*
+* The buffer is mapped once with GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT and split
+* into one region per frame in flight. Writing is a memcpy into the current frame's
+* region, binding is glBindBufferRange, no GL upload call is made. A region is fenced
+* when the ring moves past it and waited on before it is written again, so the CPU
+* never overwrites data the GPU may still read (with frame_manager the wait is free,
+* it already waited for the frame).
+*
+* A frame that writes more than a region holds grows the buffer. The old one is not
+* deleted before a fence shows the GPU is done with it, so ranges already bound from
+* it (frame_data, ...) stay valid for the rest of the frame. While gl_trace runs, writes
+* go through glBufferSubData so the trace holds the data. Main thread only.
+*/
+class stream_buffer {
+public:
+	/**
+	* @param target GL_UNIFORM_BUFFER, GL_SHADER_STORAGE_BUFFER or a vertex data target, picks the offset alignment
+	* @param bytes_per_frame Size of one region
+	*/
+	stream_buffer(GLenum target, size_t bytes_per_frame);
+
+	~stream_buffer();
+
+	stream_buffer(stream_buffer&) = delete; // No copy constructor
+	stream_buffer& operator=(const stream_buffer&) = delete; // No copy assignment
+
+	/**
+	* @brief Copy size bytes into the current frame's region
+	*/
+	stream_range write(const void* data, size_t size);
+
+	/**
+	* @brief Make room for size bytes and return where to write them, commit() them before the next reserve or write
+	*
+	* Lets large data (sprite vertices, ...) be generated in place instead of copied.
+	*
+	* @param alignment Of the offset, 0 for the target's (pass the vertex stride for a base vertex)
+	*/
+	void* reserve(size_t size, stream_range& range, size_t alignment = 0);
+
+	/**
+	* @brief Finish a reserve(), only uploads anything while gl_trace runs
+	*/
+	void commit(const stream_range& range);
+
+	template <typename T>
+	stream_range write(const T& data) {
+		return write(&data, sizeof(T));
+	}
+
+	/**
+	* @brief Bind a written range to an indexed binding point of the target (uniform block binding, ...)
+	*/
+	void bind(GLuint index, const stream_range& range) const;
+
+	GLuint handle() const { return m_handle; }
+	uint32_t generation() const { return m_generation; } // Changes when growing replaces the buffer (a new buffer may reuse the name)
+	size_t region_bytes() const { return m_region_bytes; }
+	size_t used() const { return m_offset - m_region * m_region_bytes; } // Bytes of the current region written
+
+private:
+	GLenum m_target;
+	GLint m_alignment;
+
+	GLuint m_handle;
+	uint32_t m_generation;
+	unsigned char* m_mapped;
+	size_t m_region_bytes;
+
+	size_t m_region;   // Region of the current frame
+	size_t m_offset;   // Next write, from the start of the buffer
+	uint64_t m_frame;  // frame_manager::frame() the region belongs to
+
+	GLsync m_fences[FRAMES_IN_FLIGHT];
+
+	/**
+	* @brief A buffer replaced by growing, deleted once fence signals (null until the frame that replaced it is fenced)
+	*/
+	struct retired_buffer {
+		GLuint handle;
+		GLsync fence;
+	};
+
+	std::vector<retired_buffer> m_retired;
+
+	std::vector<unsigned char> m_staging; // reserve() while tracing, mapped writes would not be in the trace
+
+	void create(size_t bytes_per_frame);
+	void destroy();
+
+	/**
+	* @brief Replace the buffer by a larger one, the old one is kept until the GPU is done with it
+	*/
+	void grow(size_t bytes_per_frame);
+
+	/**
+	* @brief Fence the buffers retired this frame and delete those the GPU is done with
+	*/
+	void release_retired();
+
+	/**
+	* @brief Fence the region of the last frame and wait until the next one is free
+	*/
+	void next_region();
+}; // stream_buffer
+
+#endif // _STREAM_BUFFER_HPP
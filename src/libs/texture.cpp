@@ -1,7 +1,7 @@
 #include <stb_image.h>
 #include <cstdio>
 
-#include "scolor.hpp"
+#include "log.hpp"
 #include "texture.hpp"
 
 bool load_texture(const char* filename, texture* tex) {
@@ -11,11 +11,11 @@ bool load_texture(const char* filename, texture* tex) {
 	tex->m_image_data = stbi_load(filename, &tex->m_width, &tex->m_height, 0, STBI_rgb_alpha);
 
 	if (!tex->m_image_data) {
-		printf(RED("Failed to load texture '%s'\n").c_str(), tex->m_filename);
+		LOG_ERROR(TEXTURE, "Failed to load texture '%s'", tex->m_filename);
 		return false;
 	}
 
-	printf(BLUE("Loaded texture: '%s' - %d by %d\n").c_str(), tex->m_filename, tex->m_width, tex->m_height);
+	LOG_DEBUG(TEXTURE, "Loaded texture: '%s' - %d by %d", tex->m_filename, tex->m_width, tex->m_height);
 
 	//TODO: Generate MIPMAPS
 
@@ -32,7 +32,7 @@ bool load_texture(const char* filename, texture* tex) {
 
 	stbi_image_free(tex->m_image_data);
 
-	printf(GREEN("Successfully Generated Texture: %d\n").c_str(), tex->m_handle);
+	LOG_INFO(TEXTURE, "Successfully Generated Texture: %d", tex->m_handle);
 
 	return true;
 } // load_texture
\ No newline at end of file
@@ -2,7 +2,7 @@
 #define _TEXTURE_HPP
 
 #include <glm/glm.hpp>
-#include <GLEW/glew.h>
+#include "gl.hpp"
 
 struct texture {
 	const char* m_filename;
@@ -0,0 +1,378 @@
+#include "gl.hpp"
+#include <stb_image.h>
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+
+#include "log.hpp"
+#include "profiler.hpp"
+#include "memory_tracker.hpp"
+#include "texture_streamer.hpp"
+
+// Evaluations a texture must want a coarser level before it is trimmed (avoids thrashing)
+constexpr int TEXTURE_DROP_DELAY = 30;
+
+static inline GLint mip_size(GLint size, GLint level) {
+	return std::max(1, size >> level);
+}
+
+/**
+* @brief 2x2 box filter of an RGBA8 image, clamping at odd edges
+*/
+static void downsample(const unsigned char* src, GLint sw, GLint sh, unsigned char* dst, GLint dw, GLint dh) {
+	for (GLint y = 0; y < dh; ++y) {
+		const unsigned char* row0 = src + (size_t)std::min(2 * y, sh - 1) * sw * 4;
+		const unsigned char* row1 = src + (size_t)std::min(2 * y + 1, sh - 1) * sw * 4;
+
+		for (GLint x = 0; x < dw; ++x) {
+			GLint x0 = std::min(2 * x, sw - 1) * 4;
+			GLint x1 = std::min(2 * x + 1, sw - 1) * 4;
+
+			for (int c = 0; c < 4; ++c) {
+				*dst++ = (unsigned char)((row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2) / 4);
+			}
+		}
+	}
+} // downsample
+
+texture_streamer::texture_streamer(size_t budget_bytes, int low_mip_size, size_t upload_bytes_per_frame)
+	: m_budget_bytes(budget_bytes), m_upload_bytes_per_frame(upload_bytes_per_frame), m_low_mip_size(low_mip_size),
+	  m_resident_bytes(0), m_stop(false), m_dirty(false) {
+	stbi_set_flip_vertically_on_load(true); // Same orientation as load_texture, set once here since the flag is global
+
+	m_worker = std::thread(&texture_streamer::run, this);
+}
+
+texture_streamer::~texture_streamer() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+
+	m_wake.notify_one();
+	m_worker.join();
+}
+
+bool texture_streamer::add(const char* filename, texture* tex) {
+	memory_scope scope(memory_tag::TEXTURES);
+
+	int width, height, channels;
+
+	if (!stbi_info(filename, &width, &height, &channels)) {
+		LOG_ERROR(TEXTURE, "Failed to load texture '%s'", filename);
+		return false;
+	}
+
+	auto e = std::make_unique<entry>();
+	e->tex = tex;
+	e->filename = filename;
+	e->width = width;
+	e->height = height;
+	e->levels = 1 + (GLint)std::floor(std::log2((float)std::max(width, height)));
+
+	e->low_level = 0;
+	while (e->low_level < e->levels - 1 && std::max(width, height) >> e->low_level > m_low_mip_size) {
+		++e->low_level;
+	}
+
+	e->resident = e->levels;
+	e->feedback = 0.0f;
+	e->in_flight = false;
+	e->failed = false;
+
+	tex->m_filename = filename;
+	tex->m_width = width;
+	tex->m_height = height;
+
+	// Grey placeholder until the worker delivers the low mips
+	const unsigned char placeholder[4] = { 128, 128, 128, 255 };
+
+	glGenTextures(1, &tex->m_handle);
+	glBindTexture(GL_TEXTURE_2D, tex->m_handle);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+	LOG_DEBUG(TEXTURE, "Streaming texture: '%s' - %d by %d, %d mips", filename, width, height, e->levels);
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_lookup[tex] = e.get();
+		m_entries.push_back(std::move(e));
+		m_dirty = true;
+	}
+
+	m_wake.notify_one();
+
+	return true;
+} // add
+
+void texture_streamer::report(const texture* tex, float screen_size) {
+	auto it = m_lookup.find(tex);
+
+	if (it != m_lookup.end()) {
+		it->second->accum = std::max(it->second->accum, screen_size);
+	}
+} // report
+
+void texture_streamer::update() {
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		for (auto& job : m_finished) {
+			m_ready.push_back(std::move(job));
+		}
+
+		m_finished.clear();
+	}
+
+	// Apply finished jobs until the per-frame upload budget is spent (trims are GPU copies and always fit)
+	size_t uploaded = 0;
+	size_t applied = 0;
+
+	for (; applied < m_ready.size() && uploaded < m_upload_bytes_per_frame; ++applied) {
+		mip_job& job = m_ready[applied];
+
+		if (!job.trim) {
+			uploaded += level_bytes(job.e, job.first_level);
+		}
+
+		apply(job);
+	}
+
+	m_ready.erase(m_ready.begin(), m_ready.begin() + applied);
+
+	// Publish this frame's feedback and let the worker re-evaluate
+	for (auto& e : m_entries) {
+		e->feedback.store(e->accum, std::memory_order_relaxed);
+		e->accum = 0.0f;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_dirty = true;
+	}
+
+	m_wake.notify_one();
+} // update
+
+void texture_streamer::run() {
+	profiler::set_thread_name("Texture streamer");
+
+	std::vector<entry*> entries;
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	while (true) {
+		m_wake.wait(lock, [this] { return m_stop || m_dirty; });
+
+		if (m_stop)
+			break;
+
+		m_dirty = false;
+
+		entries.clear();
+		for (auto& e : m_entries) {
+			entries.push_back(e.get());
+		}
+
+		lock.unlock();
+		evaluate(entries);
+		lock.lock();
+	}
+} // run
+
+void texture_streamer::evaluate(std::vector<entry*>& entries) {
+	PROFILE_SCOPE("Streaming evaluate");
+
+	std::vector<GLint> wanted(entries.size());
+	size_t total = 0;
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		wanted[i] = desired_level(entries[i]);
+		total += level_bytes(entries[i], wanted[i]);
+	}
+
+	// Over budget: coarsen the texture that spends the most bytes per covered pixel until everything fits
+	while (total > m_budget_bytes) {
+		size_t best = entries.size();
+		float best_cost = -1.0f;
+
+		for (size_t i = 0; i < entries.size(); ++i) {
+			if (wanted[i] >= entries[i]->low_level)
+				continue;
+
+			float level_size = (float)(level_bytes(entries[i], wanted[i]) - level_bytes(entries[i], wanted[i] + 1));
+			float cost = level_size / std::max(entries[i]->feedback.load(std::memory_order_relaxed), 1.0f);
+
+			if (cost > best_cost) {
+				best_cost = cost;
+				best = i;
+			}
+		}
+
+		if (best == entries.size())
+			break; // Only low mips left, they stay resident regardless of the budget
+
+		total -= level_bytes(entries[best], wanted[best]) - level_bytes(entries[best], wanted[best] + 1);
+		++wanted[best];
+	}
+
+	for (size_t i = 0; i < entries.size(); ++i) {
+		entry* e = entries[i];
+		GLint resident = e->resident.load();
+
+		if (e->in_flight || e->failed)
+			continue;
+
+		if (wanted[i] < resident) {
+			e->drop_frames = 0;
+
+			mip_job job;
+			if (!load_levels(e, wanted[i], job)) {
+				e->failed = true;
+				continue;
+			}
+
+			e->in_flight = true;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finished.push_back(std::move(job));
+		}
+		else if (wanted[i] > resident) {
+			if (++e->drop_frames < TEXTURE_DROP_DELAY)
+				continue;
+
+			e->drop_frames = 0;
+			e->in_flight = true;
+
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_finished.push_back(mip_job{ e, wanted[i], true, {} });
+		}
+		else {
+			e->drop_frames = 0;
+		}
+	}
+} // evaluate
+
+bool texture_streamer::load_levels(entry* e, GLint first_level, mip_job& job) {
+	PROFILE_SCOPE("Decode mips");
+	memory_scope scope(memory_tag::TEXTURES);
+
+	int width, height;
+	unsigned char* data = stbi_load(e->filename.c_str(), &width, &height, nullptr, STBI_rgb_alpha);
+
+	if (!data) {
+		LOG_ERROR(TEXTURE, "Failed to stream texture '%s'", e->filename.c_str());
+		return false;
+	}
+
+	if (width != e->width || height != e->height) {
+		LOG_ERROR(TEXTURE, "Texture '%s' changed size while streaming", e->filename.c_str());
+		stbi_image_free(data);
+		return false;
+	}
+
+	job.e = e;
+	job.first_level = first_level;
+	job.trim = false;
+	job.pixels.resize(e->levels - first_level);
+
+	std::vector<unsigned char> current(data, data + (size_t)width * height * 4);
+	std::vector<unsigned char> next;
+	stbi_image_free(data);
+
+	// Build the chain from the full image, keeping only the requested levels
+	for (GLint level = 0; level < e->levels; ++level) {
+		if (level > 0) {
+			GLint w = mip_size(e->width, level), h = mip_size(e->height, level);
+
+			next.resize((size_t)w * h * 4);
+			downsample(current.data(), mip_size(e->width, level - 1), mip_size(e->height, level - 1), next.data(), w, h);
+			current.swap(next);
+		}
+
+		if (level >= first_level) {
+			job.pixels[level - first_level] = current;
+		}
+	}
+
+	return true;
+} // load_levels
+
+void texture_streamer::apply(mip_job& job) {
+	entry* e = job.e;
+	GLint resident = e->resident.load();
+
+	e->in_flight = false;
+
+	// Stale: a load that is no finer than what is resident, or a trim of the placeholder
+	if ((!job.trim && job.first_level >= resident) || (job.trim && (resident >= e->levels || job.first_level <= resident)))
+		return;
+
+	GLint count = e->levels - job.first_level;
+	GLint width = mip_size(e->width, job.first_level);
+	GLint height = mip_size(e->height, job.first_level);
+
+	GLuint handle;
+	glGenTextures(1, &handle);
+	glBindTexture(GL_TEXTURE_2D, handle);
+	glTexStorage2D(GL_TEXTURE_2D, count, GL_RGBA8, width, height);
+
+	if (job.trim) {
+		// Shrinking never touches the disk, the remaining levels are copied on the GPU
+		for (GLint i = 0; i < count; ++i) {
+			glCopyImageSubData(
+				e->tex->m_handle, GL_TEXTURE_2D, job.first_level - resident + i, 0, 0, 0,
+				handle, GL_TEXTURE_2D, i, 0, 0, 0,
+				mip_size(width, i), mip_size(height, i), 1
+			);
+		}
+	}
+	else {
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		for (GLint i = 0; i < count; ++i) {
+			glTexSubImage2D(GL_TEXTURE_2D, i, 0, 0, mip_size(width, i), mip_size(height, i), GL_RGBA, GL_UNSIGNED_BYTE, job.pixels[i].data());
+		}
+	}
+
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, count - 1);
+
+	glDeleteTextures(1, &e->tex->m_handle);
+
+	m_resident_bytes += level_bytes(e, job.first_level);
+	m_resident_bytes -= level_bytes(e, resident);
+
+	e->tex->m_handle = handle;
+	e->resident = job.first_level;
+
+	LOG_TRACE(TEXTURE, "Texture '%s' resident from mip %d (%d by %d), %zu KB streamed in total",
+		e->filename.c_str(), job.first_level, width, height, m_resident_bytes.load() / 1024);
+} // apply
+
+GLint texture_streamer::desired_level(const entry* e) const {
+	float screen_size = e->feedback.load(std::memory_order_relaxed);
+
+	if (screen_size <= 0.0f)
+		return e->low_level; // Not drawn last frame
+
+	// One texel per covered pixel along the largest dimension
+	float ratio = (float)std::max(e->width, e->height) / screen_size;
+	GLint level = (GLint)std::floor(std::log2(std::max(ratio, 1.0f)));
+
+	return std::min(level, e->low_level);
+} // desired_level
+
+size_t texture_streamer::level_bytes(const entry* e, GLint first_level) {
+	size_t bytes = 0;
+
+	for (GLint level = first_level; level < e->levels; ++level) {
+		bytes += (size_t)mip_size(e->width, level) * mip_size(e->height, level) * 4;
+	}
+
+	return bytes;
+} // level_bytes
@@ -0,0 +1,111 @@
+#ifndef _TEXTURE_STREAMER_HPP
+#define _TEXTURE_STREAMER_HPP
+
+#include "gl.hpp"
+#include <condition_variable>
+#include <unordered_map>
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <mutex>
+
+#include "texture.hpp"
+
+/**
+* @brief Streams texture mip levels in and out of VRAM under a global memory budget
+*
+* Textures start with only their low mips resident. A worker thread reads renderer
+* feedback (projected screen size), decides which mip level each texture should
+* have resident and decodes images from disk. The main thread only creates the GL
+* storage and uploads the prepared levels in update().
+*/
+class texture_streamer {
+public:
+	/**
+	* @param budget_bytes Maximum number of bytes of mip data kept resident in VRAM
+	* @param low_mip_size Largest dimension of the mips loaded up front (and never evicted)
+	* @param upload_bytes_per_frame Maximum number of bytes uploaded per update()
+	*/
+	texture_streamer(size_t budget_bytes, int low_mip_size = 64, size_t upload_bytes_per_frame = 8 * 1024 * 1024);
+
+	~texture_streamer();
+
+	texture_streamer(texture_streamer&) = delete; // No copy constructor
+	texture_streamer& operator=(const texture_streamer&) = delete; // No copy assignment
+
+	/**
+	* @brief Register a texture for streaming (only the image header is read here)
+	*
+	* @param filename The name of the texture file
+	* @param tex The texture object, given a placeholder until the low mips arrive
+	*
+	* @return bool True if the image header could be read
+	*/
+	bool add(const char* filename, texture* tex);
+
+	/**
+	* @brief Renderer feedback: the texture was drawn covering about screen_size pixels
+	*/
+	void report(const texture* tex, float screen_size);
+
+	/**
+	* @brief Apply finished mip uploads and hand this frame's feedback to the worker (main thread)
+	*/
+	void update();
+
+	size_t resident_bytes() const { return m_resident_bytes; }
+	size_t budget_bytes() const { return m_budget_bytes; }
+
+private:
+	struct entry {
+		texture* tex;
+		std::string filename;
+		GLint width, height, levels;
+		GLint low_level;                   // Coarsest level that is never evicted
+
+		std::atomic<GLint> resident;       // Finest level on the GPU (levels when only the placeholder is)
+		std::atomic<float> feedback;       // Screen size published by update()
+		float accum = 0.0f;                // Screen size reported this frame (main thread)
+
+		std::atomic<bool> in_flight;       // A job for this texture is waiting to be applied
+		bool failed;                       // Image could not be decoded, stop retrying (worker thread)
+		int drop_frames = 0;               // Evaluations the texture has wanted a coarser level (worker thread)
+	};
+
+	struct mip_job {
+		entry* e;
+		GLint first_level;
+		bool trim;                         // Drop levels by copying the GPU data, no pixels attached
+		std::vector<std::vector<unsigned char>> pixels;
+	};
+
+	size_t m_budget_bytes;
+	size_t m_upload_bytes_per_frame;
+	int m_low_mip_size;
+	std::atomic<size_t> m_resident_bytes;
+
+	std::vector<std::unique_ptr<entry>> m_entries;
+	std::unordered_map<const texture*, entry*> m_lookup;
+
+	std::vector<mip_job> m_finished; // Guarded by m_mutex
+	std::vector<mip_job> m_ready;    // Main thread queue of jobs waiting for upload budget
+
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	bool m_stop;
+	bool m_dirty;
+	std::thread m_worker;
+
+	void run();
+	void evaluate(std::vector<entry*>& entries);
+	bool load_levels(entry* e, GLint first_level, mip_job& job);
+	void apply(mip_job& job);
+
+	GLint desired_level(const entry* e) const;
+	static size_t level_bytes(const entry* e, GLint first_level);
+}; // texture_streamer
+
+#endif // _TEXTURE_STREAMER_HPP
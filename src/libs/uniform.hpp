@@ -2,10 +2,14 @@
 #define _UNIFORM_HPP
 
 #include <glm/glm.hpp>
-#include <GLEW/glew.h>
+#include "gl.hpp"
+#include <string_view>
+#include <cstdint>
 #include <variant>
+#include <string>
 
 using uniform_value = std::variant<
+	std::monostate, // Not set yet
 	int,
 	float,
 	glm::vec3,
@@ -13,12 +17,18 @@ using uniform_value = std::variant<
 	glm::mat4
 >;
 
+/**
+* @brief Index of a uniform in a material, resolved once instead of looking names up every frame
+*/
+using uniform_handle = uint32_t;
+
 struct uniform_data {
-	GLuint location;
+	std::string name;
+	GLint location;
 	uniform_value value;
 
 	uniform_data() : location(-1) {}
-	uniform_data(GLuint loc, uniform_value v) : location(loc), value(v) {}
+	uniform_data(std::string_view n) : name(n), location(-1) {}
 };
 
 #endif // _UNIFORM_HPP
\ No newline at end of file
@@ -3,17 +3,70 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/constants.hpp>
+
+constexpr float TANGENT_MIN_CODE = 1.0f / 32767.0f; // One snorm16 step, a tangent code is never 0 so its sign survives
+
+/**
+* @brief Two directions spanning the plane of a normal, tangent angles are measured from b1 towards b2
+*
+* Continuous over the sphere except next to ±axis, which is kept away from the axes and
+* diagonals flat geometry tends to face. Must match tangent_decode in vertex_decode.glsl.
+*/
+inline void tangent_basis(glm::vec3 n, glm::vec3& b1, glm::vec3& b2) {
+	const glm::vec3 axis = glm::vec3(0.348f, 0.815f, 0.463f);
+
+	n = glm::normalize(n);
+	b1 = glm::cross(axis, n);
+
+	float length = glm::length(b1);
+	b1 = length > 1e-6f ? b1 / length : glm::normalize(glm::cross(glm::vec3(1.0f, 0.0f, 0.0f), n));
+	b2 = glm::cross(n, b1);
+}
+
+/**
+* @brief Pack a tangent frame into one value: the tangent's angle around the normal, signed by the bitangent handedness
+*
+* The angle maps to [TANGENT_MIN_CODE, 1) of the magnitude, so the code fits the spare
+* w of a POSITION_SNORM16 position. The tangent does not need to be unit or orthogonal.
+*
+* @param sign Handedness of the bitangent, cross(normal, tangent) * sign
+*/
+inline float tangent_encode(const glm::vec3& normal, const glm::vec3& tangent, float sign) {
+	glm::vec3 b1, b2;
+	tangent_basis(normal, b1, b2);
+
+	float angle = glm::atan(glm::dot(tangent, b2), glm::dot(tangent, b1));
+	if (angle < 0.0f) {
+		angle += glm::two_pi<float>();
+	}
+
+	float code = TANGENT_MIN_CODE + (1.0f - TANGENT_MIN_CODE) * glm::min(angle / glm::two_pi<float>(), 1.0f);
+	return sign < 0.0f ? -code : code;
+}
+
+/**
+* @brief Unit tangent in xyz and the bitangent handedness in w of a tangent_encode code
+*/
+inline glm::vec4 tangent_decode(const glm::vec3& normal, float code) {
+	glm::vec3 b1, b2;
+	tangent_basis(normal, b1, b2);
+
+	float angle = (glm::max(glm::abs(code), TANGENT_MIN_CODE) - TANGENT_MIN_CODE) / (1.0f - TANGENT_MIN_CODE) * glm::two_pi<float>();
+	return glm::vec4(b1 * glm::cos(angle) + b2 * glm::sin(angle), code < 0.0f ? -1.0f : 1.0f);
+}
 
 struct vertex {
 	glm::vec3 m_pos;
 	glm::vec3 m_color;
 	glm::vec2 m_texCoord;
 	glm::vec3 m_normal;
+	float m_tangent; // Tangent frame around m_normal, see tangent_encode
 
-	vertex() : m_pos(glm::vec3(0.0f, 0.0f, 0.0f)), m_color(glm::vec3(1.0f, 1.0f, 1.0f)), m_texCoord(glm::vec2(0.0f, 0.0f)), m_normal(glm::vec3(1.0f, 1.0f, 1.0f)) {}
+	vertex() : m_pos(glm::vec3(0.0f, 0.0f, 0.0f)), m_color(glm::vec3(1.0f, 1.0f, 1.0f)), m_texCoord(glm::vec2(0.0f, 0.0f)), m_normal(glm::vec3(1.0f, 1.0f, 1.0f)), m_tangent(TANGENT_MIN_CODE) {}
 
 	bool operator==(const vertex& other) const {
-		return m_pos == other.m_pos && m_color == other.m_color && m_texCoord == other.m_texCoord && m_normal == other.m_normal;
+		return m_pos == other.m_pos && m_color == other.m_color && m_texCoord == other.m_texCoord && m_normal == other.m_normal && m_tangent == other.m_tangent;
 	}
 }; // vertex
 
@@ -23,7 +76,8 @@ template<> struct std::hash<vertex> {
 			(std::hash<glm::vec3>()(v.m_pos) ^
 				(std::hash<glm::vec3>()(v.m_color) << 1)) >> 1) ^
 			(std::hash<glm::vec2>()(v.m_texCoord) << 1) >> 1) ^
-			(std::hash<glm::vec3>()(v.m_normal) << 1);
+			(std::hash<glm::vec3>()(v.m_normal) << 1) ^
+			(std::hash<float>()(v.m_tangent) << 2);
 	}
 }; // vertex hash
 
@@ -34,9 +88,12 @@ enum class vertex_attr {
 	VERTEX,
 	COLOR,
 	NORMAL,
-	TEXCOORD
+	TEXCOORD,
+	TANGENT
 };
 
+constexpr size_t VERTEX_ATTR_COUNT = 5;
+
 /**
 * @brief Get the string name of a vertex attribute (must match what is in the shader)
 */
@@ -44,7 +101,19 @@ static const char* vertex_attr_strings[] = {
 	"in_vertex",
 	"in_color",
 	"in_normal",
-	"in_texCoord"
+	"in_texCoord",
+	"in_tangent"
+};
+
+/**
+* @brief Shader define set when a vertex layout provides the attribute (same order as vertex_attr)
+*/
+static const char* vertex_attr_defines[] = {
+	"HAS_VERTEX",
+	"HAS_COLOR",
+	"HAS_NORMAL",
+	"HAS_TEXCOORD",
+	"HAS_TANGENT"
 };
 
 /**
@@ -0,0 +1,518 @@
+#ifndef _VERTEX_LAYOUT_HPP
+#define _VERTEX_LAYOUT_HPP
+
+#include <glm/glm.hpp>
+#include <glm/gtc/packing.hpp>
+#include "gl.hpp"
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <array>
+#include <type_traits>
+
+#include "vertex.hpp"
+#include "shader_preprocessor.hpp"
+
+/**
+* @brief GPU storage format of a single vertex attribute
+*/
+enum class attr_format {
+	FLOAT1,
+	FLOAT2,
+	FLOAT3,
+	FLOAT4,
+	POSITION_SNORM16, // 16-bit snorm xyz relative to the mesh bounds, decoded with pos_scale/pos_offset, w holds the tangent code
+	POSITION_W,       // Not stored on its own, the w of the POSITION_SNORM16 attribute declared just before
+	NORMAL_OCT16,     // Octahedral encoded unit vector, 16-bit snorm per component
+	HALF2,            // Half float pair
+	UNORM16x2,        // 16-bit unorm pair, [0, 1] texcoords that are cheaper to pack than halves
+	UNORM8x4,         // 8-bit unorm colour
+	CONSTANT          // Not stored, one value for the whole mesh set as the generic attribute at draw time
+};
+
+/**
+* @brief Per mesh parameters of the quantized formats
+*/
+struct vertex_encoding {
+	glm::vec3 offset = glm::vec3(0.0f); // Position = snorm * scale + offset
+	glm::vec3 scale = glm::vec3(1.0f);
+	glm::vec4 constants[VERTEX_ATTR_COUNT] = {}; // Value of CONSTANT attributes, by vertex_attr
+};
+
+/**
+* @brief Octahedral encoding of a unit vector into [-1, 1]^2
+*/
+inline glm::vec2 oct_encode(glm::vec3 n) {
+	n /= glm::abs(n.x) + glm::abs(n.y) + glm::abs(n.z);
+
+	glm::vec2 e = glm::vec2(n.x, n.y);
+	if (n.z < 0.0f) {
+		e = (1.0f - glm::abs(glm::vec2(n.y, n.x))) * glm::vec2(e.x >= 0.0f ? 1.0f : -1.0f, e.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return e;
+}
+
+inline glm::vec3 oct_decode(glm::vec2 e) {
+	glm::vec3 n = glm::vec3(e.x, e.y, 1.0f - glm::abs(e.x) - glm::abs(e.y));
+	float t = glm::max(-n.z, 0.0f);
+
+	n.x += n.x >= 0.0f ? -t : t;
+	n.y += n.y >= 0.0f ? -t : t;
+
+	return glm::normalize(n);
+}
+
+template<attr_format Format> struct format_traits;
+
+template<GLint Components>
+struct float_traits {
+	static constexpr GLint components = Components;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+	static constexpr uint32_t size = Components * sizeof(float);
+	static constexpr const char* glsl = Components == 1 ? "float" : Components == 2 ? "vec2" : Components == 3 ? "vec3" : "vec4";
+
+	static void encode(const glm::vec4& value, const vertex_encoding&, unsigned char* dst) {
+		memcpy(dst, &value[0], size);
+	}
+
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding&) {
+		glm::vec4 value(0.0f);
+		memcpy(&value[0], src, size);
+		return value;
+	}
+
+	static std::string load(const char* name, const char* swizzle) {
+		return std::string(name) + swizzle;
+	}
+};
+
+template<> struct format_traits<attr_format::FLOAT1> : float_traits<1> {};
+template<> struct format_traits<attr_format::FLOAT2> : float_traits<2> {};
+template<> struct format_traits<attr_format::FLOAT3> : float_traits<3> {};
+template<> struct format_traits<attr_format::FLOAT4> : float_traits<4> {};
+
+template<> struct format_traits<attr_format::POSITION_SNORM16> {
+	static constexpr GLint components = 4; // w pads to 8 bytes, it carries the tangent for free (POSITION_W)
+	static constexpr GLenum type = GL_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+	static constexpr uint32_t size = 4 * sizeof(int16_t);
+	static constexpr const char* glsl = "vec4";
+
+	static void encode(const glm::vec4& value, const vertex_encoding& enc, unsigned char* dst) {
+		glm::uint64 packed = glm::packSnorm4x16(glm::vec4((glm::vec3(value) - enc.offset) / enc.scale, value.w));
+		memcpy(dst, &packed, size);
+	}
+
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding& enc) {
+		glm::uint64 packed;
+		memcpy(&packed, src, size);
+		return glm::vec4(glm::vec3(glm::unpackSnorm4x16(packed)) * enc.scale + enc.offset, 1.0f);
+	}
+
+	static std::string load(const char* name, const char*) {
+		return std::string("(") + name + ".xyz * pos_scale + pos_offset)";
+	}
+};
+
+template<> struct format_traits<attr_format::POSITION_W> {
+	static constexpr GLint components = 1;
+	static constexpr GLenum type = GL_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+	static constexpr uint32_t size = 0;
+	static constexpr const char* glsl = "float";
+
+	static void encode(const glm::vec4&, const vertex_encoding&, unsigned char*) {}
+
+	// src is the end of the position, its last component is the w
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding&) {
+		int16_t w;
+		memcpy(&w, src - sizeof(int16_t), sizeof(int16_t));
+		return glm::vec4(glm::max((float)w / 32767.0f, -1.0f), 0.0f, 0.0f, 0.0f);
+	}
+
+	static std::string load(const char*, const char*) {
+		return std::string(vertexAttr(vertex_attr::VERTEX)) + ".w";
+	}
+};
+
+template<> struct format_traits<attr_format::NORMAL_OCT16> {
+	static constexpr GLint components = 2;
+	static constexpr GLenum type = GL_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+	static constexpr uint32_t size = 2 * sizeof(int16_t);
+	static constexpr const char* glsl = "vec2";
+
+	static void encode(const glm::vec4& value, const vertex_encoding&, unsigned char* dst) {
+		glm::vec3 n = glm::vec3(value);
+		float length = glm::length(n);
+
+		glm::uint32 packed = glm::packSnorm2x16(length > 0.0f ? oct_encode(n / length) : glm::vec2(0.0f));
+		memcpy(dst, &packed, size);
+	}
+
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding&) {
+		glm::uint32 packed;
+		memcpy(&packed, src, size);
+		return glm::vec4(oct_decode(glm::unpackSnorm2x16(packed)), 0.0f);
+	}
+
+	static std::string load(const char* name, const char*) {
+		return std::string("oct_decode(") + name + ")";
+	}
+};
+
+template<> struct format_traits<attr_format::HALF2> {
+	static constexpr GLint components = 2;
+	static constexpr GLenum type = GL_HALF_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+	static constexpr uint32_t size = 2 * sizeof(uint16_t);
+	static constexpr const char* glsl = "vec2";
+
+	static void encode(const glm::vec4& value, const vertex_encoding&, unsigned char* dst) {
+		glm::uint32 packed = glm::packHalf2x16(glm::vec2(value));
+		memcpy(dst, &packed, size);
+	}
+
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding&) {
+		glm::uint32 packed;
+		memcpy(&packed, src, size);
+		return glm::vec4(glm::unpackHalf2x16(packed), 0.0f, 0.0f);
+	}
+
+	static std::string load(const char* name, const char* swizzle) {
+		return std::string(name) + swizzle;
+	}
+};
+
+template<> struct format_traits<attr_format::UNORM16x2> {
+	static constexpr GLint components = 2;
+	static constexpr GLenum type = GL_UNSIGNED_SHORT;
+	static constexpr GLboolean normalized = GL_TRUE;
+	static constexpr uint32_t size = 2 * sizeof(uint16_t);
+	static constexpr const char* glsl = "vec2";
+
+	static void encode(const glm::vec4& value, const vertex_encoding&, unsigned char* dst) {
+		glm::uint32 packed = glm::packUnorm2x16(glm::vec2(value));
+		memcpy(dst, &packed, size);
+	}
+
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding&) {
+		glm::uint32 packed;
+		memcpy(&packed, src, size);
+		return glm::vec4(glm::unpackUnorm2x16(packed), 0.0f, 0.0f);
+	}
+
+	static std::string load(const char* name, const char* swizzle) {
+		return std::string(name) + swizzle;
+	}
+};
+
+template<> struct format_traits<attr_format::UNORM8x4> {
+	static constexpr GLint components = 4;
+	static constexpr GLenum type = GL_UNSIGNED_BYTE;
+	static constexpr GLboolean normalized = GL_TRUE;
+	static constexpr uint32_t size = 4;
+	static constexpr const char* glsl = "vec4";
+
+	static void encode(const glm::vec4& value, const vertex_encoding&, unsigned char* dst) {
+		glm::uint32 packed = glm::packUnorm4x8(value);
+		memcpy(dst, &packed, size);
+	}
+
+	static glm::vec4 decode(const unsigned char* src, const vertex_encoding&) {
+		glm::uint32 packed;
+		memcpy(&packed, src, size);
+		return glm::unpackUnorm4x8(packed);
+	}
+
+	static std::string load(const char* name, const char* swizzle) {
+		return std::string(name) + swizzle;
+	}
+};
+
+template<> struct format_traits<attr_format::CONSTANT> {
+	static constexpr GLint components = 4;
+	static constexpr GLenum type = GL_FLOAT;
+	static constexpr GLboolean normalized = GL_FALSE;
+	static constexpr uint32_t size = 0;
+	static constexpr const char* glsl = "vec4";
+
+	static void encode(const glm::vec4&, const vertex_encoding&, unsigned char*) {}
+
+	static std::string load(const char* name, const char* swizzle) {
+		return std::string(name) + swizzle;
+	}
+};
+
+/**
+* @brief Read the value of a semantic from the authoring vertex
+*/
+inline glm::vec4 vertex_source(const vertex& v, vertex_attr semantic) {
+	switch (semantic) {
+		case vertex_attr::VERTEX:   return glm::vec4(v.m_pos, v.m_tangent); // The tangent rides in the w of POSITION_SNORM16
+		case vertex_attr::COLOR:    return glm::vec4(v.m_color, 1.0f);
+		case vertex_attr::NORMAL:   return glm::vec4(v.m_normal, 0.0f);
+		case vertex_attr::TEXCOORD: return glm::vec4(v.m_texCoord, 0.0f, 0.0f);
+		case vertex_attr::TANGENT:  return glm::vec4(v.m_tangent, 0.0f, 0.0f, 0.0f);
+	}
+
+	return glm::vec4(0.0f);
+}
+
+/**
+* @brief Swizzle giving the natural size of a semantic (vec3 position, colour and normal, vec2 texcoord, float tangent code)
+*/
+inline const char* vertex_swizzle(vertex_attr semantic) {
+	if (semantic == vertex_attr::TEXCOORD)
+		return ".xy";
+
+	return semantic == vertex_attr::TANGENT ? ".x" : ".xyz";
+}
+
+/**
+* @brief GLSL expression of a semantic from its loaded value, the tangent code becomes the frame (vec4, w the handedness)
+*/
+inline std::string vertex_load(vertex_attr semantic, const std::string& value) {
+	if (semantic == vertex_attr::TANGENT)
+		return "tangent_decode(LOAD_NORMAL, " + value + ")";
+
+	return value;
+}
+
+/**
+* @brief Largest error of each semantic after an encode/decode round trip, by vertex_attr
+*
+* Positions, texcoords and colours are distances, normals and tangents are angles in degrees
+* (a tangent of the wrong handedness is 180).
+*/
+using vertex_error = std::array<float, VERTEX_ATTR_COUNT>;
+
+/**
+* @brief One attribute of a vertex layout, stored at location (int)Semantic
+*/
+template<vertex_attr Semantic, attr_format Format>
+struct attribute {
+	static constexpr vertex_attr semantic = Semantic;
+	static constexpr attr_format format = Format;
+	using traits = format_traits<Format>;
+
+	static void encode(const vertex& v, const vertex_encoding& enc, unsigned char* dst) {
+		traits::encode(vertex_source(v, Semantic), enc, dst);
+	}
+
+	static void setup(GLsizei stride, uint32_t offset) {
+		if constexpr (Format != attr_format::CONSTANT && Format != attr_format::POSITION_W) {
+			glEnableVertexAttribArray((GLuint)Semantic);
+			glVertexAttribPointer((GLuint)Semantic, traits::components, traits::type, traits::normalized, stride, (void*)(uintptr_t)offset);
+		}
+	}
+
+	/**
+	* @brief Error of one vertex after a round trip through the packed data
+	*/
+	static float error(const vertex& v, const vertex_encoding& enc, const unsigned char* src) {
+		glm::vec4 expected = vertex_source(v, Semantic);
+		glm::vec4 actual;
+
+		if constexpr (Format == attr_format::CONSTANT) {
+			actual = enc.constants[(size_t)Semantic];
+		}
+		else {
+			actual = traits::decode(src, enc);
+		}
+
+		if constexpr (Semantic == vertex_attr::NORMAL) {
+			float length = glm::length(glm::vec3(expected));
+			if (length <= 0.0f)
+				return 0.0f;
+
+			// atan2 of sine and cosine, acos loses small angles to float rounding
+			glm::vec3 a = glm::vec3(expected) / length;
+			glm::vec3 b = glm::normalize(glm::vec3(actual));
+			return glm::degrees(glm::atan(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+		}
+		else if constexpr (Semantic == vertex_attr::TANGENT) {
+			glm::vec4 a = tangent_decode(v.m_normal, expected.x);
+			glm::vec4 b = tangent_decode(v.m_normal, actual.x);
+
+			if (a.w != b.w)
+				return 180.0f;
+
+			return glm::degrees(glm::atan(glm::length(glm::cross(glm::vec3(a), glm::vec3(b))), glm::dot(glm::vec3(a), glm::vec3(b))));
+		}
+		else if constexpr (Semantic == vertex_attr::TEXCOORD) {
+			return glm::length(glm::vec2(expected) - glm::vec2(actual));
+		}
+		else {
+			return glm::length(glm::vec3(expected) - glm::vec3(actual));
+		}
+	}
+
+	/**
+	* @brief Shader input declaration, none for an attribute stored in another one
+	*/
+	static std::string input() {
+		if constexpr (Format == attr_format::POSITION_W) {
+			return "";
+		}
+		else {
+			return "layout(location = " + std::to_string((int)Semantic) + ") in " + traits::glsl + " " + vertexAttr(Semantic) + "; ";
+		}
+	}
+}; // attribute
+
+/**
+* @brief A vertex layout known at compile time
+*
+* Offsets, stride, VAO setup and the GLSL input declarations are all derived from
+* the attribute list, so a mesh and its shader can never disagree on the format.
+*/
+template<typename... Attrs>
+struct vertex_layout {
+	static constexpr size_t count = sizeof...(Attrs);
+	static constexpr uint32_t stride = (Attrs::traits::size + ... + 0u);
+	static constexpr uint32_t semantics = ((1u << (uint32_t)Attrs::semantic) | ... | 0u);
+	static constexpr uint32_t constants = (((Attrs::format == attr_format::CONSTANT ? 1u : 0u) << (uint32_t)Attrs::semantic) | ... | 0u);
+
+	// A POSITION_W attribute reads the w of the position declared right before it
+	static_assert([] {
+		constexpr attr_format formats[] = { Attrs::format..., attr_format::CONSTANT };
+		for (size_t i = 0; i < count; ++i) {
+			if (formats[i] == attr_format::POSITION_W && (i == 0 || formats[i - 1] != attr_format::POSITION_SNORM16))
+				return false;
+		}
+		return true;
+	}(), "POSITION_W must follow a POSITION_SNORM16 attribute");
+
+	static constexpr std::array<uint32_t, count> offsets = [] {
+		std::array<uint32_t, count> result = {};
+		uint32_t offset = 0;
+		size_t i = 0;
+
+		((result[i++] = offset, offset += Attrs::traits::size), ...);
+
+		return result;
+	}();
+
+	/**
+	* @brief Encode authoring vertices into the interleaved GPU format
+	*/
+	static void pack(const vertex* src, size_t n, const vertex_encoding& enc, unsigned char* dst) {
+		for (size_t v = 0; v < n; ++v, dst += stride) {
+			size_t i = 0;
+			(Attrs::encode(src[v], enc, dst + offsets[i++]), ...);
+		}
+	}
+
+	/**
+	* @brief Decode packed vertices on the CPU and measure how far they are from the source vertices
+	*/
+	static vertex_error error(const vertex* src, size_t n, const vertex_encoding& enc, const unsigned char* packed) {
+		vertex_error result = {};
+
+		for (size_t v = 0; v < n; ++v, packed += stride) {
+			size_t i = 0;
+			((result[(size_t)Attrs::semantic] = glm::max(result[(size_t)Attrs::semantic], Attrs::error(src[v], enc, packed + offsets[i++]))), ...);
+		}
+
+		return result;
+	}
+
+	/**
+	* @brief Set the attribute pointers of the bound VAO for the bound vertex buffer
+	*/
+	static void setup() {
+		size_t i = 0;
+
+		(Attrs::setup(stride, offsets[i++]), ...);
+	}
+
+	/**
+	* @brief Defines for the vertex shader
+	*
+	* VERTEX_INPUTS declares the inputs, HAS_<SEMANTIC> is set per attribute and
+	* LOAD_<SEMANTIC> is the expression decoding it (include/vertex_decode.glsl).
+	*/
+	static std::vector<shader_define> defines() {
+		std::string inputs;
+		std::vector<shader_define> result;
+
+		((inputs += Attrs::input()), ...);
+		(result.push_back({ vertex_attr_defines[(size_t)Attrs::semantic], "1" }), ...);
+		(result.push_back({ std::string("LOAD_") + (vertex_attr_defines[(size_t)Attrs::semantic] + 4), vertex_load(Attrs::semantic, Attrs::traits::load(vertexAttr(Attrs::semantic), vertex_swizzle(Attrs::semantic))) }), ...);
+
+		result.push_back({ "VERTEX_INPUTS", inputs });
+
+		return result;
+	}
+}; // vertex_layout
+
+/**
+* @brief Type erased vertex layout, what a mesh stores
+*/
+struct vertex_format {
+	uint32_t stride;
+	uint32_t semantics; // Bit per vertex_attr
+	uint32_t constants; // Semantics stored as one value per mesh (CONSTANT)
+	void (*pack)(const vertex* src, size_t n, const vertex_encoding& enc, unsigned char* dst);
+	vertex_error (*error)(const vertex* src, size_t n, const vertex_encoding& enc, const unsigned char* packed);
+	void (*setup)();
+	vertex_format (*fallback)(); // Format used when a CONSTANT attribute differs between vertices, may be null
+};
+
+/**
+* @param Fallback Layout to use when the mesh's CONSTANT attributes are not uniform, it must declare the same shader inputs
+*/
+template<typename Layout, typename Fallback = Layout>
+constexpr vertex_format make_vertex_format() {
+	vertex_format (*fallback)() = nullptr;
+	if constexpr (!std::is_same_v<Layout, Fallback>) {
+		fallback = &make_vertex_format<Fallback>;
+	}
+
+	return { Layout::stride, Layout::semantics, Layout::constants, &Layout::pack, &Layout::error, &Layout::setup, fallback };
+}
+
+using vertex_layout_full = vertex_layout<
+	attribute<vertex_attr::VERTEX, attr_format::FLOAT3>,
+	attribute<vertex_attr::COLOR, attr_format::FLOAT3>,
+	attribute<vertex_attr::TEXCOORD, attr_format::FLOAT2>,
+	attribute<vertex_attr::NORMAL, attr_format::FLOAT3>,
+	attribute<vertex_attr::TANGENT, attr_format::FLOAT1>
+>; // Same as vertex, 48 bytes
+
+using vertex_layout_p = vertex_layout<
+	attribute<vertex_attr::VERTEX, attr_format::FLOAT3>
+>; // 12 bytes
+
+using vertex_layout_pnt = vertex_layout<
+	attribute<vertex_attr::VERTEX, attr_format::FLOAT3>,
+	attribute<vertex_attr::NORMAL, attr_format::FLOAT3>,
+	attribute<vertex_attr::TEXCOORD, attr_format::FLOAT2>
+>; // 32 bytes
+
+using vertex_layout_quantized = vertex_layout<
+	attribute<vertex_attr::VERTEX, attr_format::POSITION_SNORM16>,
+	attribute<vertex_attr::TANGENT, attr_format::POSITION_W>,
+	attribute<vertex_attr::COLOR, attr_format::CONSTANT>,
+	attribute<vertex_attr::NORMAL, attr_format::NORMAL_OCT16>,
+	attribute<vertex_attr::TEXCOORD, attr_format::HALF2>
+>; // 16 bytes, colour uniform over the mesh, the tangent in the position's w
+
+using vertex_layout_quantized_color = vertex_layout<
+	attribute<vertex_attr::VERTEX, attr_format::POSITION_SNORM16>,
+	attribute<vertex_attr::TANGENT, attr_format::POSITION_W>,
+	attribute<vertex_attr::COLOR, attr_format::UNORM8x4>,
+	attribute<vertex_attr::NORMAL, attr_format::NORMAL_OCT16>,
+	attribute<vertex_attr::TEXCOORD, attr_format::HALF2>
+>; // 20 bytes, fallback of vertex_layout_quantized
+
+static_assert(vertex_layout_full::stride == sizeof(vertex), "Full layout must match the authoring vertex");
+static_assert(vertex_layout_pnt::offsets[2] == 24, "Offsets are packed in declaration order");
+static_assert(vertex_layout_quantized::stride == 16, "The tangent must not grow the quantized layout");
+static_assert(vertex_layout_quantized::stride * 2 < sizeof(vertex), "Quantized layout must be less than half the authoring vertex");
+
+#endif // _VERTEX_LAYOUT_HPP
@@ -1,19 +1,39 @@
 #include <glm/glm.hpp>
-#include <GLEW/glew.h>
+#include "gl.hpp"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glfw/glfw3.h>
+#include <filesystem>
+#include <cstring>
+#include <cstdlib>
 #include <cstdio>
 #include <vector>
 #include <string>
 #define _USE_MATH_DEFINES
 #include<math.h>
 
-#include "scolor.hpp"
+#include "log.hpp"
 
 #include "camera.hpp"
 #include "player.hpp"
 #include "shader.hpp"
+#include "shader_batch.hpp"
+#include "shader_variants.hpp"
 #include "object.hpp"
+#include "obj_stream.hpp"
+#include "texture_streamer.hpp"
+#include "asset_watcher.hpp"
+#include "profiler.hpp"
+#include "frame_arena.hpp"
+#include "frame_manager.hpp"
+#include "stream_buffer.hpp"
+#include "sprite_batch.hpp"
+#include "fixed_clock.hpp"
+#include "heap_stats.hpp"
+#include "memory_tracker.hpp"
+#include "benchmark.hpp"
+#include "tests.hpp"
+#include "gl_trace.hpp"
+#include "gl_replay.hpp"
 
 #include "render_3d_component.hpp"
 #include "earth.hpp"
@@ -25,6 +45,33 @@
 int SCRN_WIDTH = 1920;
 int SCRN_HEIGHT = 1080;
 
+/* Asset Data */
+
+constexpr const char* OBJECT_VARIANTS = "src/shaders/loaded_obj.variants"; // Variant manifest of the object shader
+
+/* Profiling Data */
+
+constexpr const char* PROFILE_TRACE = "profile_trace.json"; // Chrome trace written by F2
+constexpr size_t PROFILE_CAPTURE_FRAMES = 120;
+
+/* Simulation Data */
+
+constexpr double SIM_STEP = 1.0 / 60.0; // Seconds of one simulation step, rendering blends between steps
+constexpr int SIM_MAX_STEPS = 5;        // Steps a frame may run to catch up, the rest of a stall is dropped
+constexpr int SWAP_INTERVAL = 1;        // 0: render uncapped, 1: at the display rate
+
+/* Pacing Data */
+
+constexpr bool LOW_LATENCY = false; // Start in low latency mode (F4 toggles), see frame_manager
+
+/* Allocation Data */
+
+constexpr size_t HEAP_WARMUP_FRAMES = 120; // Frames before the loop is expected to stop allocating
+
+/* Streaming Data */
+
+constexpr size_t TEXTURE_BUDGET = 256 * 1024 * 1024; // Bytes of texture mips resident in VRAM
+
 /* Game Data */
 
 std::vector<object*> objects;
@@ -38,6 +85,10 @@ player main_player = player();
 double deltaTime = 0.0;
 double lastFrame = 0.0;
 
+size_t frameCount = 0;
+uint64_t frameAllocations = 0; // Heap allocations the main thread made in the last frame
+size_t allocatingFrames = 0;   // Frames after the warm up that allocated
+
 /* Call Backs */
 
 static void resize_callback(GLFWwindow* window, int width, int height);
@@ -57,7 +108,66 @@ MessageCallback(
     const void* userParam
 );
 
-int main(void) {
+int main(int argc, char** argv) {
+    /* Offline import: Engine --import <file.obj> <file.cmesh> */
+    if (argc == 4 && strcmp(argv[1], "--import") == 0) {
+        std::string base_dir = std::filesystem::path(argv[2]).parent_path().generic_string();
+
+        return import_obj_streaming(base_dir.c_str(), argv[2], argv[3]) ? 0 : 1;
+    }
+
+    /* Self tests: Engine --test */
+    if (argc == 2 && strcmp(argv[1], "--test") == 0) {
+        return run_tests();
+    }
+
+    /* Headless benchmark: Engine --benchmark <scene> [frames] [results.json] [gl_trace.bin] */
+    if (argc >= 3 && argc <= 6 && strcmp(argv[1], "--benchmark") == 0) {
+        benchmark_options options;
+        options.scene = argv[2];
+
+        if (argc >= 4) { options.frames = strtoul(argv[3], nullptr, 10); }
+        if (argc >= 5) { options.output = argv[4]; }
+        if (argc >= 6) { options.gl_trace = argv[5]; }
+
+        return run_benchmark(options);
+    }
+
+    /* Uniform streaming: Engine --benchmark-uploads [blocks per frame] [frames] */
+    if (argc >= 2 && argc <= 4 && strcmp(argv[1], "--benchmark-uploads") == 0) {
+        size_t blocks = argc >= 3 ? strtoul(argv[2], nullptr, 10) : 10000;
+        size_t frames = argc >= 4 ? strtoul(argv[3], nullptr, 10) : 300;
+
+        return run_upload_benchmark(blocks, frames);
+    }
+
+    /* GL traces: Engine --gl-replay <trace>, Engine --gl-trace-stats <trace> [<trace to compare>] */
+    if (argc == 3 && strcmp(argv[1], "--gl-replay") == 0) {
+        return run_gl_replay(argv[2]);
+    }
+
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--gl-trace-stats") == 0) {
+        gl_trace_report before, after;
+
+        if (!analyze_gl_trace(argv[2], before) || (argc == 4 && !analyze_gl_trace(argv[3], after)))
+            return 1;
+
+        if (argc == 4) {
+            log_gl_trace_diff(before, after);
+        }
+        else {
+            log_gl_trace_report(before);
+        }
+
+        return 0;
+    }
+
+    /* Traced run: Engine --gl-trace <trace> */
+    const char* gl_trace_path = argc == 3 && strcmp(argv[1], "--gl-trace") == 0 ? argv[2] : nullptr;
+
+    /* Variant recording: Engine --record-variants, plays normally and writes OBJECT_VARIANTS on exit */
+    bool record_variants = argc == 2 && strcmp(argv[1], "--record-variants") == 0;
+
     /* Initialize GLFW */
     if (!glfwInit())
         return 1;
@@ -76,8 +186,13 @@ int main(void) {
     /* Initialize GLFW */
     glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_HIDDEN);
     glfwMakeContextCurrent(window);
+    glfwSwapInterval(SWAP_INTERVAL);
     glewInit();
 
+    if (gl_trace_path) {
+        gl_trace::start(gl_trace_path);
+    }
+
     /* Callbacks */
     glfwSetFramebufferSizeCallback(window, resize_callback);
 	glfwSetKeyCallback(window, key_callback);
@@ -85,42 +200,91 @@ int main(void) {
 	glfwSetCursorPosCallback(window, mouse_callback);
 	glDebugMessageCallback(MessageCallback, 0);
 
+    /* Transient per frame memory and CPU/GPU pacing */
+    frame_arena::init();
+    frame_manager::init(FRAMES_IN_FLIGHT, LOW_LATENCY);
+
+    /* Per draw uniform blocks, written into persistently mapped memory */
+    stream_buffer* uniform_stream = new stream_buffer(GL_UNIFORM_BUFFER, DRAW_STREAM_BYTES);
+    render_3d_component::uniformStream = uniform_stream;
+
+    /* Shader Hot Reload */
+    asset_watcher shader_watcher = asset_watcher("src/shaders");
+
+    /* Texture Streaming */
+    texture_streamer streamer = texture_streamer(TEXTURE_BUDGET);
+    render_3d_component::streamer = &streamer;
+
     /* Objects */
     main_camera.m_transform->position = glm::vec3(0.0f, 0.0f, 10.0f);
     objects.push_back(&main_camera);
 
-    shader* object_shader = new shader();
-    object_shader->add(GL_VERTEX_SHADER, "src/shaders/loaded_obj_vertex_shader.glsl");
-    object_shader->add(GL_FRAGMENT_SHADER, "src/shaders/loaded_obj_fragment_shader.glsl");
-    object_shader->link();
+    double shader_start = glfwGetTime();
+
+    shader_variants object_variants = shader_variants("loaded_obj");
+    object_variants.add(GL_VERTEX_SHADER, "src/shaders/loaded_obj_vertex_shader.glsl", loaded_obj::layout::defines());
+    object_variants.add(GL_FRAGMENT_SHADER, "src/shaders/loaded_obj_fragment_shader.glsl");
+
+    const uint32_t TEXTURED = object_variants.keyword("TEXTURED");
+    const uint32_t LIT = object_variants.keyword("LIT");
+
+    shader* sprite_shader = new shader();
+    sprite_shader->add(GL_VERTEX_SHADER, "src/shaders/sprite_vertex_shader.glsl", sprite_batch::layout::defines());
+    sprite_shader->add(GL_FRAGMENT_SHADER, "src/shaders/sprite_fragment_shader.glsl");
 
-    shader* crosshair_shader = new shader();
-    crosshair_shader->add(GL_VERTEX_SHADER, "src/shaders/crosshair_vertex_shader.glsl");
-    crosshair_shader->add(GL_FRAGMENT_SHADER, "src/shaders/crosshair_fragment_shader.glsl");
-    crosshair_shader->link();
+    // Compile every program in the background while the objects load
+    shader_batch shaders = shader_batch();
 
-    crosshair cross = crosshair(crosshair_shader);
-    objects.push_back(&cross);
+#ifndef _DEBUG
+    // Shipping builds only compile the variants recorded by --record-variants
+    if (!record_variants && object_variants.load_manifest(OBJECT_VARIANTS)) {
+        object_variants.prewarm(shaders);
+    }
+#endif
+
+    shader* object_shader = object_variants.create(TEXTURED | LIT);
+    shaders.add(object_shader);
+
+    shaders.add(sprite_shader);
+    shaders.submit();
 
-    earth planet = earth(object_shader);
-    objects.push_back(&planet);
+    /* 2D, every render_2d_component draws through the sprite batch */
+    sprite_batch::init(sprite_shader);
 
-    planet.m_transform->scale = glm::vec3(0.25f);
+    // Pooled (see pool.hpp), deleted before the context goes away
+    crosshair* cross = new crosshair();
+    objects.push_back(cross);
 
-    cube bricks = cube(object_shader);
-    objects.push_back(&bricks);
+    earth* planet = new earth(object_shader);
+    objects.push_back(planet);
 
-    bricks.m_transform->position = glm::vec3(0.0, 5.0, 0.0);
+    planet->m_transform->scale = glm::vec3(0.25f);
+
+    cube* bricks = new cube(object_shader);
+    objects.push_back(bricks);
+
+    bricks->m_transform->position = glm::vec3(0.0, 5.0, 0.0);
 
 	/* Initialize objects */
 	for (object* obj : objects) {
         if (!obj->init()) {
-			puts(RED("Failed to init objects").c_str());
+			LOG_ERROR(CORE, "Failed to init objects");
 
 			return 1;
 		}
+
+        LOG_DEBUG(CORE, "%zu shader(s) still compiling", shaders.poll());
 	}
 
+    /* Collect the compile results */
+    if (!shaders.finish()) {
+        LOG_ERROR(CORE, "Failed to link shaders");
+
+        return 1;
+    }
+
+    LOG_INFO(CORE, "Shaders ready in %.2f ms", (glfwGetTime() - shader_start) * 1000.0);
+
     /* Loop until the user closes the window */
     glEnable(GL_DEPTH_TEST);
 	glEnable(GL_DEBUG_OUTPUT);
@@ -129,43 +293,122 @@ int main(void) {
     glm::mat4 projection = glm::identity<glm::mat4>();
     glm::mat4 vp = glm::identity<glm::mat4>();
 
+    profiler::set_thread_name("Main");
+
+    uint64_t heapMark = heap_stats::thread_allocations();
+
+    fixed_clock simClock = fixed_clock(SIM_STEP, SIM_MAX_STEPS);
+    lastFrame = glfwGetTime(); // Loading is not simulated time
+
     while (!glfwWindowShouldClose(window)) {
 		auto start = glfwGetTime();
 
+		/* Steady state frames must not touch the heap */
+		uint64_t heapNow = heap_stats::thread_allocations();
+		frameAllocations = heapNow - heapMark;
+		heapMark = heapNow;
+
+		if (++frameCount > HEAP_WARMUP_FRAMES && frameAllocations > 0 && allocatingFrames++ == 0) {
+			LOG_WARNING(CORE, "Frame %zu made %llu heap allocations, steady state frames should make none", frameCount, (unsigned long long)frameAllocations);
+		}
+
+        PROFILE_FRAME();
+        PROFILE_SCOPE("Frame");
+
+        gl_trace::end_frame();
+
+        /* Wait for the GPU to free this frame's slot, before input is sampled */
+        frame_manager::begin_frame();
+
         /* Poll for and process events */
-        glfwPollEvents();
+        {
+            PROFILE_SCOPE("Events");
+            glfwPollEvents();
+        }
 
 		/* Handle minimized window */
         if (glfwGetWindowAttrib(window, GLFW_ICONIFIED) != 0) { continue; }
 
+		/* Swap in hot reloaded shaders before anything is drawn this frame */
+		{
+			PROFILE_SCOPE("Shader reload");
+
+			std::vector<std::string> changed = shader_watcher.poll();
+			if (!changed.empty()) {
+				shader::reloadChanged(changed);
+			}
+		}
+
+		/* Upload streamed mips and kick off the next streaming decisions */
+		{
+			PROFILE_SCOPE("Texture streaming");
+			streamer.update();
+		}
+
 		/* Render Main */
         glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // Player Movement
-        if (main_player.keys.w) { main_camera.m_transform->moveForward(main_player.movementSpeed, deltaTime); }
-        if (main_player.keys.s) { main_camera.m_transform->moveBackward(main_player.movementSpeed, deltaTime); }
-        if (main_player.keys.a) { main_camera.m_transform->moveLeft(main_player.movementSpeed, deltaTime); }
-        if (main_player.keys.d) { main_camera.m_transform->moveRight(main_player.movementSpeed, deltaTime); }
-        if (main_player.keys.space) { main_camera.m_transform->moveUp(main_player.movementSpeed, deltaTime); }
-        if (main_player.keys.shift) { main_camera.m_transform->moveDown(main_player.movementSpeed, deltaTime); }
+        /* Simulate in fixed steps */
+        {
+            PROFILE_SCOPE("Simulation");
+
+            int steps = simClock.advance(deltaTime);
+            float step = (float)SIM_STEP;
+
+            for (int i = 0; i < steps; ++i) {
+                for (object* obj : objects) {
+                    obj->fixedUpdate(step);
+                }
+
+                // Player Movement
+                if (main_player.keys.w) { main_camera.m_transform->moveForward(main_player.movementSpeed, step); }
+                if (main_player.keys.s) { main_camera.m_transform->moveBackward(main_player.movementSpeed, step); }
+                if (main_player.keys.a) { main_camera.m_transform->moveLeft(main_player.movementSpeed, step); }
+                if (main_player.keys.d) { main_camera.m_transform->moveRight(main_player.movementSpeed, step); }
+                if (main_player.keys.space) { main_camera.m_transform->moveUp(main_player.movementSpeed, step); }
+                if (main_player.keys.shift) { main_camera.m_transform->moveDown(main_player.movementSpeed, step); }
+            }
+
+            // Draw the transforms between the last two steps
+            transform_component::interpolation = simClock.alpha();
+        }
 
         /* Get the view and projection matrices */
 		view = main_camera.getViewMatrix();
         projection = glm::perspective(glm::radians(main_frustum.fovDegrees), (float)SCRN_WIDTH / (float)SCRN_HEIGHT, main_frustum.near_plane, main_frustum.far_plane);
         vp = projection * view;
 
-		for (object* obj : objects) {
+		{
+			PROFILE_GPU_SCOPE("Objects"); // Before the CPU scope, both are then Frame/Objects
+			PROFILE_SCOPE("Objects");
+
 			// Update render components static variables
 			render_3d_component::vp = vp;
-            render_3d_component::lightPos = glm::vec3(2.0f, 25.0f, 25.0f);
-            render_3d_component::cameraPos = main_camera.m_transform->position;
+			render_3d_component::lightPos = glm::vec3(2.0f, 25.0f, 25.0f);
+			render_3d_component::cameraPos = main_camera.m_transform->getInterpolatedPosition();
+			render_3d_component::fovDegrees = main_frustum.fovDegrees;
+			render_3d_component::screenHeight = (float)SCRN_HEIGHT;
+			render_3d_component::beginFrame();
+
+			for (object* obj : objects) {
+				obj->update(deltaTime);
+			}
+		}
 
-            obj->update(deltaTime);
+		/* HUD, the sprites the objects submitted */
+		{
+			PROFILE_GPU_SCOPE("Sprites");
+			sprite_batch::flush();
 		}
 
 		/* Swap front and back buffers */
-        glfwSwapBuffers(window);
+        frame_manager::end_frame();
+
+        {
+            PROFILE_SCOPE("Swap");
+            glfwSwapBuffers(window);
+        }
 
 		/* Calculate the delaTime */
         double currentFrame = glfwGetTime();
@@ -174,6 +417,32 @@ int main(void) {
 	} // Game Loop
 
 	/* Deinitialize objects */
+    if (record_variants) {
+        // The variants this session needed, the manifest strips the rest in shipping builds
+        object_variants.save_manifest(OBJECT_VARIANTS);
+    }
+
+    for (object* obj : objects) {
+        if (obj == &main_camera)
+            continue;
+
+        obj->deinit();
+        delete obj;
+    }
+
+    objects.clear();
+
+    render_3d_component::uniformStream = nullptr;
+    delete uniform_stream;
+
+    sprite_batch::shutdown();
+
+    frame_manager::shutdown();
+
+    gl_trace::stop();
+
+    frame_arena::shutdown();
+
     glfwDestroyWindow(window);
     glfwTerminate();
 
@@ -181,7 +450,7 @@ int main(void) {
 } // main
 
 static void glfw_error_callback(int error, const char* description) {
-    fprintf(stderr, "GLFW Error %d: %s\n", error, description);
+    LOG_ERROR(CORE, "GLFW Error %d: %s", error, description);
 }
 
 static GLchar* getErrorString(GLenum errorCode) {
@@ -209,10 +478,12 @@ MessageCallback(
 ) {
     if (source == GL_NO_ERROR) return;
 
-    fprintf(stderr, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s\n",
-        getErrorString(source),
-        type, severity, message
-    );
+    if (type == GL_DEBUG_TYPE_ERROR) {
+        LOG_ERROR(RENDER, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s", getErrorString(source), type, severity, message);
+    }
+    else {
+        LOG_DEBUG(RENDER, "GL CALLBACK: %s type = 0x%x, severity = 0x%x, message = %s", getErrorString(source), type, severity, message);
+    }
 }
 
 /**
@@ -233,6 +504,31 @@ static void key_callback(GLFWwindow* window, int key, int scancode, int action,
         glfwSetWindowShouldClose(window, true);
     }
 
+    // Profiler: F2 captures a trace, F3 logs the rolling statistics
+    if (action == GLFW_PRESS && key == GLFW_KEY_F2) {
+        profiler::capture(PROFILE_CAPTURE_FRAMES, PROFILE_TRACE);
+    }
+
+    if (action == GLFW_PRESS && key == GLFW_KEY_F3) {
+        profiler::log_stats();
+
+        LOG_INFO(CORE, "Heap: %llu allocations last frame, %zu allocating frames after warm up; frame arena: peak %zu bytes, %zu overflows",
+            (unsigned long long)frameAllocations, allocatingFrames, frame_arena::peak(), frame_arena::overflows());
+        memory_tracker::log_report();
+
+        LOG_INFO(CORE, "Frames in flight: %zu%s, last GPU wait %.3f ms", frame_manager::frames_in_flight(),
+            frame_manager::low_latency() ? " (low latency)" : "", frame_manager::wait_ms());
+
+        LOG_INFO(CORE, "Sprites: %zu in %zu draw(s) last frame", sprite_batch::sprites(), sprite_batch::draws());
+    }
+
+    // F4 toggles low latency mode (the CPU waits for the previous frame before sampling input)
+    if (action == GLFW_PRESS && key == GLFW_KEY_F4) {
+        frame_manager::set_low_latency(!frame_manager::low_latency());
+
+        LOG_INFO(CORE, "Low latency mode %s", frame_manager::low_latency() ? "on" : "off");
+    }
+
 	// Player Movement
     main_player.keys.w = glfwGetKey(window, GLFW_KEY_W);
     main_player.keys.s = glfwGetKey(window, GLFW_KEY_S);
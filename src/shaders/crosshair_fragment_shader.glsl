@@ -1,7 +0,0 @@
-#version 460 core
-
-out vec4 outcolor;
-
-void main(void) {
-  outcolor = vec4(1.0f, 1.0f, 1.0f, 0.5f);
-}
\ No newline at end of file
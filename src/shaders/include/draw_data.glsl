@@ -0,0 +1,17 @@
+#pragma once
+
+// Per draw values, a range of the renderer's stream buffer (must match draw_data in draw_data.hpp)
+layout(std140, binding = 0) uniform draw_data {
+	mat4 model;
+	vec3 pos_scale; // Quantized positions: snorm16 relative to the mesh bounding box
+	float ambient_strength;
+	vec3 pos_offset;
+	float specular_strength;
+};
+
+// Per frame values, bound once before the objects draw (must match frame_data in draw_data.hpp)
+layout(std140, binding = 1) uniform frame_data {
+	mat4 vp;
+	vec3 light_pos;
+	vec3 view_pos;
+};
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "draw_data.glsl"
+
+// Phong lighting of a surface point with a single point light
+vec3 phong_lighting(vec3 frag_pos, vec3 frag_normal, vec3 color) {
+	// Ambient
+	vec3 ambient = ambient_strength * color;
+
+	// Diffuse
+	vec3 normal = normalize(frag_normal);
+	vec3 light_dir = normalize(light_pos - frag_pos);
+	float diff = max(dot(normal, light_dir), 0.0);
+	vec3 diffuse = diff * color;
+
+	// Specular
+	vec3 view_dir = normalize(view_pos - frag_pos);
+	vec3 reflect_dir = reflect(-light_dir, normal);
+	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 32);
+	vec3 specular = specular_strength * spec * color;
+
+	return ambient + diffuse + specular;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "draw_data.glsl" // pos_scale, pos_offset
+
+// Octahedral encoded unit vector
+vec3 oct_decode(vec2 e) {
+	vec3 n = vec3(e.x, e.y, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += mix(vec2(t), vec2(-t), greaterThanEqual(n.xy, vec2(0.0)));
+	return normalize(n);
+}
+
+// Tangent frame packed by tangent_encode (vertex.hpp): xyz the unit tangent, w the bitangent handedness
+vec4 tangent_decode(vec3 normal, float code) {
+	const float min_code = 1.0 / 32767.0;
+
+	vec3 n = normalize(normal);
+	vec3 b1 = cross(vec3(0.348, 0.815, 0.463), n);
+	b1 = dot(b1, b1) > 1e-12 ? normalize(b1) : normalize(cross(vec3(1.0, 0.0, 0.0), n));
+	vec3 b2 = cross(n, b1);
+
+	float angle = (max(abs(code), min_code) - min_code) / (1.0 - min_code) * 6.28318530718;
+	return vec4(b1 * cos(angle) + b2 * sin(angle), code < 0.0 ? -1.0 : 1.0);
+}
@@ -1,5 +1,9 @@
 #version 460 core
 
+// Keywords: LIT, TEXTURED (see shader_variants)
+
+#include "include/lighting.glsl"
+
 in vec3 frag_pos;
 in vec3 frag_color;
 in vec2 frag_texCoord;
@@ -8,32 +12,21 @@ in vec3 frag_normal;
 in float frag_ambient;
 
 uniform sampler2D tex;
-uniform float ambient_strength;
-uniform float specular_strength;
-uniform vec3 light_pos;
-uniform vec3 view_pos;
 
 out vec4 out_color;
 
 void main(void) {
-	// Ambient
-	vec3 ambient = ambient_strength * frag_color;
-	
-	// Diffuse
-	vec3 normal = normalize(frag_normal);
-	vec3 light_dir = normalize(light_pos - frag_pos);
-	float diff = max(dot(normal, light_dir), 0.0);
-	vec3 diffuse = diff * frag_color;
-
-	// Specular
-	vec3 view_dir = normalize(view_pos - frag_pos);
-	vec3 reflect_dir = reflect(-light_dir, normal);
-	float spec = pow(max(dot(view_dir, reflect_dir), 0.0), 32);
-	vec3 specular = specular_strength * spec * frag_color;
-
-	vec3 result = ambient + diffuse + specular;
-
-	out_color = vec4(result, 1.0) * texture(tex, frag_texCoord) * vec4(frag_color, 1.0);
+#ifdef LIT
+	vec3 result = phong_lighting(frag_pos, frag_normal, frag_color);
+#else
+	vec3 result = frag_color;
+#endif
+
+	out_color = vec4(result, 1.0) * vec4(frag_color, 1.0);
+
+#ifdef TEXTURED
+	out_color *= texture(tex, frag_texCoord);
+#endif
 
 	if(out_color.a < 0.1)
 		discard;
@@ -1,12 +1,8 @@
 #version 460 core
 
-in vec3 in_vertex;
-in vec3 in_color;
-in vec2 in_texCoord;
-in vec3 in_normal;
+#include "include/vertex_decode.glsl" // Also the draw_data and frame_data blocks
 
-uniform mat4 model;
-uniform mat4 vp;
+VERTEX_INPUTS // Declared by the mesh vertex layout
 
 out vec3 frag_pos;
 out vec3 frag_color;
@@ -14,11 +10,15 @@ out vec2 frag_texCoord;
 out vec3 frag_normal;
 
 void main(void) {
-	frag_pos = vec3(model * vec4(in_vertex, 1.0));
+	frag_pos = vec3(model * vec4(LOAD_VERTEX, 1.0));
 
-	frag_color = in_color;
-	frag_texCoord = in_texCoord;
-	frag_normal = mat3(transpose(inverse(model))) * in_normal; // TODO: calculate the normal matrix for scaled (and apparently roatated) models on the CPU and send it to the shaders via a uniform before drawing (just like the model matrix).
+#ifdef HAS_COLOR
+	frag_color = LOAD_COLOR;
+#else
+	frag_color = vec3(1.0);
+#endif
+	frag_texCoord = LOAD_TEXCOORD;
+	frag_normal = mat3(transpose(inverse(model))) * LOAD_NORMAL; // TODO: calculate the normal matrix for scaled (and apparently roatated) models on the CPU and send it to the shaders via a uniform before drawing (just like the model matrix).
 
 	gl_Position = vp * vec4(frag_pos, 1.0); // mvp is reveresed because matrix mult
 }
\ No newline at end of file
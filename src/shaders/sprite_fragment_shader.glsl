@@ -0,0 +1,15 @@
+#version 460 core
+
+in vec2 frag_texCoord;
+in vec4 frag_color;
+
+uniform sampler2D tex; // White texel for untextured sprites
+
+out vec4 out_color;
+
+void main(void) {
+	out_color = texture(tex, frag_texCoord) * frag_color;
+
+	if (out_color.a < 0.01)
+		discard;
+}
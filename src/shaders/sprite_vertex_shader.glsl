@@ -0,0 +1,15 @@
+#version 460 core
+
+VERTEX_INPUTS // Declared by sprite_batch::layout
+
+uniform mat4 projection;
+
+out vec2 frag_texCoord;
+out vec4 frag_color;
+
+void main(void) {
+	frag_texCoord = LOAD_TEXCOORD;
+	frag_color = in_color; // All four channels, LOAD_COLOR drops alpha
+
+	gl_Position = projection * vec4(LOAD_VERTEX, 1.0);
+}
@@ -0,0 +1,272 @@
+#include <glm/glm.hpp>
+#include "gl.hpp"
+#include <cstdint>
+#include <vector>
+
+#include "log.hpp"
+#include "vertex.hpp"
+#include "vertex_layout.hpp"
+#include "mesh_normals.hpp"
+#include "sprite_batch.hpp"
+
+#include "tests.hpp"
+
+constexpr int TEST_NORMALS = 4096;             // Fibonacci sphere directions, on top of the axes and octahedron edges
+constexpr float FLOAT_MAX_DEGREES = 1e-4f;     // Float normals only lose the rounding of normalize
+constexpr float OCT16_MAX_DEGREES = 0.01f;     // 16-bit octahedral normals are good to about 0.005 degrees
+constexpr float HALF_MAX_ERROR = 1.0f / 2048;  // Half float spacing just below 1, above the worst rounding of a [0, 1] pair
+constexpr float UNORM8_MAX_ERROR = 1.0f / 255;
+constexpr float UNORM16_MAX_ERROR = 1.0f / 65535;
+constexpr float TANGENT_MAX_DEGREES = 0.01f;   // Half a snorm16 step of the tangent angle is 0.0055 degrees
+
+static size_t failures = 0;
+static size_t checks = 0;
+
+static void expect_error(const char* layout, const char* attribute, float error, float bound) {
+	++checks;
+
+	if (error <= bound) {
+		LOG_DEBUG(CORE, "%s %s: max error %g (bound %g)", layout, attribute, error, bound);
+		return;
+	}
+
+	LOG_ERROR(CORE, "%s %s: max error %g above %g", layout, attribute, error, bound);
+	++failures;
+}
+
+/**
+* @brief Vertices covering the bounds corners, every octant of normals and texcoords on [0, 1]
+*/
+static std::vector<vertex> test_vertices(const glm::vec3& min, const glm::vec3& max) {
+	std::vector<glm::vec3> normals = {
+		{ 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 },
+		{ 1, 1, 0 }, { -1, 1, 0 }, { 1, -1, 0 }, { -1, -1, 0 }, // The fold of the octahedral map
+		{ 1, 1, -1 }, { -1, -1, -1 }, { 0.5f, 3, 0 }
+	};
+
+	// Fibonacci sphere, evenly spread directions
+	for (int i = 0; i < TEST_NORMALS; ++i) {
+		float z = 1.0f - 2.0f * (i + 0.5f) / TEST_NORMALS;
+		float r = glm::sqrt(1.0f - z * z);
+		float phi = i * 2.39996323f;
+
+		normals.push_back(glm::vec3(r * glm::cos(phi), r * glm::sin(phi), z));
+	}
+
+	std::vector<vertex> vertices(normals.size());
+	uint32_t seed = 1;
+
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		vertex& v = vertices[i];
+
+		seed = seed * 1664525u + 1013904223u; // LCG, the same vertices every run
+		glm::vec3 t = glm::vec3((seed >> 8) & 0xFF, (seed >> 16) & 0xFF, (seed >> 24) & 0xFF) / 255.0f;
+
+		// The first eight sit on the corners of the bounds
+		if (i < 8) {
+			t = glm::vec3(i & 1, (i >> 1) & 1, (i >> 2) & 1);
+		}
+
+		v.m_pos = glm::mix(min, max, t);
+		v.m_color = glm::vec3(t.z, t.x, t.y) * 0.9f + 0.05f; // Off the 8-bit grid
+		v.m_texCoord = glm::vec2(t.x, t.y);
+		v.m_normal = normals[i] * (1.0f + t.z); // Not normalized, the encoder must do it
+		v.m_tangent = tangent_encode(v.m_normal, glm::vec3(t.y, t.z, t.x) - 0.5f, i & 1 ? -1.0f : 1.0f);
+	}
+
+	return vertices;
+}
+
+template<typename Layout>
+static vertex_error round_trip(const std::vector<vertex>& vertices, const vertex_encoding& enc) {
+	std::vector<unsigned char> packed(vertices.size() * Layout::stride);
+	Layout::pack(vertices.data(), vertices.size(), enc, packed.data());
+
+	return Layout::error(vertices.data(), vertices.size(), enc, packed.data());
+}
+
+static float at(const vertex_error& error, vertex_attr semantic) {
+	return error[(size_t)semantic];
+}
+
+static void test_vertex_layouts() {
+	const glm::vec3 min = glm::vec3(-3.0f, 0.0f, -0.25f);
+	const glm::vec3 max = glm::vec3(5.0f, 2.0f, 0.25f);
+
+	std::vector<vertex> vertices = test_vertices(min, max);
+
+	// What mesh::compute_bounds chooses
+	vertex_encoding enc;
+	enc.offset = (min + max) * 0.5f;
+	enc.scale = (max - min) * 0.5f;
+
+	// Half a snorm16 step on every axis
+	float position_bound = glm::length(enc.scale) * 0.5f / 32767.0f;
+
+	/* Float layouts are exact, up to normalizing the normals */
+	vertex_error full = round_trip<vertex_layout_full>(vertices, enc);
+	expect_error("full", "position", at(full, vertex_attr::VERTEX), 0.0f);
+	expect_error("full", "color", at(full, vertex_attr::COLOR), 0.0f);
+	expect_error("full", "normal (degrees)", at(full, vertex_attr::NORMAL), FLOAT_MAX_DEGREES);
+	expect_error("full", "texcoord", at(full, vertex_attr::TEXCOORD), 0.0f);
+	expect_error("full", "tangent (degrees)", at(full, vertex_attr::TANGENT), 0.0f);
+
+	vertex_error pnt = round_trip<vertex_layout_pnt>(vertices, enc);
+	expect_error("pnt", "position", at(pnt, vertex_attr::VERTEX), 0.0f);
+	expect_error("pnt", "normal (degrees)", at(pnt, vertex_attr::NORMAL), FLOAT_MAX_DEGREES);
+	expect_error("pnt", "texcoord", at(pnt, vertex_attr::TEXCOORD), 0.0f);
+
+	/* Quantized, the colour has to be uniform for the CONSTANT attribute */
+	std::vector<vertex> white = vertices;
+
+	for (vertex& v : white) {
+		v.m_color = glm::vec3(1.0f);
+	}
+
+	vertex_encoding constant_enc = enc;
+	constant_enc.constants[(size_t)vertex_attr::COLOR] = glm::vec4(1.0f);
+
+	vertex_error quantized = round_trip<vertex_layout_quantized>(white, constant_enc);
+	expect_error("quantized", "position", at(quantized, vertex_attr::VERTEX), position_bound);
+	expect_error("quantized", "color", at(quantized, vertex_attr::COLOR), 0.0f);
+	expect_error("quantized", "normal (degrees)", at(quantized, vertex_attr::NORMAL), OCT16_MAX_DEGREES);
+	expect_error("quantized", "texcoord", at(quantized, vertex_attr::TEXCOORD), HALF_MAX_ERROR);
+	expect_error("quantized", "tangent (degrees)", at(quantized, vertex_attr::TANGENT), TANGENT_MAX_DEGREES);
+
+	// A colour that is not uniform must show up in the error, that is what makes mesh::choose_constants fall back
+	vertex_error varying = round_trip<vertex_layout_quantized>(vertices, constant_enc);
+	++checks;
+
+	if (at(varying, vertex_attr::COLOR) < 0.5f) {
+		LOG_ERROR(CORE, "quantized color: a varying colour measured %g, the round trip does not see it", at(varying, vertex_attr::COLOR));
+		++failures;
+	}
+
+	vertex_error quantized_color = round_trip<vertex_layout_quantized_color>(vertices, enc);
+	expect_error("quantized_color", "position", at(quantized_color, vertex_attr::VERTEX), position_bound);
+	expect_error("quantized_color", "color", at(quantized_color, vertex_attr::COLOR), UNORM8_MAX_ERROR);
+	expect_error("quantized_color", "normal (degrees)", at(quantized_color, vertex_attr::NORMAL), OCT16_MAX_DEGREES);
+	expect_error("quantized_color", "texcoord", at(quantized_color, vertex_attr::TEXCOORD), HALF_MAX_ERROR);
+	expect_error("quantized_color", "tangent (degrees)", at(quantized_color, vertex_attr::TANGENT), TANGENT_MAX_DEGREES);
+
+	/* Sprites, vertices are written by sprite_batch itself but the traits must agree */
+	vertex_error sprites = round_trip<sprite_batch::layout>(vertices, enc);
+	expect_error("sprite", "position", at(sprites, vertex_attr::VERTEX), 0.0f);
+	expect_error("sprite", "texcoord", at(sprites, vertex_attr::TEXCOORD), UNORM16_MAX_ERROR);
+	expect_error("sprite", "color", at(sprites, vertex_attr::COLOR), UNORM8_MAX_ERROR);
+} // test_vertex_layouts
+
+/**
+* @brief A flat strip whose left half mirrors the texture: tangents follow +u on both sides, the seam is split
+*/
+static void test_tangents() {
+	const int columns = 4; // Per half
+	const int rows = 2;
+
+	std::vector<vertex> vertices;
+	std::vector<uint32_t> indices;
+
+	for (int y = 0; y <= rows; ++y) {
+		for (int x = -columns; x <= columns; ++x) {
+			vertex v;
+			v.m_pos = glm::vec3((float)x, (float)y, 0.0f);
+			v.m_normal = glm::vec3(0.0f, 0.0f, 1.0f);
+			v.m_texCoord = glm::vec2(glm::abs((float)x), (float)y) / (float)columns;
+
+			vertices.push_back(v);
+		}
+	}
+
+	const uint32_t stride = 2 * columns + 1;
+
+	for (uint32_t y = 0; y < rows; ++y) {
+		for (uint32_t x = 0; x < stride - 1; ++x) {
+			uint32_t i = y * stride + x;
+			const uint32_t quad[] = { i, i + 1, i + stride + 1, i, i + stride + 1, i + stride };
+
+			indices.insert(indices.end(), std::begin(quad), std::end(quad));
+		}
+	}
+
+	size_t original = vertices.size();
+	generate_tangents(vertices, indices);
+
+	++checks;
+	if (vertices.size() != original + rows + 1) {
+		LOG_ERROR(CORE, "tangents: %zu vertices added at the mirror seam, expected %d", vertices.size() - original, rows + 1);
+		++failures;
+	}
+
+	// Every corner must see the tangent of its own half: +x, right handed on the right, -x, left handed on the left
+	float worst = 0.0f;
+
+	for (size_t c = 0; c < indices.size(); ++c) {
+		size_t triangle = c / 3;
+		bool mirrored = (triangle / 2) % (stride - 1) < (uint32_t)columns;
+
+		const vertex& v = vertices[indices[c]];
+		glm::vec4 frame = tangent_decode(v.m_normal, v.m_tangent);
+		glm::vec3 expected = glm::vec3(mirrored ? -1.0f : 1.0f, 0.0f, 0.0f);
+
+		float degrees = frame.w != (mirrored ? -1.0f : 1.0f) ? 180.0f :
+			glm::degrees(glm::atan(glm::length(glm::cross(glm::vec3(frame), expected)), glm::dot(glm::vec3(frame), expected)));
+
+		worst = glm::max(worst, degrees);
+	}
+
+	expect_error("tangents", "mirrored strip (degrees)", worst, FLOAT_MAX_DEGREES * 10.0f);
+} // test_tangents
+
+static float degrees_between(const glm::vec3& a, const glm::vec3& b) {
+	return glm::degrees(glm::atan(glm::length(glm::cross(a, b)), glm::dot(a, b)));
+}
+
+/**
+* @brief The faces of a cube corner stay hard, two faces of a shallow ridge share one normal
+*/
+static void test_normal_clusters() {
+	float cos_crease = glm::cos(glm::radians(DEFAULT_CREASE_ANGLE));
+
+	const glm::vec3 cube[] = { glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) };
+	normal_clusters corner = {};
+
+	for (const glm::vec3& face : cube) {
+		corner.add(face, glm::half_pi<float>(), cos_crease);
+	}
+
+	float worst = 0.0f;
+	for (const glm::vec3& face : cube) {
+		worst = glm::max(worst, degrees_between(corner.normal(face), face));
+	}
+
+	expect_error("normal clusters", "cube corner (degrees)", worst, FLOAT_MAX_DEGREES);
+
+	// 30 degrees apart, the wider corner weighs twice as much
+	glm::vec3 left = glm::vec3(-glm::sin(glm::radians(15.0f)), 0.0f, glm::cos(glm::radians(15.0f)));
+	glm::vec3 right = glm::vec3(-left.x, 0.0f, left.z);
+	glm::vec3 expected = glm::normalize(left * 2.0f + right);
+
+	normal_clusters ridge = {};
+	ridge.add(left, 2.0f, cos_crease);
+	ridge.add(right, 1.0f, cos_crease);
+
+	worst = glm::max(degrees_between(ridge.normal(left), expected), degrees_between(ridge.normal(right), expected));
+	expect_error("normal clusters", "shallow ridge (degrees)", worst, FLOAT_MAX_DEGREES);
+} // test_normal_clusters
+
+int run_tests() {
+	test_vertex_layouts();
+	test_tangents();
+	test_normal_clusters();
+
+	if (failures) {
+		LOG_ERROR(CORE, "%zu of %zu checks failed", failures, checks);
+	}
+	else {
+		LOG_INFO(CORE, "All %zu checks passed", checks);
+	}
+
+	logger::flush();
+
+	return failures ? 1 : 0;
+} // run_tests
@@ -0,0 +1,17 @@
+#ifndef _TESTS_HPP
+#define _TESTS_HPP
+
+/**
+ * Run the engine's CPU self tests, no window or GL context needed
+ *
+ * The vertex layout round trip: every layout packs a fixed set of
+ * vertices and each attribute must decode within the error bound of its format.
+ * Then tangent generation on a strip with a mirrored UV seam and the crease
+ * handling of the streamed import's normal clusters. Every failed check is logged
+ * as an error.
+ *
+ * @return int Process exit code, 0 if every check passed
+ */
+int run_tests();
+
+#endif // _TESTS_HPP